@@ -27,11 +27,8 @@
  * The are used to output informative text (as a printf).
  */
 
-#include <time.h>
-#include <sys/types.h>
- 
-/* We use a mutex to avoid conflicts in traces */
-static pthread_mutex_t m_trace = PTHREAD_MUTEX_INITIALIZER;
+/* The lines go through per-thread buffers, written in batches (see tracebuf.h) */
+#include "tracebuf.h"
 
 /*****************************************************************************************/
 /******************************* stdout module *****************************************/
@@ -40,31 +37,19 @@ static pthread_mutex_t m_trace = PTHREAD_MUTEX_INITIALIZER;
 #if (1)
 void output_init()
 {
-	/* do nothing */
+	tb_init();
 	return;
 }
 void output( char * string, ... )
 {
    va_list ap;
-   char *ts="[??:??:??]";
-   struct tm * now;
-   time_t nw;
-
-   pthread_mutex_lock(&m_trace);
-   nw = time(NULL);
-   now = localtime(&nw);
-   if (now == NULL)
-      printf(ts);
-   else
-      printf("[%2.2d:%2.2d:%2.2d]", now->tm_hour, now->tm_min, now->tm_sec);
    va_start( ap, string);
-   vprintf(string, ap);
+   tb_log(string, ap);
    va_end(ap);
-   pthread_mutex_unlock(&m_trace);
 }
 void output_fini()
 {
-	/*do nothing */
+	tb_flush();
 	return;
 }
 #endif
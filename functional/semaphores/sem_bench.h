@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * The benchmark mode of the semaphore functional tests.  With -b, a test
+ * runs its synchronization problem as fast as it can, without printing
+ * or sleeping, and reports, for each role (producer, reader, barber...):
+ * the operations done, per second, the fairness (the fewest operations
+ * done by a worker over the most), and the time spent in sem_wait (p50,
+ * p99 and max):
+ *
+ *	$ ./sem_conpro.test -b -t 4 -d 2000
+ *
+ *  -b       run the benchmark rather than the functional test
+ *  -t n     workers per role (the default depends on the test)
+ *  -i n     stop after n operations in all (default: no limit; the
+ *           workers then count them in one shared counter)
+ *  -d ms    stop after that long (default 1000)
+ *
+ * A test sets up its workers and its semaphores, then:
+ *
+ *	w = sb_setup(nworkers);		(shared with forked workers too)
+ *	w[i].role = ...;
+ *	sb_start();
+ *	... start the workers ...
+ *	sb_run(sems, nsems);
+ *	... join the workers ...
+ *	sb_report(role_names, nroles);
+ *
+ * and each worker takes its semaphores with sb_wait(), which returns 1
+ * once the run is over, and counts its operations with sb_op().  At the
+ * end, the semaphores are posted once for each worker: every worker
+ * blocked in sb_wait() returns, and leaves.
+ *
+ * Without -b, sb_wait() is sem_wait(), again when interrupted, and the
+ * test runs as it always did.
+ *
+ * Everything is in this header, as the tests are built from one file.
+ */
+
+#ifndef SEM_BENCH_H
+#define SEM_BENCH_H
+
+#include <errno.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "measure.h"
+
+#define SB_POLL_MS	10
+
+struct sb_worker {
+	unsigned long ops;
+	int role;
+	struct mes_hist wait;	/* ns spent in sem_wait */
+};
+
+static struct {
+	int bench;
+	long threads;
+	long iterations;
+	long duration_ms;
+} sb_opt = { 0, 0, 0, 1000 };
+
+/* In a shared mapping, for the workers which are processes */
+static struct sb_shared {
+	volatile int stop;
+	struct timespec t1;	/* when the run was stopped */
+	unsigned long ops;	/* with -i */
+	long nworkers;
+	struct sb_worker w[];
+} *sb;
+static struct timespec sb_t0;
+
+/* Returns -1 if the options are not understood */
+static int sb_getopt(int argc, char *argv[], long threads)
+{
+	int c;
+
+	sb_opt.threads = threads;
+	while ((c = getopt(argc, argv, "bt:i:d:")) != -1) {
+		switch (c) {
+		case 'b':
+			sb_opt.bench = 1;
+			break;
+		case 't':
+			sb_opt.threads = atol(optarg);
+			break;
+		case 'i':
+			sb_opt.iterations = atol(optarg);
+			break;
+		case 'd':
+			sb_opt.duration_ms = atol(optarg);
+			break;
+		default:
+			return -1;
+		}
+	}
+	if (sb_opt.threads < 1 || sb_opt.iterations < 0 ||
+	    sb_opt.duration_ms < 1) {
+		fprintf(stderr, "Usage: %s [-b [-t workers] [-i operations] "
+			"[-d ms]]\n", argv[0]);
+		return -1;
+	}
+	return 0;
+}
+
+/* The n workers of the benchmark, NULL if they cannot be allocated */
+static struct sb_worker *sb_setup(long n)
+{
+	long i;
+
+	sb = mmap(NULL, sizeof(*sb) + n * sizeof(sb->w[0]),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (sb == MAP_FAILED) {
+		sb = NULL;
+		return NULL;
+	}
+	sb->nworkers = n;
+	for (i = 0; i < n; i++)
+		mes_hist_init(&sb->w[i].wait);
+	return sb->w;
+}
+
+/*
+ * sem_wait(), timed in benchmark mode.  Returns 0, 1 once the benchmark
+ * is over (the semaphore may not have been taken), or -1 with errno set.
+ */
+static int sb_wait(sem_t *sem, struct sb_worker *w)
+{
+	struct timespec t0, t1;
+	int ret;
+
+	if (sb_opt.bench) {
+		if (sb->stop)
+			return 1;
+		mes_now(&t0);
+	}
+	while ((ret = sem_wait(sem)) == -1 && errno == EINTR)
+		;
+	if (ret == -1)
+		return -1;
+	if (!sb_opt.bench)
+		return 0;
+	mes_now(&t1);
+	mes_hist_record(&w->wait, mes_elapsed_ns(&t0, &t1));
+	return sb->stop;
+}
+
+static void sb_stop(void)
+{
+	struct timespec now;
+
+	mes_now(&now);
+	if (__atomic_exchange_n(&sb->stop, 1, __ATOMIC_SEQ_CST) == 0)
+		sb->t1 = now;
+}
+
+static void sb_op(struct sb_worker *w)
+{
+	if (!sb_opt.bench)
+		return;
+	w->ops++;
+	if (sb_opt.iterations > 0 &&
+	    __atomic_add_fetch(&sb->ops, 1, __ATOMIC_RELAXED) ==
+	    (unsigned long)sb_opt.iterations)
+		sb_stop();
+}
+
+static void sb_start(void)
+{
+	mes_now(&sb_t0);
+}
+
+/* Let the workers run, then stop them; their semaphores are sems[] */
+static void sb_run(sem_t *sems[], int nsems)
+{
+	struct timespec poll = { 0, SB_POLL_MS * 1000000L }, now;
+	long i;
+	int s;
+
+	while (!sb->stop) {
+		nanosleep(&poll, NULL);
+		mes_now(&now);
+		if (mes_elapsed_us(&sb_t0, &now) >= sb_opt.duration_ms * 1000.0)
+			sb_stop();
+	}
+
+	for (s = 0; s < nsems; s++)
+		for (i = 0; i < sb->nworkers; i++)
+			sem_post(sems[s]);
+}
+
+static void sb_report(const char *const roles[], int nroles)
+{
+	struct mes_hist wait;
+	unsigned long ops, min, max;
+	double s = mes_elapsed_us(&sb_t0, &sb->t1) / 1e6;
+	long i, n;
+	int r;
+
+	printf("%-12s %7s %12s %12s %8s %12s %10s %10s\n", "role", "workers",
+	       "ops", "ops/s", "fairness", "wait p50 us", "p99 us", "max us");
+	for (r = 0; r < nroles; r++) {
+		mes_hist_init(&wait);
+		ops = min = max = 0;
+		for (i = n = 0; i < sb->nworkers; i++) {
+			if (sb->w[i].role != r)
+				continue;
+			ops += sb->w[i].ops;
+			if (n == 0 || sb->w[i].ops < min)
+				min = sb->w[i].ops;
+			if (n == 0 || sb->w[i].ops > max)
+				max = sb->w[i].ops;
+			mes_hist_merge(&wait, &sb->w[i].wait);
+			n++;
+		}
+		if (n == 0)
+			continue;
+		printf("%-12s %7ld %12lu %12.0f %8.3f %12.3f %10.3f %10.3f\n",
+		       roles[r], n, ops, ops / s, max ? (double)min / max : 0,
+		       mes_hist_percentile(&wait, 50) / 1e3,
+		       mes_hist_percentile(&wait, 99) / 1e3,
+		       mes_hist_percentile(&wait, 100) / 1e3);
+	}
+}
+
+#endif /* SEM_BENCH_H */
@@ -8,6 +8,9 @@
  * 
  * This is a test about producer and consumer. Producer sends data 
  * to a buffer. Consumer keeps reading data from the buffer.
+ *
+ * With -b, -t producers and as many consumers go through the buffer as
+ * fast as they can, see sem_bench.h.
  */
 
 #include <stdio.h>
@@ -23,6 +26,7 @@
 #include <semaphore.h>
 
 #include "posixtest.h"
+#include "sem_bench.h"
 
 #define BUF_SIZE	5
 #define Max_Num		10
@@ -34,25 +38,36 @@ typedef struct {
 	sem_t lock;
 }buf_t;
 
+typedef struct {
+	buf_t *buf;
+	struct sb_worker *w;
+}arg_t;
+
 int in, out;
 
-int *producer(buf_t *buf) 
+int *producer(arg_t *arg) 
 {
+	buf_t *buf = arg->buf;
 	int data;
-	int i;
+	int i, ret;
 
-	for (i = 0; i< Max_Num; i++) {
-		if (-1 == sem_wait(&buf->occupied)) {
+	for (i = 0; sb_opt.bench || i < Max_Num; i++) {
+		if (-1 == (ret = sb_wait(&buf->occupied, arg->w))) {
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
-		if (-1 == sem_wait(&buf->lock)) {
+		if (ret)
+			break;
+		if (-1 == (ret = sb_wait(&buf->lock, arg->w))) {
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		data = 100*i;
 		buf->buffer[in] = data;
-		printf("producer has added %d to the buffer[%d] \n", data, in);
+		if (!sb_opt.bench)
+			printf("producer has added %d to the buffer[%d] \n", data, in);
 		in = (in + 1) % BUF_SIZE;
 		if (-1 == sem_post(&buf->lock)) {
 			perror("sem_wait didn't return success \n");	
@@ -62,25 +77,32 @@ int *producer(buf_t *buf)
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
+		sb_op(arg->w);
 	}
 	pthread_exit((void *)0);
 }
-int *consumer(buf_t *buf)
+int *consumer(arg_t *arg)
 {
+	buf_t *buf = arg->buf;
 	int data;
-	int i;
+	int i, ret;
 
-	for (i = 0; i < Max_Num; i++) {
-		if (-1 == sem_wait(&buf->empty)) {
+	for (i = 0; sb_opt.bench || i < Max_Num; i++) {
+		if (-1 == (ret = sb_wait(&buf->empty, arg->w))) {
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
-		if (-1 == sem_wait(&buf->lock)) {
+		if (ret)
+			break;
+		if (-1 == (ret = sb_wait(&buf->lock, arg->w))) {
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		data = buf->buffer[out];
-		printf("consumer has taken %d from buffer[%d] \n", data, out);
+		if (!sb_opt.bench)
+			printf("consumer has taken %d from buffer[%d] \n", data, out);
 		out = (out + 1) % BUF_SIZE;
 		if (-1 == sem_post(&buf->lock)) {
 			perror("sem_wait didn't return success \n");	
@@ -90,9 +112,48 @@ int *consumer(buf_t *buf)
 			perror("sem_wait didn't return success \n");	
 			pthread_exit((void *)1);
 		}
+		sb_op(arg->w);
 	}
 	pthread_exit(0);
 }
+
+/* -t producers and as many consumers, as fast as they can */
+int bench(buf_t *buf)
+{
+	static const char *const roles[] = { "producer", "consumer" };
+	sem_t *sems[] = { &buf->occupied, &buf->empty, &buf->lock };
+	struct sb_worker *w;
+	pthread_t *th;
+	arg_t *args;
+	long i, n = 2 * sb_opt.threads;
+
+	w = sb_setup(n);
+	th = malloc(n * sizeof(*th));
+	args = malloc(n * sizeof(*args));
+	if (w == NULL || th == NULL || args == NULL) {
+		perror("Not enough memory for the workers");
+		return PTS_UNRESOLVED;
+	}
+
+	sb_start();
+	for (i = 0; i < n; i++) {
+		args[i].buf = buf;
+		args[i].w = &w[i];
+		w[i].role = i & 1;
+		if (0 != pthread_create(&th[i], NULL,
+		    (void *)(w[i].role ? consumer : producer), &args[i])) {
+			perror("pthread_create didn't return success");
+			return PTS_UNRESOLVED;
+		}
+	}
+	sb_run(sems, 3);
+	for (i = 0; i < n; i++)
+		pthread_join(th[i], NULL);
+
+	sb_report(roles, 2);
+	return PTS_PASS;
+}
+
 int main(int argc, char *argv[])
 {
 	int shared = 1;
@@ -100,9 +161,13 @@ int main(int argc, char *argv[])
 	int empty_value = 0;
 	int lock_value=1;
 	buf_t *buf;
+	arg_t con_arg, pro_arg;
 	pthread_t con, pro;
 	buf = (buf_t *)malloc(sizeof(buf_t));
 
+	if (sb_getopt(argc, argv, 1) != 0)
+		return PTS_UNRESOLVED;
+
 
 #ifndef  _POSIX_SEMAPHORES
 	printf("_POSIX_SEMAPHORES is not defined \n");
@@ -123,8 +188,13 @@ int main(int argc, char *argv[])
 	}
 	in = out = 0;
 
-	pthread_create(&con, NULL, (void *)consumer, (void *)buf);	
-	pthread_create(&pro, NULL, (void *)producer, (void *)buf);	
+	if (sb_opt.bench)
+		return bench(buf);
+
+	con_arg.buf = pro_arg.buf = buf;
+	con_arg.w = pro_arg.w = NULL;
+	pthread_create(&con, NULL, (void *)consumer, (void *)&con_arg);	
+	pthread_create(&pro, NULL, (void *)producer, (void *)&pro_arg);	
 	pthread_join(con, NULL);
 	pthread_join(pro, NULL);
 	sem_destroy(&buf->occupied);
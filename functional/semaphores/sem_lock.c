@@ -7,6 +7,10 @@
  *
  * This test use semaphore to protect critical section between several
  * processes.
+ *
+ * With -b, -t processes take turns in the critical section as fast as
+ * they can, see sem_bench.h.  The test fails if two of them got in at
+ * once.
  */
 #include <stdio.h>
 #include <unistd.h>
@@ -20,11 +24,82 @@
 #include <semaphore.h>
 
 #include "posixtest.h"
+#include "sem_bench.h"
 
 #define SEM_NAME       "/tmp/semaphore"
 #define BUF_SIZE	200
 #define DEFAULT_THREADS 5
 
+/* -t processes through a critical section, as fast as they can */
+int bench(void)
+{
+	static const char *const roles[] = { "process" };
+	struct {
+		sem_t lock;
+		unsigned long counter;
+	} *shm;
+	sem_t *sems[1];
+	struct sb_worker *w;
+	unsigned long ops = 0;
+	pid_t pid;
+	long i;
+	int ret, status, result = PTS_PASS;
+
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	w = sb_setup(sb_opt.threads);
+	if (shm == MAP_FAILED || w == NULL) {
+		perror("mmap didn't return success");
+		return PTS_UNRESOLVED;
+	}
+	if (-1 == sem_init(&shm->lock, 1, 1)) {
+		perror("sem_init didn't return success");
+		return PTS_UNRESOLVED;
+	}
+	sems[0] = &shm->lock;
+
+	fflush(stdout);
+	sb_start();
+	for (i = 0; i < sb_opt.threads; i++) {
+		w[i].role = 0;
+		pid = fork();
+		if (pid == -1) {
+			perror("fork didn't return success");
+			return PTS_UNRESOLVED;
+		}
+		if (pid != 0)
+			continue;
+		while ((ret = sb_wait(&shm->lock, &w[i])) == 0) {
+			shm->counter++;
+			sb_op(&w[i]);
+			if (-1 == sem_post(&shm->lock)) {
+				perror("sem_post didn't return success");
+				_exit(PTS_UNRESOLVED);
+			}
+		}
+		if (ret == -1)
+			perror("sem_wait didn't return success");
+		_exit(ret == -1 ? PTS_UNRESOLVED : PTS_PASS);
+	}
+	sb_run(sems, 1);
+	for (i = 0; i < sb_opt.threads; i++) {
+		if (-1 == wait(&status) || !WIFEXITED(status) ||
+		    WEXITSTATUS(status) != PTS_PASS)
+			result = PTS_UNRESOLVED;
+	}
+
+	sb_report(roles, 1);
+	for (i = 0; i < sb_opt.threads; i++)
+		ops += w[i].ops;
+	if (shm->counter != ops) {
+		printf("%lu operations but %lu in the critical section: "
+		       "the semaphore let two processes in at once\n",
+		       ops, shm->counter);
+		return PTS_FAIL;
+	}
+	return result;
+}
+
 int main(int argc, char *argv[])
 {
 	sem_t *sem_lock;
@@ -39,7 +114,11 @@ int main(int argc, char *argv[])
 	printf("_POSIX_SEMAPHORES is not defined \n");
 	return PTS_UNRESOLVED;
 #endif
-	if ( (2 != argc) || (( num = atoi(argv[1])) <= 0)) {
+	if (sb_getopt(argc, argv, DEFAULT_THREADS) != 0)
+		return PTS_UNRESOLVED;
+	if (sb_opt.bench)
+		return bench();
+	if ( (optind + 1 != argc) || (( num = atoi(argv[optind])) <= 0)) {
 		fprintf(stdout, "Usage: %s number_of_processes\n", argv[0]);
 		printf("Set num_of_processes to default value %d \n", DEFAULT_THREADS);
 		num = DEFAULT_THREADS;
@@ -7,6 +7,8 @@
  * 
  * Test the well-known philosophy problem.
  *
+ * With -b, -t philosophers think and eat as fast as they can, see
+ * sem_bench.h.
  */
 #include <stdio.h>
 #include <unistd.h>
@@ -21,6 +23,7 @@
 #include <pthread.h>
 
 #include "posixtest.h"
+#include "sem_bench.h"
 
 #define	PH_NUM		5						
 #define LOOP_NUM	20
@@ -28,33 +31,37 @@
 #define hungry		1
 #define eating		2
 
-sem_t ph[PH_NUM];
+int ph_num = PH_NUM;
+sem_t *ph;
 sem_t lock;
 
-int state[PH_NUM]; 
+int *state; 
+struct sb_worker *workers;
 	
 int think(int ID)
 {
-	printf("Philosoper [%d] is thinking... \n", ID);
+	if (!sb_opt.bench)
+		printf("Philosoper [%d] is thinking... \n", ID);
 	return 0;
 }
 int eat(int ID)
 {
-	printf("Philosoper [%d] is eating... \n", ID);
+	if (!sb_opt.bench)
+		printf("Philosoper [%d] is eating... \n", ID);
 	return 0;
 }
 int test(int ID)
 {
 	int preID = 0, postID = 0;
 	if ((ID - 1) < 0) 
-		preID = PH_NUM + (ID - 1);
+		preID = ph_num + (ID - 1);
 	else
-		preID = (ID - 1)%PH_NUM;
+		preID = (ID - 1)%ph_num;
 	
-	if ((ID + 1) >= PH_NUM)
-		postID = ID + 1 - PH_NUM;
+	if ((ID + 1) >= ph_num)
+		postID = ID + 1 - ph_num;
 	else
-		postID = (ID + 1)%PH_NUM;
+		postID = (ID + 1)%ph_num;
 		
 	if ((state[ID] == hungry)&&(state[preID]!= eating)&&(state[postID] != eating)) {
 		state[ID] = eating;
@@ -66,41 +73,51 @@ int test(int ID)
 int philosopher(void *ID)
 {
 	int PhID = *(int *)ID;
+	struct sb_worker *w = sb_opt.bench ? &workers[PhID] : NULL;
 	int prePH, postPH;
-	int i;
+	int i, ret;
 	
-	for (i = 0; i < LOOP_NUM; i++) {
+	for (i = 0; sb_opt.bench || i < LOOP_NUM; i++) {
 		think(PhID);
-		sleep(1);
-		if ( -1 == sem_wait(&lock)) {
+		if (!sb_opt.bench)
+			sleep(1);
+		if ( -1 == (ret = sb_wait(&lock, w))) {
 			perror("sem_wait didn't return success \n");
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		state[PhID] = hungry;
 		test(PhID);
 		if ( -1 == sem_post(&lock)) {
 			perror("sem_post didn't return success \n");
 			pthread_exit((void *)1);
 		}
-		if ( -1 == sem_wait(&ph[PhID])) {
+		if ( -1 == (ret = sb_wait(&ph[PhID], w))) {
 			perror("sem_wait didn't return success \n");
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		eat(PhID);
-		sleep(1);
-		if ( -1 == sem_wait(&lock)) {
+		sb_op(w);
+		if (!sb_opt.bench)
+			sleep(1);
+		if ( -1 == (ret = sb_wait(&lock, w))) {
 			perror("sem_wait didn't return success \n");
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		state[PhID] = thinking;
 		if ((PhID - 1) < 0)
-			prePH = PH_NUM + (PhID - 1);
+			prePH = ph_num + (PhID - 1);
 		else
-			prePH = (PhID - 1)%PH_NUM;
-		if ((PhID + 1) >= PH_NUM)
-			postPH = PhID + 1 - PH_NUM;
+			prePH = (PhID - 1)%ph_num;
+		if ((PhID + 1) >= ph_num)
+			postPH = PhID + 1 - ph_num;
 		else
-			postPH = (PhID + 1)%PH_NUM;
+			postPH = (PhID + 1)%ph_num;
 		test(prePH);
 		test(postPH);
 		if ( -1 == sem_post(&lock)) {
@@ -113,8 +130,10 @@ int philosopher(void *ID)
 
 int main(int argc, char *argv[])
 {
-	pthread_t phi[PH_NUM];
-	int PhID[PH_NUM];
+	static const char *const roles[] = { "philosopher" };
+	pthread_t *phi;
+	sem_t **sems;
+	int *PhID;
 	int shared = 1;
 	int ph_value = 0;
 	int lock_value = 1;
@@ -124,7 +143,23 @@ int main(int argc, char *argv[])
 	printf("_POSIX_SEMAPHORES is not defined \n");
 	return PTS_UNRESOLVED;
 #endif 
-	for (i = 0; i < PH_NUM; i++) {
+	if (sb_getopt(argc, argv, PH_NUM) != 0)
+		return PTS_UNRESOLVED;
+	if (sb_opt.bench) {
+		ph_num = sb_opt.threads;
+		workers = sb_setup(ph_num);
+	}
+	ph = malloc(ph_num * sizeof(*ph));
+	state = malloc(ph_num * sizeof(*state));
+	phi = malloc(ph_num * sizeof(*phi));
+	PhID = malloc(ph_num * sizeof(*PhID));
+	sems = malloc((ph_num + 1) * sizeof(*sems));
+	if (!ph || !state || !phi || !PhID || !sems ||
+	    (sb_opt.bench && !workers)) {
+		perror("Not enough memory for the philosophers");
+		return PTS_UNRESOLVED;
+	}
+	for (i = 0; i < ph_num; i++) {
 		if (-1 == sem_init(&ph[i], shared, ph_value)) {
 			perror("sem_init didn't return success \n"); 
 			return PTS_UNRESOLVED;
@@ -136,16 +171,27 @@ int main(int argc, char *argv[])
 		return PTS_UNRESOLVED;
 	}
 
-	for (i = 0; i< PH_NUM; i++) {
+	if (sb_opt.bench)
+		sb_start();
+	for (i = 0; i< ph_num; i++) {
 		PhID[i] = i; 
 		pthread_create(&phi[i], NULL, (void *)philosopher, &PhID[i]);	
 	}
+
+	if (sb_opt.bench) {
+		for (i = 0; i < ph_num; i++)
+			sems[i] = &ph[i];
+		sems[ph_num] = &lock;
+		sb_run(sems, ph_num + 1);
+	}
 	
-	for (i = 0; i< PH_NUM; i++) {
+	for (i = 0; i< ph_num; i++) {
 		pthread_join(phi[i], NULL);
 	}
+	if (sb_opt.bench)
+		sb_report(roles, 1);
 
-	for (i = 0; i< PH_NUM; i++) {
+	for (i = 0; i< ph_num; i++) {
 		if (-1 == sem_destroy(&ph[i])) {
 			perror("sem_destroy didn't return success \n");
 			return PTS_UNRESOLVED;
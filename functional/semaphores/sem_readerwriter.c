@@ -10,6 +10,9 @@
  * write on the board at the same time. Reader and Writer can't use the board
  * the same time. Reader has higher priority than writer, which means only when
  * no reader reads the board, the writer can write the board.
+ *
+ * With -b, -t readers and -t writers use the board as fast as they can,
+ * see sem_bench.h.
  */
 #include <stdio.h>
 #include <unistd.h>
@@ -24,6 +27,7 @@
 #include <pthread.h>
 
 #include "posixtest.h"
+#include "sem_bench.h"
 
 #define SEM_NAME       "/tmp/semaphore"
 #define READ_NUM	10
@@ -32,79 +36,109 @@
 sem_t r_lock, w_lock;
 int reader_count = 0;
 int data = 0;
+int read_num = READ_NUM, write_num = WRITE_NUM;
+struct sb_worker *workers;
 
 int read_fun(int ID)
 {
-	printf("read the board, data=%d \n", data);	
+	if (!sb_opt.bench)
+		printf("read the board, data=%d \n", data);	
 	return 0;
 }
 int write_fun(int ID)
 {
 	data = 100*ID + ID;
-	printf("write the board, data=%d \n", data);
+	if (!sb_opt.bench)
+		printf("write the board, data=%d \n", data);
 	return 0;
 }
 int *reader(void *ID)
 {
 	int ThID = *(int*)ID;
-	if (-1 == sem_wait(&r_lock)) {
-		perror("sem_wait didn't return success\n");
-		pthread_exit((void *)1);
-	}
-	reader_count++;
-	printf("Enter into Reader thread, reader_count=%d \n", reader_count);
-	if (reader_count == 1) {
-		if (-1 == sem_wait(&w_lock)) {
+	struct sb_worker *w = sb_opt.bench ? &workers[ThID] : NULL;
+	int ret;
+
+	do {
+		if (-1 == (ret = sb_wait(&r_lock, w))) {
+			perror("sem_wait didn't return success\n");
+			pthread_exit((void *)1);
+		}
+		if (ret)
+			break;
+		reader_count++;
+		if (!sb_opt.bench)
+			printf("Enter into Reader thread, reader_count=%d \n", reader_count);
+		if (reader_count == 1) {
+			if (-1 == (ret = sb_wait(&w_lock, w))) {
+				perror("sem_wait didn't return success \n");
+				pthread_exit((void *)1);
+			}
+			if (ret)
+				break;
+		}
+		if (-1 == sem_post(&r_lock)) {
+			perror("sem_post didn't return success \n");
+			pthread_exit((void *)1);
+		}
+		if (!sb_opt.bench)
+			sleep(1);
+		read_fun(ThID);
+		if (-1 == (ret = sb_wait(&r_lock, w))) {
 			perror("sem_wait didn't return success \n");
 			pthread_exit((void *)1);
 		}
-	}
-	if (-1 == sem_post(&r_lock)) {
-		perror("sem_post didn't return success \n");
-		pthread_exit((void *)1);
-	}
-	sleep(1);
-	read_fun(ThID);
-	if (-1 == sem_wait(&r_lock)) {
-		perror("sem_wait didn't return success \n");
-		pthread_exit((void *)1);
-	}
-	reader_count--;
-	if (reader_count == 0) {
-		if (-1 == sem_post(&w_lock)) {
+		if (ret)
+			break;
+		reader_count--;
+		if (reader_count == 0) {
+			if (-1 == sem_post(&w_lock)) {
+				perror("sem_post didn't return success \n");
+				pthread_exit((void *)1);
+			}
+		}
+		if (-1 == sem_post(&r_lock)) {
 			perror("sem_post didn't return success \n");
 			pthread_exit((void *)1);
 		}
-	}
-	if (-1 == sem_post(&r_lock)) {
-		perror("sem_post didn't return success \n");
-		pthread_exit((void *)1);
-	}
-	printf("Reader Thread [%d] exit...reader_count=%d \n", ThID, reader_count);
+		sb_op(w);
+	} while (sb_opt.bench);
+	if (!sb_opt.bench)
+		printf("Reader Thread [%d] exit...reader_count=%d \n", ThID, reader_count);
 	pthread_exit((void *)0);
 }
 int *writer(void *ID)
 {
 	int ThID = *(int*)ID;
+	struct sb_worker *w = sb_opt.bench ? &workers[read_num + ThID] : NULL;
+	int ret;
+
 /* When ThID is equal to WRITE_NUM/2, sleep 2 second and let reader read the data */
-	if (ThID >= WRITE_NUM/2)
+	if (!sb_opt.bench && ThID >= WRITE_NUM/2)
 		sleep(2);
-	if (-1 == sem_wait(&w_lock)) {
-		perror("sem_wait didn't return success \n");
-		pthread_exit((void *)1);
-	}
-	write_fun(ThID);
-	if (-1 == sem_post(&w_lock)) {
-		perror("sem_post didn't return success \n");
-		pthread_exit((void *)1);
-	}
-	printf("Writer Thread [%d] exit...\n", ThID);
+	do {
+		if (-1 == (ret = sb_wait(&w_lock, w))) {
+			perror("sem_wait didn't return success \n");
+			pthread_exit((void *)1);
+		}
+		if (ret)
+			break;
+		write_fun(ThID);
+		if (-1 == sem_post(&w_lock)) {
+			perror("sem_post didn't return success \n");
+			pthread_exit((void *)1);
+		}
+		sb_op(w);
+	} while (sb_opt.bench);
+	if (!sb_opt.bench)
+		printf("Writer Thread [%d] exit...\n", ThID);
 	pthread_exit((void *)0);
 }
 int main(int argc, char *argv[])
 {
-	pthread_t rea[READ_NUM], wri[WRITE_NUM];
-	int ReadID[READ_NUM], WriteID[WRITE_NUM];
+	static const char *const roles[] = { "reader", "writer" };
+	sem_t *sems[] = { &r_lock, &w_lock };
+	pthread_t *rea, *wri;
+	int *ReadID, *WriteID;
 	int shared = 1;
 	int r_value = 1;
 	int w_value = 1;
@@ -114,6 +148,22 @@ int main(int argc, char *argv[])
 	printf("_POSIX_SEMAPHORES is not defined \n");
 	return PTS_UNRESOLVED;
 #endif 
+	if (sb_getopt(argc, argv, 4) != 0)
+		return PTS_UNRESOLVED;
+	if (sb_opt.bench) {
+		read_num = write_num = sb_opt.threads;
+		workers = sb_setup(read_num + write_num);
+		for (i = 0; workers && i < read_num + write_num; i++)
+			workers[i].role = i >= read_num;
+	}
+	rea = malloc(read_num * sizeof(*rea));
+	wri = malloc(write_num * sizeof(*wri));
+	ReadID = malloc(read_num * sizeof(*ReadID));
+	WriteID = malloc(write_num * sizeof(*WriteID));
+	if (!rea || !wri || !ReadID || !WriteID || (sb_opt.bench && !workers)) {
+		perror("Not enough memory for the readers and writers");
+		return PTS_UNRESOLVED;
+	}
 	if (-1 == sem_init(&r_lock, shared, r_value)) {
 		perror("sem_init didn't return success \n"); 
 		return PTS_UNRESOLVED;
@@ -123,20 +173,26 @@ int main(int argc, char *argv[])
 		return PTS_UNRESOLVED;
 	}
 
-	for (i = 0; i< WRITE_NUM; i++) {
+	if (sb_opt.bench)
+		sb_start();
+	for (i = 0; i< write_num; i++) {
 		WriteID[i] = i;
 		pthread_create(&wri[i], NULL, (void *)writer, &WriteID[i]);	
 	}
-	for (i = 0; i< READ_NUM; i++) {
+	for (i = 0; i< read_num; i++) {
 		ReadID[i] = i;
 		pthread_create(&rea[i], NULL, (void *)reader, &ReadID[i]);	
 	}
 
+	if (sb_opt.bench)
+		sb_run(sems, 2);
 	
-	for (i = 0; i< READ_NUM; i++)
+	for (i = 0; i< read_num; i++)
 		pthread_join(rea[i], NULL);
-	for (i = 0; i< WRITE_NUM; i++)
+	for (i = 0; i< write_num; i++)
 		pthread_join(wri[i], NULL);
+	if (sb_opt.bench)
+		sb_report(roles, 2);
 
 	if (-1 == sem_destroy(&r_lock)) {
 		perror("sem_destroy didn't return success \n");
@@ -6,6 +6,9 @@
  * source tree.
  *
  * Test the well-known sleeping barber problem. 
+ *
+ * With -b, the barber and -t customers, who come back as soon as they
+ * leave, go as fast as they can, see sem_bench.h.
  */
 
 #include <stdio.h>
@@ -21,6 +24,7 @@
 #include <time.h>
 
 #include "posixtest.h"
+#include "sem_bench.h"
 #define CHAIR_NUM	5
 #define CUS_NUM		10
 #define LOOP_NUM	30
@@ -31,12 +35,15 @@ sem_t lock;
 sem_t print;
 
 int waiting = 0;
+struct sb_worker *workers;
 
 #ifdef __GNUC__
 #define my_printf(x...) do { \
-	sem_wait(&print); \
-	printf(x); \
-	sem_post(&print); \
+	if (!sb_opt.bench) { \
+		sem_wait(&print); \
+		printf(x); \
+		sem_post(&print); \
+	} \
 } while (0)
 #else
 #define my_printf printf
@@ -52,12 +59,15 @@ void mdelay(unsigned msecs)
 
 void *barbers(void *unused)
 {
-	int i;
-	for (i = 0; i < LOOP_NUM; i++) {
-		if (-1 == sem_wait(&lock)) {
+	struct sb_worker *w = sb_opt.bench ? &workers[0] : NULL;
+	int i, ret;
+	for (i = 0; sb_opt.bench || i < LOOP_NUM; i++) {
+		if (-1 == (ret = sb_wait(&lock, w))) {
 			perror("sem_wait(&lock) didn't return success");
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		if (waiting == 0) {
 			my_printf("There are no more customers waiting, barber will sleep.\n");
 		}
@@ -65,14 +75,18 @@ void *barbers(void *unused)
 			perror("sem_post(&lock) didn't return success");
 			pthread_exit((void *)1);
 		}
-		if (-1 == sem_wait(&customer)) {
+		if (-1 == (ret = sb_wait(&customer, w))) {
 			perror("sem_wait(&customer) didn't return success");
 			pthread_exit((void *)1);
 		}
-		if (-1 == sem_wait(&lock)) {
+		if (ret)
+			break;
+		if (-1 == (ret = sb_wait(&lock, w))) {
 			perror("sem_wait(&lock) didn't return success");
 			pthread_exit((void *)1);
 		}
+		if (ret)
+			break;
 		if (waiting >= 1)
 			waiting--;
 		my_printf("A customer sits in the barber's chair and get a hair cut.  %d customers left waiting.\n", waiting);
@@ -84,57 +98,84 @@ void *barbers(void *unused)
 		perror("sem_post(&barber) didn't return success");
 			pthread_exit((void *)1);
 		}
+		sb_op(w);
 			
 	}	
 	return (void *) 0;
 }
 void *customers(void* ID)
 {
-	int CusID;
+	struct sb_worker *w;
+	int CusID, ret;
 	CusID = *(int *)ID;
+	w = sb_opt.bench ? &workers[1 + CusID] : NULL;
 
-	if (CusID == 8) mdelay(10);
+	if (!sb_opt.bench && CusID == 8) mdelay(10);
 
-	my_printf("customer %d enters the room.\n", CusID);
-	if (-1 == sem_wait(&lock)) {
-		perror("sem_wait(&lock) didn't return success");
-		pthread_exit((void *)1);
-	}
-	if (waiting < CHAIR_NUM) {
-		waiting = waiting + 1;
-		if (-1 == sem_post(&customer)) {
-			perror("sem_post(&customer) didn't return success");
+	do {
+		my_printf("customer %d enters the room.\n", CusID);
+		if (-1 == (ret = sb_wait(&lock, w))) {
+			perror("sem_wait(&lock) didn't return success");
 			pthread_exit((void *)1);
 		}
-		my_printf("Customer %d sits down, now %d customers are waiting.\n", CusID, waiting);
-		if (-1 == sem_post(&lock)) {	
-			perror("sem_post(&lock) didn't return success");
-			pthread_exit((void *)1);
+		if (ret)
+			break;
+		if (waiting < CHAIR_NUM) {
+			waiting = waiting + 1;
+			if (-1 == sem_post(&customer)) {
+				perror("sem_post(&customer) didn't return success");
+				pthread_exit((void *)1);
+			}
+			my_printf("Customer %d sits down, now %d customers are waiting.\n", CusID, waiting);
+			if (-1 == sem_post(&lock)) {	
+				perror("sem_post(&lock) didn't return success");
+				pthread_exit((void *)1);
+			}
+			if (-1 == (ret = sb_wait(&barber, w))) {
+				perror("sem_wait(&barber) didn't return success");
+				pthread_exit((void *)1);
+			}
+			if (ret)
+				break;
+			my_printf("Customer %d leaves with nice hair.\n", CusID);
+			sb_op(w);
 		}
-		if (-1 == sem_wait(&barber)) {
-			perror("sem_wait(&barber) didn't return success");
-			pthread_exit((void *)1);
+		else
+		{
+			my_printf("No chairs available, customer %d leaves without a haircut.\n", CusID);
+			if (-1 == sem_post(&lock)) {	
+				perror("sem_post(&lock) didn't return success");
+				pthread_exit((void *)1);
+			}
 		}
-		my_printf("Customer %d leaves with nice hair.\n", CusID);
-	}
-	else
-	{
-		my_printf("No chairs available, customer %d leaves without a haircut.\n", CusID);
-		if (-1 == sem_post(&lock)) {	
-			perror("sem_post(&lock) didn't return success");
-			pthread_exit((void *)1);
-		}
-	}
+	} while (sb_opt.bench);
 	return (void *) 0;
 }
 int main(int argc, char *argv[])
 {
-	pthread_t bar, cus[CUS_NUM];
+	static const char *const roles[] = { "barber", "customer" };
+	sem_t *sems[] = { &customer, &barber, &lock };
+	pthread_t bar, *cus;
 	int shared = 0;
 	int barber_value = 0;
 	int customer_value = 0;
 	int lock_value=1;
-	int i, ID[CUS_NUM];
+	int i, *ID, cus_num = CUS_NUM;
+
+	if (sb_getopt(argc, argv, CUS_NUM) != 0)
+		return PTS_UNRESOLVED;
+	if (sb_opt.bench) {
+		cus_num = sb_opt.threads;
+		workers = sb_setup(1 + cus_num);
+		for (i = 0; workers && i <= cus_num; i++)
+			workers[i].role = i > 0;
+	}
+	cus = malloc(cus_num * sizeof(*cus));
+	ID = malloc(cus_num * sizeof(*ID));
+	if (!cus || !ID || (sb_opt.bench && !workers)) {
+		perror("Not enough memory for the customers");
+		return PTS_UNRESOLVED;
+	}
 
 	if (-1 == sem_init(&print, shared, 1)) {
 		perror("sem_init(&print) didn't return success"); 
@@ -157,13 +198,21 @@ int main(int argc, char *argv[])
 		perror("sem_init(&lock) didn't return success"); 
 		return PTS_UNRESOLVED;
 	}
-	for (i = 0; i < CUS_NUM; i++) {
+	if (sb_opt.bench)
+		sb_start();
+	for (i = 0; i < cus_num; i++) {
 		ID[i] = i;
 		pthread_create(&cus[i], NULL, customers, (void *)&ID[i]);	
 	}
 	pthread_create(&bar, NULL, barbers, NULL);	
-	for (i = 0; i< CUS_NUM; i++) 
+	if (sb_opt.bench)
+		sb_run(sems, 3);
+	for (i = 0; i< cus_num; i++) 
 		pthread_join(cus[i], NULL);
+	if (sb_opt.bench) {
+		pthread_join(bar, NULL);
+		sb_report(roles, 2);
+	}
 
 	return PTS_PASS;
 }
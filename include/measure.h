@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Measurement library shared by the scalability tests (lib/measure.c).
+ *
+ * A test records durations against a load level X (number of threads,
+ * processes, semaphores...), in one or more series, then asks whether
+ * the duration stays constant as X grows:
+ *
+ *	struct mes_set m;
+ *	struct timespec t0, t1;
+ *
+ *	mes_init(&m, 1, 1024);
+ *	for (...) {
+ *		mes_now(&t0);
+ *		... the operation, at load level n ...
+ *		mes_now(&t1);
+ *		mes_record(&m, n, 0, mes_elapsed_us(&t0, &t1));
+ *	}
+ *	if (mes_analyze(&m, names, output) != 0)
+ *		FAILED("The function is not scalable");
+ *	mes_fini(&m);
+ *
+ * Storage is allocated once, by mes_init().  When it is full, every
+ * other row is dropped and only one load level out of two is recorded
+ * from then on, so that the rows keep spanning the whole load range.
+ *
+ * The fits say whether the typical duration grows.  The tail is kept by
+ * latency histograms, one per range of load levels (struct mes_levels):
+ *
+ *	mes_levels_init(&lv, 100, 10);	(loads 0-99, 100-199, ... 900+)
+ *	mes_levels_record(&lv, n, mes_elapsed_ns(&t0, &t1));
+ *	mes_levels_print(&lv, "fork", output);
+ *
+ * prints the count, p50, p90, p99, p99.9 and max of each range.
+ *
+ * Where a duration grows, counters tell why (Linux perf events: cache
+ * misses, page faults, migrations...).  With PTS_PERF set in the
+ * environment, mes_perf_open() opens them for the calling thread, and a
+ * sample is bracketed with:
+ *
+ *	mes_perf_begin(&p);
+ *	... the operation ...
+ *	mes_perf_end(&p, counts);
+ *	mes_levels_count(&lv, n, counts);
+ *
+ * mes_levels_print() then also prints the mean of each counter per
+ * sample, for each range of load levels.  Without PTS_PERF, or where the
+ * counters are not available, the calls do nothing.
+ *
+ * The load and the output of a test are set when it runs, so that a
+ * range of loads can be explored without rebuilding it (see the sweep
+ * script in stress/threads).  The -DSCALABILITY_FACTOR, -DVERBOSE and
+ * -DPLOT_OUTPUT of the build only give the defaults:
+ *
+ *	if (mes_getopt(argc, argv, SCALABILITY_FACTOR, VERBOSE, PLOT) != 0)
+ *		UNRESOLVED(EINVAL, "Bad options");
+ *	if (mes_opt.verbose > 1)
+ *		...
+ *
+ * reads, the latter overriding the former, the environment and the
+ * options of the test:
+ *
+ *	PTS_SCALE	-s factor	SCALABILITY_FACTOR, the load
+ *	PTS_VERBOSE	-v level	VERBOSE
+ *	PTS_PLOT	-p		PLOT_OUTPUT: the "# COLUMNS" dump that
+ *					do-plot reads, and nothing else
+ *	PTS_RESOLUTION	-r n		load levels between two measures
+ *	PTS_MAX_LOAD	-n max		highest load level (processes, threads,
+ *					semaphores...)
+ *
+ * The last two are 0 when not given, for the test's own choice.
+ */
+
+#ifndef MEASURE_H
+#define MEASURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct mes_set {
+	int nseries;
+	size_t cap;		/* rows allocated */
+	size_t n;		/* rows recorded */
+	long *x;		/* load level of each row, increasing */
+	double *y;		/* see MES_Y; NAN when not measured */
+	unsigned int stride;	/* record one new load level out of stride */
+	unsigned int skipped;	/* new load levels skipped since the last row */
+	long last_skipped;	/* the latest of them, for the other series */
+
+	/* Analysis settings, may be changed after mes_init() */
+	size_t warmup;		/* leading rows left out of the analysis (1) */
+	double outlier_k;	/* outlier threshold, 0 to keep all points (5) */
+};
+
+/* Duration measured for a series at a row, in microseconds */
+#define MES_Y(m, row, s) ((m)->y[(size_t)(row) * (m)->nseries + (s)])
+
+/* The models fitted to each series, X being the load and Y the duration */
+enum mes_model {
+	MES_CONSTANT,	/* Y = k */
+	MES_LINEAR,	/* Y = a * X + b */
+	MES_POWER,	/* Y = c * X ^ a, i.e. ln Y = a * ln X + ln c */
+	MES_EXP,	/* Y = exp(a * X + b) */
+	MES_NMODELS
+};
+
+struct mes_fit {
+	int n;				/* points used */
+	int outliers;			/* points rejected */
+	double a[MES_NMODELS];		/* k for MES_CONSTANT */
+	double b[MES_NMODELS];		/* c for MES_POWER */
+	double err[MES_NMODELS];	/* mean squared error */
+};
+
+int mes_init(struct mes_set *m, int nseries, size_t cap);
+void mes_fini(struct mes_set *m);
+
+/* Returns the row for load x, creating it, or -1 if x is not recorded */
+long mes_add(struct mes_set *m, long x);
+long mes_find(const struct mes_set *m, long x);
+/* mes_find() or mes_add(), then store the value; returns the row or -1 */
+long mes_record(struct mes_set *m, long x, int series, double us);
+
+void mes_now(struct timespec *ts);
+double mes_elapsed_us(const struct timespec *from, const struct timespec *to);
+uint64_t mes_elapsed_ns(const struct timespec *from, const struct timespec *to);
+
+/* Returns -1 when there are too few points for a verdict */
+int mes_fit(const struct mes_set *m, int series, struct mes_fit *f);
+/* 0 if a model where Y grows with X explains the series clearly better */
+int mes_is_constant(const struct mes_fit *f);
+void mes_print_fit(const struct mes_fit *f, void (*out)(char *, ...));
+
+/*
+ * Fit every series, printing the models with "out" (may be NULL) under
+ * the series names (may be NULL).  Returns the number of series which
+ * are not constant.
+ */
+int mes_analyze(const struct mes_set *m, const char *const *names,
+		void (*out)(char *, ...));
+
+/*
+ * Latency histogram, HDR style: values below 2^MES_HIST_SUB_BITS ns have
+ * a bucket each, above that every power of two is split in as many linear
+ * buckets, so that any value is known within 1/32 (3%).  Values from
+ * 2^MES_HIST_BITS ns (18 minutes) up share the last bucket.
+ *
+ * The memory is fixed, and mes_hist_record() only does atomic updates:
+ * any number of threads may record into the same histogram.
+ */
+#define MES_HIST_SUB_BITS	5
+#define MES_HIST_BITS		40
+#define MES_HIST_BUCKETS	((MES_HIST_BITS - MES_HIST_SUB_BITS + 1) << MES_HIST_SUB_BITS)
+
+struct mes_hist {
+	uint64_t count;
+	uint64_t min, max;		/* ns, exact */
+	uint32_t bucket[MES_HIST_BUCKETS];
+};
+
+void mes_hist_init(struct mes_hist *h);
+void mes_hist_record(struct mes_hist *h, uint64_t ns);
+void mes_hist_merge(struct mes_hist *to, const struct mes_hist *from);
+/* Value at percentile p (0-100] in ns, 0 when empty */
+uint64_t mes_hist_percentile(const struct mes_hist *h, double p);
+
+/* Counters of struct mes_perf */
+enum mes_counter {
+	MES_CYCLES,
+	MES_INSTRUCTIONS,
+	MES_CACHE_MISSES,
+	MES_BRANCH_MISSES,
+	MES_CONTEXT_SWITCHES,
+	MES_CPU_MIGRATIONS,
+	MES_PAGE_FAULTS,
+	MES_NCOUNTERS
+};
+
+/* Value of a counter which is not available */
+#define MES_NOCOUNT	UINT64_MAX
+
+extern const char *const mes_counter_names[MES_NCOUNTERS];
+
+struct mes_perf {
+	int n;				/* counters in the group, 0 for none */
+	int fd[MES_NCOUNTERS];		/* fd[0] leads the group */
+	int id[MES_NCOUNTERS];		/* counter of each group member */
+	uint64_t start[MES_NCOUNTERS];
+	int user_only;			/* the kernel part is not counted */
+};
+
+/* Returns the number of counters opened, 0 when none */
+int mes_perf_open(struct mes_perf *p);
+void mes_perf_close(struct mes_perf *p);
+void mes_perf_begin(struct mes_perf *p);
+/* Counts since mes_perf_begin(), MES_NOCOUNT for the missing counters */
+void mes_perf_end(struct mes_perf *p, uint64_t counts[MES_NCOUNTERS]);
+
+/* One histogram per range of "width" load levels; the last is open */
+struct mes_levels {
+	long width;
+	size_t n;
+	struct mes_hist *h;
+	/* Counter totals per range, see mes_levels_count() */
+	uint64_t (*sum)[MES_NCOUNTERS];
+	uint64_t *nsum;
+	unsigned int counted;		/* mask of the counters seen */
+};
+
+int mes_levels_init(struct mes_levels *lv, long width, size_t n);
+void mes_levels_fini(struct mes_levels *lv);
+void mes_levels_record(struct mes_levels *lv, long x, uint64_t ns);
+void mes_levels_count(struct mes_levels *lv, long x,
+		      const uint64_t counts[MES_NCOUNTERS]);
+/* Percentiles in µs of each range which has values, under "name" */
+void mes_levels_print(const struct mes_levels *lv, const char *name,
+		      void (*out)(char *, ...));
+
+/* Run-time settings of the test, see mes_getopt() */
+struct mes_options {
+	long scale;		/* SCALABILITY_FACTOR, 1 or more */
+	long verbose;		/* VERBOSE */
+	int plot;		/* PLOT_OUTPUT */
+	long resolution;	/* 0: the test's own */
+	long max;		/* 0: the test's own */
+};
+
+extern struct mes_options mes_opt;
+
+/* Fills mes_opt; returns -1, with a usage message, on a bad setting */
+int mes_getopt(int argc, char *argv[], long scale, long verbose, int plot);
+
+#endif /* MEASURE_H */
@@ -30,12 +30,21 @@
  * Both three macros shall terminate the calling process. 
  * The testcase shall not terminate without calling one of those macros.
  * 
- * 
+ * The output functions are declared here too, and defined in
+ * lib/testfrmw.c, which the stress tests are linked with: one copy of
+ * them for the whole tree rather than one per directory.
  */
  
+#ifndef TESTFRMW_H
+#define TESTFRMW_H
+
 #include "posixtest.h"
 #include <string.h> /* for the strerror() routine */
 
+void output_init();
+void output( char * string, ... );
+void output_fini();
+
 
 #ifdef __GNUC__ /* We are using GCC */
 
@@ -83,3 +92,4 @@
 
 #endif
 
+#endif /* TESTFRMW_H */
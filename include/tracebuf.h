@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * The trace buffers behind output() in the testfrmw.c of the tests.
+ *
+ * A line used to take a mutex shared by all the threads, then go through
+ * time(), localtime() and printf(), every one of them locking too: a
+ * verbose test serialized its threads and measured its own traces.
+ * Instead, each thread appends its lines to a ring of its own, with no
+ * lock and no system call:
+ *
+ *	tb_init();		(from output_init(), or at the first line)
+ *	tb_log(fmt, ap);	(to the caller's ring, created at its first line)
+ *
+ * and the rings are written to stdout later, in batches, each in time
+ * order (the lines of a thread always keep their order):
+ *
+ * -> by the thread whose ring gets half full, or whose line comes more
+ *    than TB_FLUSH_MS after the last write;
+ * -> by tb_flush(), from output_fini() and at exit().
+ *
+ * There is no thread of its own for that: it would be one more thread in
+ * the tests which count them, and would keep alive a process whose last
+ * thread calls pthread_exit().  Each line is stamped with the monotonic
+ * time since output_init(), "[seconds.nanoseconds]".
+ *
+ * A forked child drops the lines of its parent, which the parent writes.
+ * A signal handler which interrupts output() or a write has a small ring
+ * of its own; when that one is busy or full, the handler's line is
+ * written at once, cut at TB_LINE bytes, from a buffer on its stack.
+ * With PTS_OUTPUT_SYNC set in the environment, every line is written at
+ * once: the lines of the last TB_FLUSH_MS of a test which is killed,
+ * e.g. when it hangs, are lost otherwise.
+ *
+ * Everything is in this header, as the tests are built from one file.
+ */
+
+#ifndef TRACEBUF_H
+#define TRACEBUF_H
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TB_RING		(64 * 1024)	/* bytes per thread */
+#define TB_SIGRING	4096		/* for its signal handlers */
+#define TB_LINE		512		/* longer lines are written at once */
+#define TB_FLUSH_MS	100
+
+struct tb_ring {
+	unsigned long head;	/* bytes appended, by the owner */
+	unsigned long tail;	/* bytes written out, under tb_lock */
+	unsigned long end;	/* bytes being written out, under tb_lock */
+	int busy;		/* the owner is in tb_log() or tb_flush() */
+	int dead;		/* the owner has exited: free once empty */
+	struct tb_ring *next;
+	/*
+	 * The lines of a signal handler which interrupts the owner while
+	 * it is busy go to a ring of their own; NULL in that ring.
+	 */
+	struct tb_ring *sig;
+	size_t size;
+	char buf[];
+};
+
+/* In the rings, each line is a header then the text */
+struct tb_hdr {
+	unsigned long long ns;
+	unsigned int len;
+};
+
+/* A line to write, by tb_flush() */
+struct tb_rec {
+	unsigned long long ns;
+	unsigned long seq;
+	struct tb_ring *r;
+	unsigned long pos;
+	unsigned int len;
+};
+
+static pthread_once_t tb_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tb_key;
+static pthread_mutex_t tb_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct tb_ring *tb_rings;
+static struct timespec tb_start;
+static unsigned long long tb_last;	/* ns of the last flush */
+static int tb_sync;
+static struct tb_rec *tb_recs;		/* under tb_lock */
+static size_t tb_nrecs;
+
+static unsigned long long tb_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec - tb_start.tv_sec) * 1000000000ULL +
+	       ts.tv_nsec - tb_start.tv_nsec;
+}
+
+static void tb_put(struct tb_ring *r, unsigned long pos, const void *p,
+		   size_t n)
+{
+	size_t off = pos % r->size, first = r->size - off;
+
+	if (first > n)
+		first = n;
+	memcpy(r->buf + off, p, first);
+	memcpy(r->buf, (const char *)p + first, n - first);
+}
+
+static void tb_get(const struct tb_ring *r, unsigned long pos, void *p,
+		   size_t n)
+{
+	size_t off = pos % r->size, first = r->size - off;
+
+	if (first > n)
+		first = n;
+	memcpy(p, r->buf + off, first);
+	memcpy((char *)p + first, r->buf, n - first);
+}
+
+static int tb_cmp(const void *a, const void *b)
+{
+	const struct tb_rec *x = a, *y = b;
+
+	if (x->ns != y->ns)
+		return x->ns < y->ns ? -1 : 1;
+	return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+static void tb_init(void);
+
+/* Write out the lines of all the rings, in time order */
+static void tb_flush(void)
+{
+	struct tb_ring *r, *self;
+	struct tb_rec *recs;
+	struct tb_hdr h;
+	unsigned long pos, head;
+	size_t n = 0, i, off, first;
+
+	tb_init();
+	self = pthread_getspecific(tb_key);
+	if (self != NULL)
+		__atomic_store_n(&self->busy, 1, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&tb_lock);
+
+	for (r = __atomic_load_n(&tb_rings, __ATOMIC_ACQUIRE); r != NULL;
+	     r = r->next) {
+		head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		for (pos = r->tail; pos != head; pos += sizeof(h) + h.len) {
+			tb_get(r, pos, &h, sizeof(h));
+			if (n == tb_nrecs) {
+				recs = realloc(tb_recs, (2 * n + 64) * sizeof(*recs));
+				if (recs == NULL)
+					break;
+				tb_recs = recs;
+				tb_nrecs = 2 * n + 64;
+			}
+			tb_recs[n].ns = h.ns;
+			tb_recs[n].seq = n;
+			tb_recs[n].r = r;
+			tb_recs[n].pos = pos + sizeof(h);
+			tb_recs[n].len = h.len;
+			n++;
+		}
+		r->end = pos;
+	}
+	qsort(tb_recs, n, sizeof(*tb_recs), tb_cmp);
+
+	for (i = 0; i < n; i++) {
+		printf("[%llu.%09llu]", tb_recs[i].ns / 1000000000ULL,
+		       tb_recs[i].ns % 1000000000ULL);
+		off = tb_recs[i].pos % tb_recs[i].r->size;
+		first = tb_recs[i].r->size - off;
+		if (first > tb_recs[i].len)
+			first = tb_recs[i].len;
+		fwrite(tb_recs[i].r->buf + off, 1, first, stdout);
+		fwrite(tb_recs[i].r->buf, 1, tb_recs[i].len - first, stdout);
+	}
+	fflush(stdout);
+
+	/* The space is given back once written */
+	for (r = tb_rings; r != NULL; r = r->next)
+		__atomic_store_n(&r->tail, r->end, __ATOMIC_RELEASE);
+	__atomic_store_n(&tb_last, tb_now(), __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&tb_lock);
+	if (self != NULL)
+		__atomic_store_n(&self->busy, 0, __ATOMIC_RELAXED);
+}
+
+static void tb_exit(void *p)
+{
+	__atomic_store_n(&((struct tb_ring *)p)->dead, 1, __ATOMIC_RELEASE);
+}
+
+static void tb_prepare(void)
+{
+	pthread_mutex_lock(&tb_lock);
+}
+
+static void tb_parent(void)
+{
+	pthread_mutex_unlock(&tb_lock);
+}
+
+/* The lines of the parent are not the child's to write */
+static void tb_child(void)
+{
+	struct tb_ring *r, *self = pthread_getspecific(tb_key);
+
+	for (r = tb_rings; r != NULL; r = r->next) {
+		r->tail = r->end = r->head;
+		if (r != self && r->sig != NULL)
+			r->dead = 1;
+	}
+	pthread_mutex_unlock(&tb_lock);
+}
+
+static void tb_flush_atexit(void)
+{
+	tb_flush();
+}
+
+static void tb_setup(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &tb_start);
+	tb_sync = getenv("PTS_OUTPUT_SYNC") != NULL;
+	pthread_key_create(&tb_key, tb_exit);
+	pthread_atfork(tb_prepare, tb_parent, tb_child);
+	atexit(tb_flush_atexit);
+}
+
+/* From output_init(): the time stamps count from there */
+static void tb_init(void)
+{
+	pthread_once(&tb_once, tb_setup);
+}
+
+static struct tb_ring *tb_new(size_t size)
+{
+	struct tb_ring *r = calloc(1, sizeof(*r) + size);
+
+	if (r == NULL)
+		return NULL;
+	r->size = size;
+	r->next = __atomic_load_n(&tb_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&tb_rings, &r->next, r, 1,
+					    __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+	return r;
+}
+
+static int tb_empty(struct tb_ring *r)
+{
+	return __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == r->head;
+}
+
+/* The ring of the calling thread: the free one of an exited thread, or a new one */
+static struct tb_ring *tb_self(void)
+{
+	struct tb_ring *r = pthread_getspecific(tb_key);
+	int dead;
+
+	if (r != NULL)
+		return r;
+
+	for (r = __atomic_load_n(&tb_rings, __ATOMIC_ACQUIRE); r != NULL;
+	     r = r->next) {
+		dead = 1;
+		if (r->sig != NULL && tb_empty(r) && tb_empty(r->sig) &&
+		    __atomic_compare_exchange_n(&r->dead, &dead, 0, 0,
+						__ATOMIC_ACQUIRE,
+						__ATOMIC_RELAXED))
+			break;
+	}
+	if (r == NULL) {
+		r = tb_new(TB_RING);
+		if (r == NULL)
+			return NULL;
+		r->sig = tb_new(TB_SIGRING);
+		if (r->sig == NULL)
+			return NULL;
+	}
+	pthread_setspecific(tb_key, r);
+	return r;
+}
+
+/* Returns -1 if the line does not fit */
+static int tb_append(struct tb_ring *r, const struct tb_hdr *h,
+		     const char *line)
+{
+	if (r->head + sizeof(*h) + h->len -
+	    __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > r->size)
+		return -1;
+	tb_put(r, r->head, h, sizeof(*h));
+	tb_put(r, r->head + sizeof(*h), line, h->len);
+	__atomic_store_n(&r->head, r->head + sizeof(*h) + h->len,
+			 __ATOMIC_RELEASE);
+	return 0;
+}
+
+static void tb_write(const char *p, size_t len)
+{
+	ssize_t w;
+
+	for (; len > 0; p += w, len -= w)
+		if ((w = write(STDOUT_FILENO, p, len)) <= 0)
+			break;
+}
+
+static void tb_log(const char *fmt, va_list ap)
+{
+	char line[TB_LINE], stamp[32], *p;
+	struct tb_ring *r;
+	struct tb_hdr h;
+	va_list aq;
+	int len, off, nested;
+
+	tb_init();
+	h.ns = tb_now();
+	r = tb_self();
+
+	va_copy(aq, ap);
+	len = vsnprintf(line, TB_LINE, fmt, aq);
+	va_end(aq);
+	if (len < 0)
+		return;
+	h.len = len;
+
+	nested = r != NULL && __atomic_load_n(&r->busy, __ATOMIC_RELAXED);
+	if (nested && len < TB_LINE &&
+	    !__atomic_load_n(&r->sig->busy, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&r->sig->busy, 1, __ATOMIC_RELAXED);
+		off = tb_append(r->sig, &h, line);
+		__atomic_store_n(&r->sig->busy, 0, __ATOMIC_RELAXED);
+		if (off == 0)
+			return;
+	}
+
+	if (nested) {
+		/* Maybe from a signal handler: no heap, no stdio lock */
+		off = snprintf(stamp, sizeof(stamp), "[%llu.%09llu]",
+			       h.ns / 1000000000ULL, h.ns % 1000000000ULL);
+		if (len >= TB_LINE) {
+			len = TB_LINE - 1;
+			line[len - 1] = '\n';
+		}
+		tb_write(stamp, off);
+		tb_write(line, len);
+		return;
+	}
+
+	if (len >= TB_LINE || r == NULL) {
+		/* Out of the rings, at once */
+		p = malloc(len + 32);
+		if (p == NULL)
+			return;
+		len = sprintf(p, "[%llu.%09llu]", h.ns / 1000000000ULL,
+			      h.ns % 1000000000ULL);
+		len += vsprintf(p + len, fmt, ap);
+		tb_flush();
+		tb_write(p, len);
+		free(p);
+		return;
+	}
+
+	__atomic_store_n(&r->busy, 1, __ATOMIC_RELAXED);
+	if (tb_append(r, &h, line) != 0) {
+		__atomic_store_n(&r->busy, 0, __ATOMIC_RELAXED);
+		tb_flush();
+		__atomic_store_n(&r->busy, 1, __ATOMIC_RELAXED);
+		tb_append(r, &h, line);
+	}
+	__atomic_store_n(&r->busy, 0, __ATOMIC_RELAXED);
+
+	if (tb_sync || r->head - r->tail > TB_RING / 2 ||
+	    h.ns > __atomic_load_n(&tb_last, __ATOMIC_RELAXED) +
+		   TB_FLUSH_MS * 1000000ULL)
+		tb_flush();
+}
+
+#endif /* TRACEBUF_H */
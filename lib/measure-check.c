@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Checks of the bookkeeping of measure.c which the scalability tests
+ * cannot show: after decimation, each kept load level must still carry
+ * the values of every series, as pthread_cond_timedwait/s-c.c records
+ * them one series at a time.  Run with "make -C lib check".
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdio.h>
+
+#include "measure.h"
+
+static int check_series(int nseries, size_t cap, long last)
+{
+	struct mes_set m;
+	long x;
+	size_t i;
+	int s, err = 0;
+
+	if (mes_init(&m, nseries, cap) != 0) {
+		perror("mes_init");
+		return 1;
+	}
+
+	for (x = 1; x <= last; x++)
+		for (s = 0; s < nseries; s++)
+			mes_record(&m, x, s, x * 10.0 + s);
+
+	if (m.n < cap / 2) {
+		fprintf(stderr, "%d series, cap %zu: %zu rows only\n",
+			nseries, cap, m.n);
+		err = 1;
+	}
+	for (i = 0; i < m.n; i++) {
+		if (i > 0 && m.x[i] - m.x[i - 1] > (long)m.stride) {
+			fprintf(stderr, "%d series, cap %zu: gap before %ld\n",
+				nseries, cap, m.x[i]);
+			err = 1;
+		}
+		for (s = 0; s < nseries; s++) {
+			if (MES_Y(&m, i, s) == m.x[i] * 10.0 + s)
+				continue;
+			fprintf(stderr, "%d series, cap %zu: series %d at %ld is %g\n",
+				nseries, cap, s, m.x[i], MES_Y(&m, i, s));
+			err = 1;
+		}
+	}
+
+	mes_fini(&m);
+	return err;
+}
+
+int main(void)
+{
+	int err = 0;
+
+	err |= check_series(1, 8, 40);
+	err |= check_series(2, 8, 40);
+	err |= check_series(3, 8, 1000);
+	err |= check_series(2, 100, 50);
+
+	printf("measure: %s\n", err ? "FAILED" : "PASSED");
+	return err;
+}
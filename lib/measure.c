@@ -0,0 +1,871 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Measurement library shared by the scalability tests, see measure.h.
+ *
+ * This replaces the mes_t lists and parse_measure() functions which each
+ * scalability test used to carry.  The model fitting is the same: each
+ * series is fitted with a constant, a linear, a power and an exponential
+ * model, and the duration is deemed to depend on the load when one of
+ * the last three explains the points better than the constant, with the
+ * same margins as before (10%, 20% and 30%).  Compared with those copies:
+ *
+ * -> only a model in which the duration grows with the load counts
+ *    against the constant: getting faster under load is not a failure;
+ *
+ * -> the points are kept in arrays allocated once, instead of a malloc()
+ *    per sample in the middle of the measurements;
+ * -> durations come from CLOCK_MONOTONIC, which NTP and settimeofday()
+ *    do not step;
+ * -> the first rows (warm-up: page faults, cold caches) are left out;
+ * -> isolated spikes (a preemption in the middle of a measure) are
+ *    rejected with a Hampel filter: a point is an outlier when it is
+ *    further from the median of its neighbours than outlier_k times the
+ *    typical such distance.  A trend, unlike a spike, moves the median of
+ *    the neighbours with it and is kept;
+ * -> the power model uses c = exp(b) (it used log(b)), each model's own
+ *    error is reported, and the computations are made on doubles rather
+ *    than on truncated longs.
+ *
+ * A least squares fit follows the mean and is blind to the tail, so the
+ * tests also keep latency histograms per range of load: a p99 which
+ * doubles under load shows there while the mean has hardly moved.
+ *
+ * The settings of mes_getopt() are read with getopt(), whose state the
+ * tests do not otherwise use.
+ *
+ * The perf counters of a sample are read as a single group, so that
+ * bracketing a sample costs two read() calls.  They are not inherited:
+ * for fork(), what is counted is the parent's side, page table copies
+ * included when the kernel is counted (perf_event_paranoid < 2).
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#ifdef __linux__
+#define _DEFAULT_SOURCE		/* syscall() */
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "measure.h"
+
+#define MES_WINDOW	2	/* neighbours on each side, for the outliers */
+
+int mes_init(struct mes_set *m, int nseries, size_t cap)
+{
+	size_t i;
+
+	memset(m, 0, sizeof(*m));
+	if (nseries < 1 || cap < 2)
+		return EINVAL;
+
+	m->x = calloc(cap, sizeof(*m->x));
+	m->y = calloc(cap * nseries, sizeof(*m->y));
+	if (m->x == NULL || m->y == NULL) {
+		free(m->x);
+		free(m->y);
+		return ENOMEM;
+	}
+	for (i = 0; i < cap * nseries; i++)
+		m->y[i] = NAN;
+
+	m->nseries = nseries;
+	m->cap = cap;
+	m->stride = 1;
+	m->warmup = 1;
+	m->outlier_k = 5.0;
+	return 0;
+}
+
+void mes_fini(struct mes_set *m)
+{
+	free(m->x);
+	free(m->y);
+	memset(m, 0, sizeof(*m));
+}
+
+/* Out of room: keep one row out of two, and record half as many from now */
+static void mes_decimate(struct mes_set *m)
+{
+	size_t i, j;
+	int s;
+
+	for (i = 0, j = 0; i < m->n; i += 2, j++) {
+		m->x[j] = m->x[i];
+		for (s = 0; s < m->nseries; s++)
+			MES_Y(m, j, s) = MES_Y(m, i, s);
+	}
+	for (i = j; i < m->n; i++)
+		for (s = 0; s < m->nseries; s++)
+			MES_Y(m, i, s) = NAN;
+	m->n = j;
+	m->stride *= 2;
+	m->skipped = 0;
+}
+
+long mes_add(struct mes_set *m, long x)
+{
+	if (m->n > 0 && x <= m->x[m->n - 1])
+		return -1;
+
+	/* The other series of a level skipped already: count it once */
+	if (m->skipped > 0 && x == m->last_skipped)
+		return -1;
+
+	if (++m->skipped < m->stride) {
+		m->last_skipped = x;
+		return -1;
+	}
+	m->skipped = 0;
+
+	if (m->n == m->cap)
+		mes_decimate(m);
+
+	m->x[m->n] = x;
+	return m->n++;
+}
+
+long mes_find(const struct mes_set *m, long x)
+{
+	size_t lo = 0, hi = m->n, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (m->x[mid] == x)
+			return mid;
+		if (m->x[mid] < x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return -1;
+}
+
+long mes_record(struct mes_set *m, long x, int series, double us)
+{
+	long row;
+
+	row = mes_find(m, x);
+	if (row < 0)
+		row = mes_add(m, x);
+	if (row >= 0)
+		MES_Y(m, row, series) = us;
+	return row;
+}
+
+void mes_now(struct timespec *ts)
+{
+#if defined(_POSIX_MONOTONIC_CLOCK) && (_POSIX_MONOTONIC_CLOCK >= 0)
+	if (clock_gettime(CLOCK_MONOTONIC, ts) == 0)
+		return;
+#endif
+	clock_gettime(CLOCK_REALTIME, ts);
+}
+
+double mes_elapsed_us(const struct timespec *from, const struct timespec *to)
+{
+	return (to->tv_sec - from->tv_sec) * 1e6 +
+	       (to->tv_nsec - from->tv_nsec) / 1e3;
+}
+
+uint64_t mes_elapsed_ns(const struct timespec *from, const struct timespec *to)
+{
+	int64_t ns;
+
+	ns = (int64_t)(to->tv_sec - from->tv_sec) * 1000000000 +
+	     (to->tv_nsec - from->tv_nsec);
+	return ns < 0 ? 0 : ns;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return (da > db) - (da < db);
+}
+
+static double median(double *v, int n)
+{
+	qsort(v, n, sizeof(*v), cmp_double);
+	return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* Hampel filter over the n points; returns the number of points kept */
+static int reject_outliers(double *x, double *y, int n, double k)
+{
+	double win[2 * MES_WINDOW + 1], *dev, *tmp, scale;
+	int i, j, lo, hi, kept;
+
+	if (k <= 0 || n < 2 * MES_WINDOW + 1)
+		return n;
+
+	dev = malloc(2 * n * sizeof(*dev));
+	if (dev == NULL)
+		return n;
+	tmp = dev + n;
+
+	for (i = 0; i < n; i++) {
+		lo = i - MES_WINDOW < 0 ? 0 : i - MES_WINDOW;
+		hi = i + MES_WINDOW >= n ? n - 1 : i + MES_WINDOW;
+		for (j = lo; j <= hi; j++)
+			win[j - lo] = y[j];
+		dev[i] = fabs(y[i] - median(win, hi - lo + 1));
+	}
+
+	/* 1.4826 * MAD estimates the standard deviation of normal noise */
+	memcpy(tmp, dev, n * sizeof(*dev));
+	scale = 1.4826 * median(tmp, n);
+
+	kept = n;
+	if (scale > 0) {
+		for (i = 0, kept = 0; i < n; i++) {
+			if (dev[i] > k * scale)
+				continue;
+			x[kept] = x[i];
+			y[kept] = y[i];
+			kept++;
+		}
+	}
+	free(dev);
+	return kept;
+}
+
+/* Least squares fit of v = a * u + b over n points */
+static void fit_line(const double *u, const double *v, int n, double *a, double *b)
+{
+	double uavg = 0, vavg = 0, q = 0, d = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		uavg += u[i];
+		vavg += v[i];
+	}
+	uavg /= n;
+	vavg /= n;
+	for (i = 0; i < n; i++) {
+		q += (u[i] - uavg) * (v[i] - vavg);
+		d += (u[i] - uavg) * (u[i] - uavg);
+	}
+	*a = d != 0 ? q / d : 0;
+	*b = vavg - *a * uavg;
+}
+
+int mes_fit(const struct mes_set *m, int series, struct mes_fit *f)
+{
+	double *x, *y, *lx, *ly, *xl, a, b, e, p;
+	size_t row;
+	int i, n = 0, nl = 0, total, mdl;
+
+	memset(f, 0, sizeof(*f));
+
+	x = malloc(5 * (m->n + 1) * sizeof(*x));
+	if (x == NULL)
+		return -1;
+	y = x + m->n + 1;
+	lx = y + m->n + 1;
+	ly = lx + m->n + 1;
+	xl = ly + m->n + 1;
+
+	for (row = m->warmup; row < m->n; row++) {
+		if (isnan(MES_Y(m, row, series)))
+			continue;
+		x[n] = m->x[row];
+		y[n] = MES_Y(m, row, series);
+		n++;
+	}
+	total = n;
+	n = reject_outliers(x, y, n, m->outlier_k);
+	f->n = n;
+	f->outliers = total - n;
+
+	if (n < 3) {
+		free(x);
+		return -1;
+	}
+
+	/* Y = k */
+	for (i = 0; i < n; i++)
+		f->a[MES_CONSTANT] += y[i];
+	f->a[MES_CONSTANT] /= n;
+
+	/* Y = a * X + b */
+	fit_line(x, y, n, &f->a[MES_LINEAR], &f->b[MES_LINEAR]);
+
+	/* The logarithmic models need X > 0 and Y > 0 */
+	for (i = 0; i < n; i++) {
+		if (x[i] <= 0 || y[i] <= 0)
+			continue;
+		xl[nl] = x[i];
+		lx[nl] = log(x[i]);
+		ly[nl] = log(y[i]);
+		nl++;
+	}
+
+	if (nl >= 3) {
+		/* ln Y = a * ln X + ln c */
+		fit_line(lx, ly, nl, &a, &b);
+		f->a[MES_POWER] = a;
+		f->b[MES_POWER] = exp(b);
+
+		/* ln Y = a * X + b */
+		fit_line(xl, ly, nl, &f->a[MES_EXP], &f->b[MES_EXP]);
+	}
+
+	for (i = 0; i < n; i++) {
+		for (mdl = 0; mdl < MES_NMODELS; mdl++) {
+			if (nl < 3 && (mdl == MES_POWER || mdl == MES_EXP))
+				continue;
+			switch (mdl) {
+			case MES_CONSTANT:
+				p = f->a[MES_CONSTANT];
+				break;
+			case MES_LINEAR:
+				p = f->a[MES_LINEAR] * x[i] + f->b[MES_LINEAR];
+				break;
+			case MES_POWER:
+				p = f->b[MES_POWER] * pow(x[i], f->a[MES_POWER]);
+				break;
+			default:
+				p = exp(f->a[MES_EXP] * x[i] + f->b[MES_EXP]);
+				break;
+			}
+			e = y[i] - p;
+			f->err[mdl] += e * e / n;
+		}
+	}
+
+	/* Without enough usable points, these models cannot win */
+	if (nl < 3) {
+		f->err[MES_POWER] = INFINITY;
+		f->err[MES_EXP] = INFINITY;
+	}
+
+	free(x);
+	return 0;
+}
+
+int mes_is_constant(const struct mes_fit *f)
+{
+	if (f->n < 3)
+		return 1;
+	return !((f->a[MES_LINEAR] > 0 &&
+		  f->err[MES_CONSTANT] > 1.1 * f->err[MES_LINEAR]) ||
+		 (f->a[MES_POWER] > 0 &&
+		  f->err[MES_CONSTANT] > 1.2 * f->err[MES_POWER]) ||
+		 (f->a[MES_EXP] > 0 &&
+		  f->err[MES_CONSTANT] > 1.3 * f->err[MES_EXP]));
+}
+
+void mes_print_fit(const struct mes_fit *f, void (*out)(char *, ...))
+{
+	out(" # of data: %i (%i outliers rejected)\n", f->n, f->outliers);
+	out("  Model: Y = k\n");
+	out("       k = %g\n", f->a[MES_CONSTANT]);
+	out("    Divergence %g\n", f->err[MES_CONSTANT]);
+	out("  Model: Y = a * X + b\n");
+	out("       a = %g\n", f->a[MES_LINEAR]);
+	out("       b = %g\n", f->b[MES_LINEAR]);
+	out("    Divergence %g\n", f->err[MES_LINEAR]);
+	out("  Model: Y = c * X ^ a\n");
+	out("       a = %g\n", f->a[MES_POWER]);
+	out("       c = %g\n", f->b[MES_POWER]);
+	out("    Divergence %g\n", f->err[MES_POWER]);
+	out("  Model: Y = exp(a * X + b)\n");
+	out("       a = %g\n", f->a[MES_EXP]);
+	out("       b = %g\n", f->b[MES_EXP]);
+	out("    Divergence %g\n", f->err[MES_EXP]);
+}
+
+int mes_analyze(const struct mes_set *m, const char *const *names,
+		void (*out)(char *, ...))
+{
+	struct mes_fit f;
+	int s, ret = 0;
+
+	for (s = 0; s < m->nseries; s++) {
+		if (out != NULL && names != NULL)
+			out("\nSeries: %s\n", names[s]);
+
+		if (mes_fit(m, s, &f) != 0) {
+			if (out != NULL)
+				out(" Not enough data (%i points)\n", f.n);
+			continue;
+		}
+		if (out != NULL)
+			mes_print_fit(&f, out);
+
+		if (!mes_is_constant(&f))
+			ret++;
+		else if (out != NULL)
+			out(" Sanction: OK\n");
+	}
+	return ret;
+}
+
+void mes_hist_init(struct mes_hist *h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = UINT64_MAX;
+}
+
+static int msb(uint64_t v)
+{
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(v);
+#else
+	int b = 0;
+
+	while (v >>= 1)
+		b++;
+	return b;
+#endif
+}
+
+static size_t hist_index(uint64_t ns)
+{
+	int m;
+
+	if (ns < (1 << MES_HIST_SUB_BITS))
+		return ns;
+	m = msb(ns);
+	if (m >= MES_HIST_BITS)
+		return MES_HIST_BUCKETS - 1;
+	return ((size_t)(m - MES_HIST_SUB_BITS + 1) << MES_HIST_SUB_BITS) +
+	       (ns >> (m - MES_HIST_SUB_BITS)) - (1 << MES_HIST_SUB_BITS);
+}
+
+/* Highest value falling in bucket i */
+static uint64_t hist_value(size_t i)
+{
+	int shift;
+
+	if (i < (1 << MES_HIST_SUB_BITS))
+		return i;
+	shift = (i >> MES_HIST_SUB_BITS) - 1;
+	return (((uint64_t)(i & ((1 << MES_HIST_SUB_BITS) - 1)) +
+		 (1 << MES_HIST_SUB_BITS) + 1) << shift) - 1;
+}
+
+void mes_hist_record(struct mes_hist *h, uint64_t ns)
+{
+	uint64_t cur;
+
+	__atomic_fetch_add(&h->bucket[hist_index(ns)], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+
+	cur = __atomic_load_n(&h->min, __ATOMIC_RELAXED);
+	while (ns < cur && !__atomic_compare_exchange_n(&h->min, &cur, ns, 1,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	cur = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+	while (ns > cur && !__atomic_compare_exchange_n(&h->max, &cur, ns, 1,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+void mes_hist_merge(struct mes_hist *to, const struct mes_hist *from)
+{
+	size_t i;
+
+	for (i = 0; i < MES_HIST_BUCKETS; i++)
+		to->bucket[i] += from->bucket[i];
+	to->count += from->count;
+	if (from->min < to->min)
+		to->min = from->min;
+	if (from->max > to->max)
+		to->max = from->max;
+}
+
+uint64_t mes_hist_percentile(const struct mes_hist *h, double p)
+{
+	uint64_t rank, seen = 0, v;
+	size_t i;
+
+	if (h->count == 0)
+		return 0;
+	if (p >= 100)
+		return h->max;
+
+	rank = ceil(p / 100 * h->count);
+	if (rank == 0)
+		rank = 1;
+	for (i = 0; i < MES_HIST_BUCKETS; i++) {
+		seen += h->bucket[i];
+		if (seen >= rank)
+			break;
+	}
+	v = hist_value(i < MES_HIST_BUCKETS ? i : MES_HIST_BUCKETS - 1);
+	/* The bucket bounds are approximate, the extremes are not */
+	if (v > h->max)
+		v = h->max;
+	if (v < h->min)
+		v = h->min;
+	return v;
+}
+
+const char *const mes_counter_names[MES_NCOUNTERS] = {
+	[MES_CYCLES] = "cycles",
+	[MES_INSTRUCTIONS] = "instructions",
+	[MES_CACHE_MISSES] = "cache-misses",
+	[MES_BRANCH_MISSES] = "branch-misses",
+	[MES_CONTEXT_SWITCHES] = "context-switches",
+	[MES_CPU_MIGRATIONS] = "cpu-migrations",
+	[MES_PAGE_FAULTS] = "page-faults",
+};
+
+#if defined(__linux__) && defined(SYS_perf_event_open)
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} mes_events[MES_NCOUNTERS] = {
+	[MES_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	[MES_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	[MES_CACHE_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	[MES_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	[MES_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	[MES_CPU_MIGRATIONS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+	[MES_PAGE_FAULTS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+static int perf_event(int c, int group, int user_only)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = mes_events[c].type;
+	attr.config = mes_events[c].config;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.exclude_kernel = user_only;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, group,
+		       PERF_FLAG_FD_CLOEXEC);
+}
+
+int mes_perf_open(struct mes_perf *p)
+{
+	int c, fd;
+
+	memset(p, 0, sizeof(*p));
+	if (getenv("PTS_PERF") == NULL)
+		return 0;
+
+	for (c = 0; c < MES_NCOUNTERS; c++) {
+		fd = perf_event(c, p->n ? p->fd[0] : -1, p->user_only);
+		/* perf_event_paranoid 2: only our own user space */
+		if (fd == -1 && (errno == EACCES || errno == EPERM) &&
+		    !p->user_only && p->n == 0) {
+			p->user_only = 1;
+			fd = perf_event(c, -1, 1);
+		}
+		if (fd == -1)
+			continue;
+		p->fd[p->n] = fd;
+		p->id[p->n++] = c;
+	}
+	return p->n;
+}
+
+void mes_perf_close(struct mes_perf *p)
+{
+	int i;
+
+	for (i = p->n - 1; i >= 0; i--)
+		close(p->fd[i]);
+	p->n = 0;
+}
+
+static int perf_read(const struct mes_perf *p, uint64_t *v)
+{
+	uint64_t buf[1 + MES_NCOUNTERS];
+	ssize_t len = (1 + p->n) * sizeof(uint64_t);
+
+	if (p->n == 0 || read(p->fd[0], buf, len) != len || buf[0] != (uint64_t)p->n)
+		return -1;
+	memcpy(v, buf + 1, p->n * sizeof(uint64_t));
+	return 0;
+}
+
+void mes_perf_begin(struct mes_perf *p)
+{
+	if (perf_read(p, p->start) != 0)
+		p->start[0] = MES_NOCOUNT;
+}
+
+void mes_perf_end(struct mes_perf *p, uint64_t counts[MES_NCOUNTERS])
+{
+	uint64_t now[MES_NCOUNTERS];
+	int i;
+
+	for (i = 0; i < MES_NCOUNTERS; i++)
+		counts[i] = MES_NOCOUNT;
+	if (p->n == 0 || p->start[0] == MES_NOCOUNT || perf_read(p, now) != 0)
+		return;
+	for (i = 0; i < p->n; i++)
+		counts[p->id[i]] = now[i] - p->start[i];
+}
+
+#else /* no perf events */
+
+int mes_perf_open(struct mes_perf *p)
+{
+	memset(p, 0, sizeof(*p));
+	return 0;
+}
+
+void mes_perf_close(struct mes_perf *p)
+{
+	p->n = 0;
+}
+
+void mes_perf_begin(struct mes_perf *p)
+{
+	(void)p;
+}
+
+void mes_perf_end(struct mes_perf *p, uint64_t counts[MES_NCOUNTERS])
+{
+	int i;
+
+	(void)p;
+	for (i = 0; i < MES_NCOUNTERS; i++)
+		counts[i] = MES_NOCOUNT;
+}
+
+#endif
+
+int mes_levels_init(struct mes_levels *lv, long width, size_t n)
+{
+	size_t i;
+
+	memset(lv, 0, sizeof(*lv));
+	if (width < 1 || n < 1)
+		return EINVAL;
+
+	lv->h = malloc(n * sizeof(*lv->h));
+	lv->sum = calloc(n, sizeof(*lv->sum));
+	lv->nsum = calloc(n, sizeof(*lv->nsum));
+	if (lv->h == NULL || lv->sum == NULL || lv->nsum == NULL) {
+		mes_levels_fini(lv);
+		return ENOMEM;
+	}
+	for (i = 0; i < n; i++)
+		mes_hist_init(&lv->h[i]);
+	lv->width = width;
+	lv->n = n;
+	return 0;
+}
+
+void mes_levels_fini(struct mes_levels *lv)
+{
+	free(lv->h);
+	free(lv->sum);
+	free(lv->nsum);
+	memset(lv, 0, sizeof(*lv));
+}
+
+static size_t level_index(const struct mes_levels *lv, long x)
+{
+	size_t i;
+
+	i = x < 0 ? 0 : (size_t)(x / lv->width);
+	return i >= lv->n ? lv->n - 1 : i;
+}
+
+void mes_levels_record(struct mes_levels *lv, long x, uint64_t ns)
+{
+	mes_hist_record(&lv->h[level_index(lv, x)], ns);
+}
+
+void mes_levels_count(struct mes_levels *lv, long x,
+		      const uint64_t counts[MES_NCOUNTERS])
+{
+	unsigned int mask = 0;
+	size_t i;
+	int c;
+
+	i = level_index(lv, x);
+	for (c = 0; c < MES_NCOUNTERS; c++) {
+		if (counts[c] == MES_NOCOUNT)
+			continue;
+		__atomic_fetch_add(&lv->sum[i][c], counts[c], __ATOMIC_RELAXED);
+		mask |= 1U << c;
+	}
+	if (mask == 0)
+		return;
+	__atomic_fetch_add(&lv->nsum[i], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_or(&lv->counted, mask, __ATOMIC_RELAXED);
+}
+
+static void level_range(const struct mes_levels *lv, size_t i, char *buf,
+			size_t size)
+{
+	if (i == lv->n - 1)
+		snprintf(buf, size, "%ld+", (long)i * lv->width);
+	else
+		snprintf(buf, size, "%ld-%ld", (long)i * lv->width,
+			 (long)(i + 1) * lv->width - 1);
+}
+
+/* Mean of each counter per sample, for the ranges which have some */
+static void print_counts(const struct mes_levels *lv, const char *name,
+			 void (*out)(char *, ...))
+{
+	char line[256], range[64];
+	size_t i, len;
+	int c;
+
+	out("%s counters per sample:\n", name);
+	len = snprintf(line, sizeof(line), " %-15s %8s", "load", "count");
+	for (c = 0; c < MES_NCOUNTERS; c++)
+		if (lv->counted & (1U << c))
+			len += snprintf(line + len, sizeof(line) - len, " %16s",
+					mes_counter_names[c]);
+	out("%s\n", line);
+
+	for (i = 0; i < lv->n; i++) {
+		if (lv->nsum[i] == 0)
+			continue;
+		level_range(lv, i, range, sizeof(range));
+		len = snprintf(line, sizeof(line), " %-15s %8llu", range,
+			       (unsigned long long)lv->nsum[i]);
+		for (c = 0; c < MES_NCOUNTERS; c++)
+			if (lv->counted & (1U << c))
+				len += snprintf(line + len, sizeof(line) - len,
+						" %16.1f", (double)lv->sum[i][c] /
+						lv->nsum[i]);
+		out("%s\n", line);
+	}
+}
+
+void mes_levels_print(const struct mes_levels *lv, const char *name,
+		      void (*out)(char *, ...))
+{
+	const struct mes_hist *h;
+	char range[64];
+	size_t i;
+
+	/* One call per line: out() may prefix each call with a timestamp */
+	out("%s latency (us):\n", name);
+	out(" %-15s %8s %9s %9s %9s %9s %9s\n",
+	    "load", "count", "p50", "p90", "p99", "p99.9", "max");
+	for (i = 0; i < lv->n; i++) {
+		h = &lv->h[i];
+		if (h->count == 0)
+			continue;
+		level_range(lv, i, range, sizeof(range));
+		out(" %-15s %8llu %9.3f %9.3f %9.3f %9.3f %9.3f\n", range,
+		    (unsigned long long)h->count,
+		    mes_hist_percentile(h, 50) / 1e3,
+		    mes_hist_percentile(h, 90) / 1e3,
+		    mes_hist_percentile(h, 99) / 1e3,
+		    mes_hist_percentile(h, 99.9) / 1e3,
+		    mes_hist_percentile(h, 100) / 1e3);
+	}
+	if (lv->counted != 0)
+		print_counts(lv, name, out);
+}
+
+struct mes_options mes_opt = { 1, 1, 0, 0, 0 };
+
+/* An integer, min or more; returns -1 if it is not */
+static int mes_number(const char *s, long min, long *v)
+{
+	char *end;
+	long l;
+
+	errno = 0;
+	l = strtol(s, &end, 10);
+	if (end == s || *end != '\0' || errno != 0 || l < min)
+		return -1;
+	*v = l;
+	return 0;
+}
+
+/* One setting, from the option "opt" or from its environment variable */
+static int mes_setopt(int opt, const char *s)
+{
+	long v;
+
+	switch (opt) {
+	case 's':
+		if (mes_number(s, 1, &v) != 0)
+			return -1;
+		mes_opt.scale = v;
+		break;
+	case 'v':
+		return mes_number(s, 0, &mes_opt.verbose);
+	case 'p':
+		if (s == NULL)
+			v = 1;
+		else if (mes_number(s, 0, &v) != 0)
+			return -1;
+		mes_opt.plot = v != 0;
+		break;
+	case 'r':
+		return mes_number(s, 0, &mes_opt.resolution);
+	case 'n':
+		return mes_number(s, 0, &mes_opt.max);
+	default:
+		return -1;
+	}
+	return 0;
+}
+
+int mes_getopt(int argc, char *argv[], long scale, long verbose, int plot)
+{
+	static const struct {
+		const char *name;
+		int opt;
+	} env[] = {
+		{ "PTS_SCALE", 's' },
+		{ "PTS_VERBOSE", 'v' },
+		{ "PTS_PLOT", 'p' },
+		{ "PTS_RESOLUTION", 'r' },
+		{ "PTS_MAX_LOAD", 'n' },
+	};
+	const char *s;
+	size_t i;
+	int c;
+
+	mes_opt.scale = scale > 0 ? scale : 1;
+	mes_opt.verbose = verbose;
+	mes_opt.plot = plot;
+	mes_opt.resolution = 0;
+	mes_opt.max = 0;
+
+	for (i = 0; i < sizeof(env) / sizeof(env[0]); i++) {
+		s = getenv(env[i].name);
+		if (s == NULL || *s == '\0')
+			continue;
+		if (mes_setopt(env[i].opt, s) != 0) {
+			fprintf(stderr, "%s: bad %s \"%s\"\n", argv[0],
+				env[i].name, s);
+			return -1;
+		}
+	}
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "s:v:pr:n:")) != -1) {
+		if (mes_setopt(c, c == 'p' ? NULL : optarg) != 0) {
+			fprintf(stderr, "Usage: %s [-s factor] [-v level] [-p]"
+				" [-r resolution] [-n max]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	/* The dump goes to do-plot as it is */
+	if (mes_opt.plot)
+		mes_opt.verbose = 0;
+	return 0;
+}
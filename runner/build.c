@@ -0,0 +1,617 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Build mode of pts-run: compile and link the tests with a pool of
+ * workers, as the %.o and %.test rules of the top-level Makefile do,
+ * and with the same "name: build: PASS" and "name: link: PASS" lines.
+ *
+ * The compiler and flags come from the CC, CFLAGS, INCLUDE and LDFLAGS
+ * environment variables (the top-level Makefile exports its own), with
+ * the Makefile defaults and the LDFLAGS file when they are not set.
+ *
+ * A test is not rebuilt when the cache (cache.c) holds a build for the
+ * same key: the hash of the source, of every file it includes with
+ * #include "...", of the flags and of the compiler version.
+ *
+ * The scalability tests of the stress areas (s-c*.c, see discover.c) are
+ * built by the Makefile of their directory, "make -s -C DIR s-c1", as
+ * they are linked with lib/measure.c and lib/testfrmw.c.  make decides
+ * what is out of date; they are not cached.
+ *
+ * For pts-run -z, the objects are compiled with -fPIC, and the tests
+ * are also linked as shared objects, NAME.so, for the fork server (see
+ * zygote.c).  A test whose shared object does not link is executed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <elf.h>
+#endif
+
+#include "runner.h"
+
+#define DEFAULT_CC	"cc"
+#define DEFAULT_CFLAGS	"-g -O2 -Wall -Werror -D_POSIX_C_SOURCE=200112L -std=gnu99"
+#define DEFAULT_INCLUDE	"-Iinclude"
+#define LDFLAGS_FILE	"LDFLAGS"
+
+#define MAX_INCLUDES	64
+
+enum step {
+	STEP_COMPILE,
+	STEP_LINK,
+	STEP_SHARED,
+	STEP_MAKE,
+};
+
+struct job {
+	struct test *t;
+	enum step step;
+	pid_t pid;
+	char log[4096];
+};
+
+struct words {
+	char **v;
+	int n;
+};
+
+static struct words cc, cflags, include, ldflags;
+static uint64_t env_key;
+static int shared;
+
+static void split_words(struct words *w, const char *s)
+{
+	char *copy, *tok, *save;
+
+	copy = strdup(s);
+	if (copy == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+	for (tok = strtok_r(copy, " \t\n", &save); tok != NULL;
+	     tok = strtok_r(NULL, " \t\n", &save)) {
+		w->v = realloc(w->v, (w->n + 1) * sizeof(*w->v));
+		if (w->v == NULL) {
+			perror("pts-run");
+			exit(2);
+		}
+		w->v[w->n++] = tok;
+	}
+}
+
+/* As the Makefile: LDFLAGS := $(shell cat LDFLAGS | grep -v \^\#) */
+static char *read_ldflags_file(void)
+{
+	char line[1024], *all;
+	size_t len = 0;
+	FILE *fp;
+
+	all = calloc(1, 1);
+	fp = fopen(LDFLAGS_FILE, "r");
+	if (fp == NULL || all == NULL)
+		return all;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (line[0] == '#')
+			continue;
+		all = realloc(all, len + strlen(line) + 2);
+		if (all == NULL)
+			break;
+		strcpy(all + len, line);
+		len += strlen(line);
+	}
+	fclose(fp);
+	return all;
+}
+
+static const char *env_or(const char *name, const char *def)
+{
+	const char *v = getenv(name);
+
+	return v != NULL ? v : def;
+}
+
+static void build_init(void)
+{
+	const char *v;
+	char buf[4096], cmd[4096];
+	FILE *fp;
+	size_t n;
+
+	v = env_or("CC", DEFAULT_CC);
+	split_words(&cc, v);
+	env_key = hash_str(FNV_OFFSET, v);
+
+	v = env_or("CFLAGS", DEFAULT_CFLAGS);
+	split_words(&cflags, v);
+	env_key = hash_str(env_key, v);
+	if (shared) {
+		split_words(&cflags, "-fPIC");
+		env_key = hash_str(env_key, "-fPIC");
+	}
+
+	v = env_or("INCLUDE", DEFAULT_INCLUDE);
+	split_words(&include, v);
+	env_key = hash_str(env_key, v);
+
+	v = getenv("LDFLAGS");
+	if (v == NULL)
+		v = read_ldflags_file();
+	split_words(&ldflags, v);
+	env_key = hash_str(env_key, v);
+
+	if (cc.n == 0) {
+		fprintf(stderr, "pts-run: CC is empty\n");
+		exit(2);
+	}
+
+	/* The compiler version is part of every build key */
+	snprintf(cmd, sizeof(cmd), "%s --version 2>&1", env_or("CC", DEFAULT_CC));
+	fp = popen(cmd, "r");
+	if (fp != NULL) {
+		while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+			env_key = hash_bytes(env_key, buf, n);
+		pclose(fp);
+	}
+}
+
+/*
+ * Resolve an #include "name" as the compiler would: next to the file
+ * which includes it first, then in the -I directories.
+ */
+static int resolve(const char *from, const char *name, char *path, size_t size)
+{
+	const char *slash = strrchr(from, '/');
+	struct words *w[2] = { &include, &cflags };
+	int i, j;
+
+	if (slash != NULL)
+		snprintf(path, size, "%.*s/%s", (int)(slash - from), from, name);
+	else
+		snprintf(path, size, "%s", name);
+	if (access(path, R_OK) == 0)
+		return 0;
+
+	for (j = 0; j < 2; j++) {
+		for (i = 0; i < w[j]->n; i++) {
+			if (strncmp(w[j]->v[i], "-I", 2) != 0 || w[j]->v[i][2] == '\0')
+				continue;
+			snprintf(path, size, "%s/%s", w[j]->v[i] + 2, name);
+			if (access(path, R_OK) == 0)
+				return 0;
+		}
+	}
+	return -1;
+}
+
+static int hash_source(uint64_t *h, const char *path, char **seen, int *nseen)
+{
+	char line[1024], inc[4096], *p, *q;
+	FILE *fp;
+	int i;
+
+	for (i = 0; i < *nseen; i++)
+		if (strcmp(seen[i], path) == 0)
+			return 0;
+	if (*nseen == MAX_INCLUDES)
+		return -1;
+	seen[(*nseen)++] = strdup(path);
+
+	*h = hash_str(*h, path);
+	if (hash_file(h, path) != 0)
+		return -1;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		p = line + strspn(line, " \t");
+		if (*p++ != '#')
+			continue;
+		p += strspn(p, " \t");
+		if (strncmp(p, "include", 7) != 0)
+			continue;
+		p += 7;
+		p += strspn(p, " \t");
+		if (*p++ != '"' || (q = strchr(p, '"')) == NULL)
+			continue;
+		*q = '\0';
+		/* Unresolved includes will make the compiler fail anyway */
+		if (resolve(path, p, inc, sizeof(inc)) == 0)
+			hash_source(h, inc, seen, nseen);
+	}
+	fclose(fp);
+	return 0;
+}
+
+static uint64_t build_key(const struct test *t)
+{
+	char *seen[MAX_INCLUDES];
+	int i, nseen = 0;
+	uint64_t h = env_key;
+
+	if (hash_source(&h, t->src, seen, &nseen) != 0)
+		h = 0;
+	for (i = 0; i < nseen; i++)
+		free(seen[i]);
+	return h;
+}
+
+#ifdef __linux__
+/* Look for a defined global "main" in the symbol table of an ELF object */
+static int elf_has_main(const unsigned char *img, size_t size)
+{
+	size_t i, j, nsym, symsz, shoff, shentsz, shnum;
+	size_t off, link_off, link_size;
+	const unsigned char *sh, *link, *sym;
+	unsigned name, shndx, bind;
+	int is64;
+
+	if (size < EI_NIDENT || memcmp(img, ELFMAG, SELFMAG) != 0)
+		return -1;
+	is64 = img[EI_CLASS] == ELFCLASS64;
+
+	if (is64) {
+		const Elf64_Ehdr *eh = (const void *)img;
+
+		if (size < sizeof(*eh))
+			return -1;
+		shoff = eh->e_shoff;
+		shentsz = eh->e_shentsize;
+		shnum = eh->e_shnum;
+		symsz = sizeof(Elf64_Sym);
+	} else {
+		const Elf32_Ehdr *eh = (const void *)img;
+
+		if (size < sizeof(*eh))
+			return -1;
+		shoff = eh->e_shoff;
+		shentsz = eh->e_shentsize;
+		shnum = eh->e_shnum;
+		symsz = sizeof(Elf32_Sym);
+	}
+	if (shoff + shnum * shentsz > size)
+		return -1;
+
+	for (i = 0; i < shnum; i++) {
+		sh = img + shoff + i * shentsz;
+		if (is64) {
+			const Elf64_Shdr *s = (const void *)sh;
+			const Elf64_Shdr *l;
+
+			if (s->sh_type != SHT_SYMTAB || s->sh_link >= shnum)
+				continue;
+			l = (const void *)(img + shoff + s->sh_link * shentsz);
+			off = s->sh_offset;
+			nsym = s->sh_size / symsz;
+			link_off = l->sh_offset;
+			link_size = l->sh_size;
+		} else {
+			const Elf32_Shdr *s = (const void *)sh;
+			const Elf32_Shdr *l;
+
+			if (s->sh_type != SHT_SYMTAB || s->sh_link >= shnum)
+				continue;
+			l = (const void *)(img + shoff + s->sh_link * shentsz);
+			off = s->sh_offset;
+			nsym = s->sh_size / symsz;
+			link_off = l->sh_offset;
+			link_size = l->sh_size;
+		}
+		if (off + nsym * symsz > size || link_off + link_size > size)
+			return -1;
+		link = img + link_off;
+
+		for (j = 0; j < nsym; j++) {
+			sym = img + off + j * symsz;
+			if (is64) {
+				const Elf64_Sym *s = (const void *)sym;
+
+				name = s->st_name;
+				shndx = s->st_shndx;
+				bind = ELF64_ST_BIND(s->st_info);
+			} else {
+				const Elf32_Sym *s = (const void *)sym;
+
+				name = s->st_name;
+				shndx = s->st_shndx;
+				bind = ELF32_ST_BIND(s->st_info);
+			}
+			if (name >= link_size || shndx == SHN_UNDEF ||
+			    bind != STB_GLOBAL)
+				continue;
+			if (strncmp((const char *)link + name, "main", link_size - name) == 0)
+				return 1;
+		}
+		return 0;
+	}
+	return 0;
+}
+#endif
+
+/*
+ * Does the object export main?  This is the "nm -g | grep ' T main'"
+ * probe of the Makefile, done without running nm for ELF objects.
+ */
+static int has_main(const char *obj)
+{
+	char cmd[4096], line[1024];
+	FILE *fp;
+	int ret = 0;
+
+#ifdef __linux__
+	unsigned char *img;
+	struct stat st;
+	int fd;
+
+	fd = open(obj, O_RDONLY);
+	if (fd != -1 && fstat(fd, &st) == 0 && (img = malloc(st.st_size)) != NULL) {
+		if (read(fd, img, st.st_size) == st.st_size)
+			ret = elf_has_main(img, st.st_size);
+		else
+			ret = -1;
+		free(img);
+		close(fd);
+		if (ret >= 0)
+			return ret;
+	} else if (fd != -1) {
+		close(fd);
+	}
+	ret = 0;
+#endif
+
+	snprintf(cmd, sizeof(cmd), "nm -g '%s'", obj);
+	fp = popen(cmd, "r");
+	if (fp == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), fp) != NULL)
+		if (strstr(line, " T main\n") != NULL)
+			ret = 1;
+	pclose(fp);
+	return ret;
+}
+
+static void add_words(char **argv, int *argc, const struct words *w)
+{
+	int i;
+
+	for (i = 0; i < w->n; i++)
+		argv[(*argc)++] = w->v[i];
+}
+
+static void start_job(struct job *j, enum step step)
+{
+	char **argv, *dir = NULL;
+	const char *base;
+	int argc = 0, fd;
+
+	j->step = step;
+	argv = calloc(cc.n + cflags.n + include.n + ldflags.n + 8, sizeof(*argv));
+	if (argv == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+
+	if (step == STEP_MAKE) {
+		base = strrchr(j->t->name, '/');
+		argv[argc++] = "make";
+		argv[argc++] = "-s";
+		if (base != NULL) {
+			dir = strndup(j->t->name, base - j->t->name);
+			argv[argc++] = "-C";
+			argv[argc++] = dir;
+			base++;
+		}
+		argv[argc++] = base ? (char *)base : j->t->name;
+		argv[argc] = NULL;
+		goto spawn;
+	}
+
+	add_words(argv, &argc, &cc);
+	add_words(argv, &argc, &cflags);
+	if (step == STEP_COMPILE) {
+		add_words(argv, &argc, &include);
+		argv[argc++] = "-c";
+		argv[argc++] = j->t->src;
+		argv[argc++] = "-o";
+		argv[argc++] = j->t->obj;
+	} else if (step == STEP_LINK) {
+		argv[argc++] = j->t->obj;
+		argv[argc++] = "-o";
+		argv[argc++] = j->t->exe;
+	} else if (step == STEP_SHARED) {
+		/* The test's own symbols win, as in an executable */
+		argv[argc++] = "-shared";
+		argv[argc++] = "-Wl,-Bsymbolic";
+		argv[argc++] = j->t->obj;
+		argv[argc++] = "-o";
+		argv[argc++] = j->t->so;
+	}
+	add_words(argv, &argc, &ldflags);
+	argv[argc] = NULL;
+
+spawn:
+	fflush(stdout);
+	j->pid = fork();
+	if (j->pid == -1) {
+		perror("pts-run: fork");
+		exit(2);
+	}
+	if (j->pid == 0) {
+		fd = open(j->log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd != -1) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		execvp(argv[0], argv);
+		perror(argv[0]);
+		_exit(127);
+	}
+	free(dir);
+	free(argv);
+}
+
+static void report_log(const struct job *j, const char *stage,
+		       const char *verdict, const char *label)
+{
+	char *out = NULL;
+	size_t len = 0;
+
+	read_file(j->log, &out, &len);
+	report(j->t->name, stage, verdict, label, out, len);
+	free(out);
+}
+
+/* Returns 1 when the job goes on with another step */
+static int job_done(struct job *j, int status)
+{
+	struct test *t = j->t;
+	int ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+	if (j->step == STEP_MAKE) {
+		if (!ok) {
+			report_log(j, "build", "FAILED", ": Make output: ");
+			unlink(t->exe);
+			return 0;
+		}
+		report(t->name, "build", "PASS", NULL, NULL, 0);
+		report(t->name, "link", "PASS", NULL, NULL, 0);
+		return 0;
+	}
+
+	if (j->step == STEP_COMPILE) {
+		if (!ok) {
+			report_log(j, "build", "FAILED", ": Compiler output: ");
+			/* Do not leave an older binary to be run */
+			unlink(t->exe);
+			cache_drop_build(t->name);
+			return 0;
+		}
+		report(t->name, "build", "PASS", NULL, NULL, 0);
+
+		if (!has_main(t->obj)) {
+			report(t->name, "link", "SKIP", NULL, NULL, 0);
+			cache_put_build(t->name, t->buildkey, 0);
+			return 0;
+		}
+		start_job(j, STEP_LINK);
+		return 1;
+	}
+
+	if (j->step == STEP_SHARED) {
+		/* 2: linked, but executed even with -z */
+		if (!ok)
+			unlink(t->so);
+		cache_put_build(t->name, t->buildkey, ok ? 1 : 2);
+		return 0;
+	}
+
+	if (!ok) {
+		report_log(j, "link", "FAILED", ". Linker output: ");
+		cache_drop_build(t->name);
+		return 0;
+	}
+	report(t->name, "link", "PASS", NULL, NULL, 0);
+	if (shared) {
+		start_job(j, STEP_SHARED);
+		return 1;
+	}
+	cache_put_build(t->name, t->buildkey, 1);
+	return 0;
+}
+
+/* Replay a cached build; returns 0 if it must be built again */
+static int replay(struct test *t, int use_cache)
+{
+	int main_;
+
+	t->buildkey = build_key(t);
+	if (!use_cache || t->buildkey == 0 ||
+	    !cache_get_build(t->name, t->buildkey, &main_))
+		return 0;
+	if (access(main_ ? t->exe : t->obj, F_OK) != 0)
+		return 0;
+	if (shared && main_ == 1 && access(t->so, F_OK) != 0)
+		return 0;
+
+	report(t->name, "build", "PASS", NULL, NULL, 0);
+	report(t->name, "link", main_ ? "PASS" : "SKIP", NULL, NULL, 0);
+	return 1;
+}
+
+void build_all(struct testlist *list, long jobs, const char *tmproot,
+	       int use_cache, int shared_objects)
+{
+	struct job *pool;
+	size_t next = 0;
+	long i, busy = 0;
+	pid_t pid;
+	int status;
+
+	shared = shared_objects;
+	build_init();
+
+	pool = calloc(jobs, sizeof(*pool));
+	if (pool == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+	for (i = 0; i < jobs; i++)
+		snprintf(pool[i].log, sizeof(pool[i].log), "%s/pts-build.%ld.%ld",
+			 tmproot, (long)getpid(), i);
+
+	for (;;) {
+		for (i = 0; i < jobs; i++) {
+			if (pool[i].t != NULL)
+				continue;
+			while (next < list->n &&
+			       (!list->v[next].build ||
+				(list->v[next].kind == KIND_C &&
+				 replay(&list->v[next], use_cache))))
+				next++;
+			if (next == list->n)
+				break;
+			pool[i].t = &list->v[next++];
+			start_job(&pool[i], pool[i].t->kind == KIND_SCAL ?
+					    STEP_MAKE : STEP_COMPILE);
+			busy++;
+		}
+		if (busy == 0)
+			break;
+
+		pid = wait(&status);
+		if (pid == -1) {
+			if (errno == EINTR)
+				continue;
+			perror("pts-run: wait");
+			exit(2);
+		}
+		for (i = 0; i < jobs; i++) {
+			if (pool[i].t == NULL || pool[i].pid != pid)
+				continue;
+			if (!job_done(&pool[i], status)) {
+				pool[i].t = NULL;
+				busy--;
+			}
+			break;
+		}
+	}
+
+	for (i = 0; i < jobs; i++)
+		unlink(pool[i].log);
+	free(pool);
+}
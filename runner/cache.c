@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Persistent build and result cache (.pts-cache at the top of the tree).
+ *
+ * Two kinds of records are kept, each with the key it was computed for:
+ *
+ * B name key main            the test was built; "main" says whether the
+ *                            object had a main() and was linked: 0 or 1,
+ *                            2 if its shared object for pts-run -z did
+ *                            not link, so that it is executed.
+ *                            key: the source and everything it includes,
+ *                            the compiler version and flags (see build.c).
+ * R name key verdict status len
+ * <len bytes of output>      the test ran with this outcome.
+ *                            key: the executable and the system under test
+ *                            (libc build id and kernel, see system_key()).
+ *
+ * A kernel upgrade thus invalidates the R records but not the B ones.
+ * HUNG and INTERRUPTED results depend on the conditions of the run and
+ * are never cached.
+ *
+ * Several pts-run may share the file, e.g. the shards of a run on one
+ * machine.  It is saved under a lock, merged with what the others saved
+ * since it was loaded: the records this run changed are its own, the
+ * others are taken from the file.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <link.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#include "runner.h"
+
+#define CACHE_MAGIC	"# pts-run cache v1"
+#define NBUCKETS	4096
+
+
+struct centry {
+	char type;		/* 'B' or 'R' */
+	char *name;
+	uint64_t key;
+	int main;		/* B */
+	enum verdict verdict;	/* R */
+	int status;		/* R */
+	char *output;		/* R */
+	size_t outlen;		/* R */
+	int dirty;		/* changed by this run */
+	struct centry *next;
+};
+
+static struct centry *buckets[NBUCKETS];
+
+uint64_t hash_bytes(uint64_t h, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+
+	while (len--) {
+		h ^= *p++;
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+uint64_t hash_str(uint64_t h, const char *s)
+{
+	/* The terminating NUL separates consecutive strings */
+	return hash_bytes(h, s, strlen(s) + 1);
+}
+
+/* Returns -1 if the file cannot be read */
+int hash_file(uint64_t *h, const char *path)
+{
+	unsigned char buf[65536];
+	ssize_t n;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return -1;
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		*h = hash_bytes(*h, buf, n);
+	close(fd);
+	return n < 0 ? -1 : 0;
+}
+
+#ifdef __linux__
+/* Hash the GNU build id notes of the C library loaded in this process */
+static int libc_note(struct dl_phdr_info *info, size_t size, void *data)
+{
+	uint64_t *h = data;
+	const ElfW(Nhdr) *nh;
+	const char *p, *end;
+	int i, found = 0;
+
+	(void)size;
+	if (strstr(info->dlpi_name, "/libc.so") == NULL)
+		return 0;
+
+	for (i = 0; i < info->dlpi_phnum; i++) {
+		if (info->dlpi_phdr[i].p_type != PT_NOTE)
+			continue;
+		p = (const char *)(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+		end = p + info->dlpi_phdr[i].p_memsz;
+		while (p + sizeof(*nh) <= end) {
+			nh = (const ElfW(Nhdr) *)p;
+			p += sizeof(*nh) + ((nh->n_namesz + 3) & ~3);
+			if (nh->n_type == NT_GNU_BUILD_ID) {
+				*h = hash_bytes(*h, p, nh->n_descsz);
+				found = 1;
+			}
+			p += (nh->n_descsz + 3) & ~3;
+		}
+	}
+	*h = hash_str(*h, info->dlpi_name);
+	return found;
+}
+#endif
+
+/* Fingerprint of the system under test: C library and kernel */
+uint64_t system_key(void)
+{
+	uint64_t h = FNV_OFFSET;
+	struct utsname u;
+	char buf[256];
+	int found = 0;
+
+#ifdef __linux__
+	found = dl_iterate_phdr(libc_note, &h);
+#endif
+	if (!found) {
+		/* No build id: settle for the version string */
+#ifdef _CS_GNU_LIBC_VERSION
+		if (confstr(_CS_GNU_LIBC_VERSION, buf, sizeof(buf)) > 0)
+			h = hash_str(h, buf);
+#endif
+	}
+
+	if (uname(&u) == 0) {
+		h = hash_str(h, u.sysname);
+		h = hash_str(h, u.release);
+		h = hash_str(h, u.version);
+		h = hash_str(h, u.machine);
+	}
+	return h;
+}
+
+static unsigned bucket(char type, const char *name)
+{
+	return hash_str(hash_bytes(FNV_OFFSET, &type, 1), name) % NBUCKETS;
+}
+
+static struct centry *lookup(char type, const char *name)
+{
+	struct centry *e;
+
+	for (e = buckets[bucket(type, name)]; e != NULL; e = e->next)
+		if (e->type == type && strcmp(e->name, name) == 0)
+			return e;
+	return NULL;
+}
+
+static struct centry *get(char type, const char *name)
+{
+	struct centry *e = lookup(type, name);
+	unsigned b;
+
+	if (e != NULL) {
+		free(e->output);
+		e->output = NULL;
+		e->outlen = 0;
+		return e;
+	}
+
+	e = calloc(1, sizeof(*e));
+	if (e == NULL || (e->name = strdup(name)) == NULL) {
+		perror("pts-run: cache");
+		exit(2);
+	}
+	e->type = type;
+	b = bucket(type, name);
+	e->next = buckets[b];
+	buckets[b] = e;
+	return e;
+}
+
+/*
+ * Lock the file at path, creating it empty if needed, against the other
+ * processes which save it.  Returns the descriptor which holds the lock,
+ * to close once the file is replaced, or -1.
+ */
+int lock_path(const char *path)
+{
+	struct stat a, b;
+	int fd;
+
+	for (;;) {
+		fd = open(path, O_RDONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (fd == -1)
+			return -1;
+		while (flock(fd, LOCK_EX) == -1) {
+			if (errno != EINTR) {
+				close(fd);
+				return -1;
+			}
+		}
+		/* Another process may have renamed a new file over it */
+		if (fstat(fd, &a) == 0 && stat(path, &b) == 0 &&
+		    a.st_dev == b.st_dev && a.st_ino == b.st_ino)
+			return fd;
+		close(fd);
+	}
+}
+
+/* With merge, the records changed by this run are kept as they are */
+static void load(const char *path, int merge)
+{
+	char line[4096], name[4096];
+	unsigned long long key;
+	struct centry *e;
+	int main_, verdict, status, b;
+	size_t len;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return;
+
+	if (fgets(line, sizeof(line), fp) == NULL ||
+	    strncmp(line, CACHE_MAGIC, strlen(CACHE_MAGIC)) != 0) {
+		fclose(fp);
+		return;
+	}
+
+	/* The file holds the records which this run did not change */
+	for (b = 0; merge && b < NBUCKETS; b++)
+		for (e = buckets[b]; e != NULL; e = e->next)
+			if (!e->dirty)
+				e->key = 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "B %4095s %llx %d", name, &key, &main_) == 3) {
+			if (merge && (e = lookup('B', name)) != NULL && e->dirty)
+				continue;
+			e = get('B', name);
+			e->key = key;
+			e->main = main_;
+		} else if (sscanf(line, "R %4095s %llx %d %d %zu", name, &key,
+				  &verdict, &status, &len) == 5) {
+			if (verdict < 0 || verdict >= V_NVERDICTS)
+				break;
+			if (merge && (e = lookup('R', name)) != NULL && e->dirty) {
+				if (fseek(fp, (long)len + 1, SEEK_CUR) != 0)
+					break;
+				continue;
+			}
+			e = get('R', name);
+			e->key = key;
+			e->verdict = verdict;
+			e->status = status;
+			e->output = malloc(len + 1);
+			if (e->output == NULL || fread(e->output, 1, len, fp) != len) {
+				/* Truncated file: forget this entry's key */
+				e->key = 0;
+				break;
+			}
+			e->output[len] = '\0';
+			e->outlen = len;
+			fgetc(fp);	/* the newline after the output */
+		} else {
+			break;
+		}
+	}
+	fclose(fp);
+}
+
+/* A missing or unreadable cache is simply empty */
+void cache_load(const char *path)
+{
+	load(path, 0);
+}
+
+/* Written to a temporary file first, so the cache is never half-written */
+int cache_save(const char *path)
+{
+	char tmp[4096];
+	struct centry *e;
+	FILE *fp;
+	int b, lock;
+
+	lock = lock_path(path);
+	load(path, 1);
+
+	snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+	fp = fopen(tmp, "w");
+	if (fp == NULL) {
+		if (lock != -1)
+			close(lock);
+		return -1;
+	}
+
+	fprintf(fp, "%s\n", CACHE_MAGIC);
+	for (b = 0; b < NBUCKETS; b++) {
+		for (e = buckets[b]; e != NULL; e = e->next) {
+			if (e->key == 0)
+				continue;
+			if (e->type == 'B') {
+				fprintf(fp, "B %s %llx %d\n", e->name,
+					(unsigned long long)e->key, e->main);
+			} else {
+				fprintf(fp, "R %s %llx %d %d %zu\n", e->name,
+					(unsigned long long)e->key, e->verdict,
+					e->status, e->outlen);
+				fwrite(e->output, 1, e->outlen, fp);
+				fputc('\n', fp);
+			}
+		}
+	}
+
+	if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+		unlink(tmp);
+		if (lock != -1)
+			close(lock);
+		return -1;
+	}
+	if (lock != -1)
+		close(lock);
+	return 0;
+}
+
+/* Returns 1 and the "main" flag if the build is cached for this key */
+int cache_get_build(const char *name, uint64_t key, int *main_)
+{
+	struct centry *e = lookup('B', name);
+
+	if (e == NULL || e->key != key)
+		return 0;
+	*main_ = e->main;
+	return 1;
+}
+
+void cache_put_build(const char *name, uint64_t key, int main_)
+{
+	struct centry *e = get('B', name);
+
+	e->key = key;
+	e->main = main_;
+	e->dirty = 1;
+}
+
+void cache_drop_build(const char *name)
+{
+	struct centry *e = lookup('B', name);
+
+	if (e != NULL) {
+		e->key = 0;
+		e->dirty = 1;
+	}
+}
+
+/* Returns 1 and fills the outcome of t if its result is cached for this key */
+int cache_get_run(struct test *t, uint64_t key, const char **output, size_t *len)
+{
+	struct centry *e = lookup('R', t->name);
+
+	if (e == NULL || e->key != key)
+		return 0;
+	t->verdict = e->verdict;
+	t->status = e->status;
+	*output = e->output ? e->output : "";
+	*len = e->outlen;
+	return 1;
+}
+
+void cache_put_run(const struct test *t, uint64_t key, const char *output, size_t len)
+{
+	struct centry *e;
+
+	if (t->verdict == V_HUNG || t->verdict == V_INTERRUPTED) {
+		e = lookup('R', t->name);
+		if (e != NULL) {
+			e->key = 0;
+			e->dirty = 1;
+		}
+		return;
+	}
+
+	e = get('R', t->name);
+	e->dirty = 1;
+	e->key = key;
+	e->verdict = t->verdict;
+	e->status = t->status;
+	e->output = malloc(len + 1);
+	if (e->output == NULL) {
+		e->key = 0;
+		return;
+	}
+	memcpy(e->output, output, len);
+	e->output[len] = '\0';
+	e->outlen = len;
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Per-test cgroups (cgroup v2, Linux only).
+ *
+ * Where pts-run may create cgroups below its own, every test runs in a
+ * cgroup of its own:
+ *
+ *   <pts-run's cgroup>/pts-run.PID/testN
+ *
+ * RUNPOLICY may bound the processes, memory and CPU time of a test (the
+ * pids=, memory= and cpu= keys, written to pids.max, memory.max and
+ * cpu.max), so that a test which forks or allocates "until failure" only
+ * exhausts its own share of the machine.  Whatever the limits, the peak
+ * memory and process counts and the CPU time of the test and of all its
+ * processes are recorded in the results (see results.c), and anything
+ * the test left behind is killed with it, even outside its process group.
+ *
+ * Limits need the controllers to be enabled for our cgroup, which the
+ * "no internal processes" rule of cgroup v2 forbids while other processes
+ * live in it, unless it is the root.  When pts-run is alone in its cgroup
+ * (e.g. started with "systemd-run --scope -p Delegate=yes"), it moves to
+ * a "pts-run" leaf beside the tests' cgroups to enable them.  Without the
+ * controllers the tests still get cgroups, and what is accounted anyway.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "runner.h"
+
+#ifdef __linux__
+static const char *controllers[] = { "cpu", "memory", "pids" };
+
+static char *top;		/* NULL when the tests have no cgroups */
+static unsigned long seq;
+static char **pending;		/* test cgroups still to remove */
+static size_t npending;
+
+static int write_str(const char *dir, const char *file, const char *s)
+{
+	char path[4096];
+	size_t len = strlen(s);
+	int fd, ret = 0, err;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	if (write(fd, s, len) != (ssize_t)len)
+		ret = -1;
+	err = errno;
+	close(fd);
+	errno = err;
+	return ret;
+}
+
+static char *read_str(const char *dir, const char *file)
+{
+	char path[4096], *buf;
+	size_t len;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if (read_file(path, &buf, &len) != 0)
+		return NULL;
+	return buf;
+}
+
+static long long read_value(const char *dir, const char *file)
+{
+	long long v = -1;
+	char *buf;
+
+	buf = read_str(dir, file);
+	if (buf != NULL && sscanf(buf, "%lld", &v) != 1)
+		v = -1;
+	free(buf);
+	return v;
+}
+
+/* "key value" lines, as in cpu.stat and memory.events */
+static long long read_key(const char *dir, const char *file, const char *key)
+{
+	size_t klen = strlen(key);
+	long long v = -1;
+	char *buf, *p;
+
+	buf = read_str(dir, file);
+	for (p = buf; p != NULL; p = strchr(p, '\n')) {
+		if (*p == '\n')
+			p++;
+		if (strncmp(p, key, klen) == 0 && p[klen] == ' ') {
+			v = atoll(p + klen + 1);
+			break;
+		}
+	}
+	free(buf);
+	return v;
+}
+
+/* The directory of our cgroup in the cgroup2 hierarchy, or NULL */
+static char *own_cgroup(void)
+{
+	char line[4096], root[4096], mnt[4096], *dir, *rel = NULL;
+	size_t rlen;
+	FILE *fp;
+
+	mnt[0] = '\0';
+	fp = fopen("/proc/self/mountinfo", "r");
+	if (fp == NULL)
+		return NULL;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strstr(line, " - cgroup2 ") != NULL &&
+		    sscanf(line, "%*s %*s %*s %4095s %4095s", root, mnt) == 2)
+			break;
+		mnt[0] = '\0';
+	}
+	fclose(fp);
+	if (mnt[0] == '\0')
+		return NULL;
+
+	fp = fopen("/proc/self/cgroup", "r");
+	if (fp == NULL)
+		return NULL;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "0::", 3) == 0) {
+			line[strcspn(line, "\n")] = '\0';
+			rel = line + 3;
+			break;
+		}
+	}
+	fclose(fp);
+	if (rel == NULL)
+		return NULL;
+
+	/* The mount may show only part of the hierarchy */
+	if (strcmp(root, "/") != 0) {
+		rlen = strlen(root);
+		if (strncmp(rel, root, rlen) != 0 ||
+		    (rel[rlen] != '/' && rel[rlen] != '\0'))
+			return NULL;
+		rel += rlen;
+	}
+	if (asprintf(&dir, "%s%s", mnt, rel) == -1)
+		return NULL;
+	return dir;
+}
+
+/* Whether we are the only process in that cgroup */
+static int alone_in(const char *dir)
+{
+	char *buf, *end;
+	int ret;
+
+	buf = read_str(dir, "cgroup.procs");
+	if (buf == NULL)
+		return 0;
+	ret = strtol(buf, &end, 10) == getpid() && end != buf &&
+	      strspn(end, "\n") == strlen(end);
+	free(buf);
+	return ret;
+}
+
+/* Whether a controller is in a cgroup.controllers list */
+static int has_word(const char *list, const char *word)
+{
+	size_t len = strlen(word);
+	const char *p;
+
+	for (p = list; (p = strstr(p, word)) != NULL; p += len)
+		if ((p == list || p[-1] == ' ') &&
+		    (p[len] == ' ' || p[len] == '\n' || p[len] == '\0'))
+			return 1;
+	return 0;
+}
+
+/* Returns -1 when the tests cannot have cgroups of their own */
+int cgroup_init(void)
+{
+	char path[4096], ctl[16], *base, *avail;
+	size_t i;
+
+	base = own_cgroup();
+	if (base == NULL)
+		return -1;
+	snprintf(path, sizeof(path), "%s/pts-run.%ld", base, (long)getpid());
+	if (mkdir(path, 0755) != 0) {
+		free(base);
+		return -1;
+	}
+	top = strdup(path);
+	if (top == NULL) {
+		rmdir(path);
+		free(base);
+		return -1;
+	}
+
+	for (i = 0; i < sizeof(controllers) / sizeof(controllers[0]); i++) {
+		snprintf(ctl, sizeof(ctl), "+%s", controllers[i]);
+		if (write_str(base, "cgroup.subtree_control", ctl) == 0 ||
+		    errno != EBUSY || !alone_in(base))
+			continue;
+		snprintf(path, sizeof(path), "%s/pts-run", base);
+		if ((mkdir(path, 0755) == 0 || errno == EEXIST) &&
+		    write_str(path, "cgroup.procs", "0") == 0)
+			write_str(base, "cgroup.subtree_control", ctl);
+	}
+
+	/* Hand down to the tests whatever we got */
+	avail = read_str(top, "cgroup.controllers");
+	for (i = 0; avail != NULL && i < sizeof(controllers) / sizeof(controllers[0]); i++) {
+		if (!has_word(avail, controllers[i]))
+			continue;
+		snprintf(ctl, sizeof(ctl), "+%s", controllers[i]);
+		write_str(top, "cgroup.subtree_control", ctl);
+	}
+	free(avail);
+	free(base);
+	return 0;
+}
+
+/* "50%" of a CPU in cpu.max terms */
+static void cpu_max(const char *pct, char *buf, size_t size)
+{
+	snprintf(buf, size, "%ld 100000", atol(pct) * 1000);
+}
+
+static void set_limit(const char *dir, const char *file, const char *value)
+{
+	static int warned[3];
+	int w;
+
+	if (value == NULL || write_str(dir, file, value) == 0)
+		return;
+	w = file[0] == 'p' ? 0 : file[0] == 'm' ? 1 : 2;
+	if (!warned[w]) {
+		fprintf(stderr, "pts-run: cannot set %s, tests run without "
+			"that limit\n", file);
+		warned[w] = 1;
+	}
+}
+
+/* Before the test starts: its cgroup, with the limits from RUNPOLICY */
+void cgroup_create(struct test *t)
+{
+	static int warned;
+	char path[4096], cpu[64];
+
+	t->cgroup = NULL;
+	memset(&t->cg, 0xff, sizeof(t->cg));
+
+	if (top == NULL) {
+		if (!warned && (t->pids_max || t->memory_max || t->cpu_max)) {
+			fprintf(stderr, "pts-run: no cgroup v2 of our own, "
+				"tests run without resource limits\n");
+			warned = 1;
+		}
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/test%lu", top, ++seq);
+	if (mkdir(path, 0755) != 0)
+		return;
+	t->cgroup = strdup(path);
+	if (t->cgroup == NULL) {
+		rmdir(path);
+		return;
+	}
+
+	set_limit(path, "pids.max", t->pids_max);
+	if (t->memory_max != NULL) {
+		set_limit(path, "memory.max", t->memory_max);
+		/* An OOM kill takes the whole test, not one of its processes */
+		write_str(path, "memory.oom.group", "1");
+	}
+	if (t->cpu_max != NULL) {
+		cpu_max(t->cpu_max, cpu, sizeof(cpu));
+		set_limit(path, "cpu.max", cpu);
+	}
+}
+
+/* In the child, before the test runs */
+void cgroup_enter(const char *dir)
+{
+	if (dir != NULL && *dir != '\0')
+		write_str(dir, "cgroup.procs", "0");
+}
+
+static void kill_all(const char *dir)
+{
+	char *buf, *p, *end;
+	long pid;
+
+	/* cgroup.kill is Linux 5.14 */
+	if (write_str(dir, "cgroup.kill", "1") == 0)
+		return;
+	buf = read_str(dir, "cgroup.procs");
+	for (p = buf; p != NULL; p = end) {
+		pid = strtol(p, &end, 10);
+		if (end == p)
+			break;
+		kill(pid, SIGKILL);
+	}
+	free(buf);
+}
+
+/* The killed processes leave their cgroup shortly after */
+static void remove_pending(void)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < npending; i++) {
+		if (rmdir(pending[i]) == 0 || errno != EBUSY)
+			free(pending[i]);
+		else
+			pending[n++] = pending[i];
+	}
+	npending = n;
+}
+
+/* Once the test has exited: its usage, then away with the cgroup */
+void cgroup_finish(struct test *t)
+{
+	char **p;
+
+	if (t->cgroup == NULL)
+		return;
+
+	kill_all(t->cgroup);
+	t->cg.memory_peak = read_value(t->cgroup, "memory.peak");
+	t->cg.pids_peak = read_value(t->cgroup, "pids.peak");
+	t->cg.cpu_usec = read_key(t->cgroup, "cpu.stat", "usage_usec");
+	t->cg.user_usec = read_key(t->cgroup, "cpu.stat", "user_usec");
+	t->cg.system_usec = read_key(t->cgroup, "cpu.stat", "system_usec");
+	t->cg.throttled_usec = read_key(t->cgroup, "cpu.stat", "throttled_usec");
+	t->cg.oom_kill = read_key(t->cgroup, "memory.events", "oom_kill");
+
+	remove_pending();
+	if (rmdir(t->cgroup) != 0 && errno == EBUSY) {
+		p = realloc(pending, (npending + 1) * sizeof(*pending));
+		if (p != NULL) {
+			pending = p;
+			pending[npending++] = t->cgroup;
+			t->cgroup = NULL;
+		}
+	}
+	free(t->cgroup);
+	t->cgroup = NULL;
+}
+
+void cgroup_cleanup(void)
+{
+	int i;
+
+	if (top == NULL)
+		return;
+	for (i = 0; npending > 0 && i < 100; i++) {
+		remove_pending();
+		if (npending > 0)
+			usleep(10000);
+	}
+	rmdir(top);
+	free(pending);
+	free(top);
+	top = NULL;
+}
+
+#else /* !__linux__ */
+
+int cgroup_init(void)
+{
+	return -1;
+}
+
+void cgroup_create(struct test *t)
+{
+	static int warned;
+
+	t->cgroup = NULL;
+	memset(&t->cg, 0xff, sizeof(t->cg));
+	if (!warned && (t->pids_max || t->memory_max || t->cpu_max)) {
+		fprintf(stderr, "pts-run: no cgroups, tests run without "
+			"resource limits\n");
+		warned = 1;
+	}
+}
+
+void cgroup_enter(const char *dir)
+{
+	(void)dir;
+}
+
+void cgroup_finish(struct test *t)
+{
+	(void)t;
+}
+
+void cgroup_cleanup(void)
+{
+}
+
+#endif
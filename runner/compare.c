@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * pts-compare: find what got slower between two or more sets of results,
+ * e.g. before and after a kernel or libc upgrade.
+ *
+ * The syntax is:
+ * $ runner/pts-compare [-a alpha] [-r percent] [-k ranges] [-o html]
+ *                      base[,base...] set[,set...] ...
+ *
+ * Each set is a comma-separated list of files, compared with the first
+ * set.  A file is either the JSON Lines written by pts-run -J, or the
+ * output of a test run by hand (what do-plot reads), which then stands
+ * for a test named after the file.  Run the tests several times in each
+ * set: every run is a sample.
+ *
+ * Three things are compared, test by test:
+ *
+ * -> the verdicts: a test which passed in every run of the base and
+ *    does not any more is a regression, whatever its timings;
+ * -> the durations of the runs (wall_us), with a Mann-Whitney U test:
+ *    does one set take longer than the other, without assuming anything
+ *    on the shape of their distributions.  The normal approximation is
+ *    used, with the correction for ties and continuity: it takes at least
+ *    4 runs in each set to get below 5%;
+ * -> the scalability series, the "# COLUMNS n X Y1 Y2..." dumps of the
+ *    stress tests (built with PLOT_OUTPUT).  The common range of X is
+ *    cut into -k ranges, and in each of them the slope of the linear
+ *    fit of each Y (as mes_fit() would fit it, see measure.h) is
+ *    compared with a z test on the difference of the slopes, and the
+ *    level of Y with a Mann-Whitney U test.  The change is the growth of
+ *    Y over the range which the new slope adds, relative to the base
+ *    level: "fork() slope doubled at 2000-3000 processes".
+ *
+ * With hundreds of tests, some differences are significant at 5% by
+ * chance alone: the p-values of a set are adjusted for that (Benjamini
+ * and Hochberg), so that at most a fraction alpha (-a, 0.05 by default)
+ * of what is reported is a false alarm.  Changes smaller than -r percent
+ * (10 by default), significant or not, are not reported either.
+ *
+ * The regressions and improvements of each set are ranked by size, as
+ * text on stdout and with -o, as an HTML page.  pts-compare exits with
+ * PTS_FAIL when there is a regression.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "posixtest.h"
+#include "runner.h"
+
+#define DEFAULT_ALPHA	0.05
+#define DEFAULT_CHANGE	10
+#define DEFAULT_RANGES	4
+#define MIN_POINTS	5	/* of a series in a range, for a fit */
+
+/* One Y column of the "# COLUMNS" dumps of a test, every run pooled */
+struct series {
+	char *xname, *yname;
+	double *x, *y;
+	size_t n, alloc;
+};
+
+/* A test in a set */
+struct entry {
+	const char *name;
+	unsigned runs, verdicts[V_NVERDICTS];
+	double *us;		/* durations */
+	size_t nus;
+	struct series *series;
+	int nseries;
+};
+
+struct set {
+	char *files;		/* as on the command line */
+	struct merged *rec;
+	size_t nrec;
+	struct entry *v;
+	size_t n;
+	char origin[512];	/* kernel, libc and load */
+};
+
+enum finding_kind { F_VERDICT, F_DURATION, F_SLOPE, F_LEVEL };
+
+struct finding {
+	const char *test;
+	enum finding_kind kind;
+	char what[256];
+	double change;		/* relative, +0.5 for 50% slower */
+	double p;
+};
+
+static struct {
+	double alpha;
+	double change;
+	int ranges;
+	const char *html;
+} opt = {
+	.alpha = DEFAULT_ALPHA,
+	.change = DEFAULT_CHANGE / 100.0,
+	.ranges = DEFAULT_RANGES,
+};
+
+static void usage(const char *prog)
+{
+	printf("\nUsage: \n");
+	printf("  $ %s [-a alpha] [-r percent] [-k ranges] [-o html]\n", prog);
+	printf("       base[,base...] set[,set...] ...\n");
+	printf("\nWhere:\n");
+	printf("  -a alpha    is the false discovery rate (default: %g),\n", DEFAULT_ALPHA);
+	printf("  -r percent  is the smallest change reported (default: %d),\n", DEFAULT_CHANGE);
+	printf("  -k ranges   is the number of load ranges of the scalability series\n");
+	printf("              in which the slopes are compared (default: %d),\n", DEFAULT_RANGES);
+	printf("  -o html     also writes the report as an HTML page,\n");
+	printf("  base, set   are JSON Lines files of pts-run -J, or outputs of tests;\n");
+	printf("              each set is compared with the base.\n\n");
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+	p = realloc(p, size);
+	if (p == NULL && size != 0) {
+		perror("pts-compare");
+		exit(PTS_UNRESOLVED);
+	}
+	return p;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double median(const double *v, size_t n)
+{
+	double *s, m;
+
+	s = xrealloc(NULL, n * sizeof(*s));
+	memcpy(s, v, n * sizeof(*s));
+	qsort(s, n, sizeof(*s), cmp_double);
+	m = n % 2 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+	free(s);
+	return m;
+}
+
+struct ranked {
+	double v;
+	int first;		/* from the first sample */
+};
+
+static int cmp_ranked(const void *a, const void *b)
+{
+	return cmp_double(&((const struct ranked *)a)->v,
+			  &((const struct ranked *)b)->v);
+}
+
+/* Two-sided p-value of the Mann-Whitney U test of samples a and b */
+static double mann_whitney(const double *a, size_t na, const double *b, size_t nb)
+{
+	struct ranked *r;
+	double rank_a = 0, ties = 0, u, mu, sigma, z, n = na + nb;
+	size_t i, j, k;
+
+	if (na == 0 || nb == 0)
+		return 1;
+
+	r = xrealloc(NULL, (na + nb) * sizeof(*r));
+	for (i = 0; i < na; i++)
+		r[i] = (struct ranked){ a[i], 1 };
+	for (i = 0; i < nb; i++)
+		r[na + i] = (struct ranked){ b[i], 0 };
+	qsort(r, na + nb, sizeof(*r), cmp_ranked);
+
+	/* Tied values share the mean of their ranks */
+	for (i = 0; i < na + nb; i = j) {
+		for (j = i + 1; j < na + nb && r[j].v == r[i].v; j++)
+			;
+		for (k = i; k < j; k++)
+			if (r[k].first)
+				rank_a += (i + j + 1) / 2.0;
+		ties += (double)(j - i) * (j - i) * (j - i) - (j - i);
+	}
+	free(r);
+
+	u = rank_a - na * (na + 1) / 2.0;
+	mu = na * (double)nb / 2;
+	sigma = sqrt(na * (double)nb / 12 * ((n + 1) - ties / (n * (n - 1))));
+	if (sigma == 0)
+		return 1;
+	z = (fabs(u - mu) - 0.5) / sigma;
+	if (z < 0)
+		z = 0;
+	return erfc(z / M_SQRT2);
+}
+
+/* Least squares slope of y over x, and its standard error */
+static int fit_slope(const double *x, const double *y, size_t n,
+		     double *a, double *se)
+{
+	double xavg = 0, yavg = 0, sxx = 0, sxy = 0, ssr = 0, e;
+	size_t i;
+
+	if (n < 3)
+		return -1;
+	for (i = 0; i < n; i++) {
+		xavg += x[i];
+		yavg += y[i];
+	}
+	xavg /= n;
+	yavg /= n;
+	for (i = 0; i < n; i++) {
+		sxx += (x[i] - xavg) * (x[i] - xavg);
+		sxy += (x[i] - xavg) * (y[i] - yavg);
+	}
+	if (sxx == 0)
+		return -1;
+	*a = sxy / sxx;
+	for (i = 0; i < n; i++) {
+		e = y[i] - yavg - *a * (x[i] - xavg);
+		ssr += e * e;
+	}
+	*se = sqrt(ssr / (n - 2) / sxx);
+	return 0;
+}
+
+/* Add a point to the series "yname" of e, creating it */
+static void add_point(struct entry *e, const char *xname, const char *yname,
+		      double x, double y)
+{
+	struct series *s = NULL;
+	int i;
+
+	for (i = 0; i < e->nseries; i++)
+		if (strcmp(e->series[i].yname, yname) == 0)
+			s = &e->series[i];
+	if (s == NULL) {
+		e->series = xrealloc(e->series, (e->nseries + 1) * sizeof(*s));
+		s = &e->series[e->nseries++];
+		memset(s, 0, sizeof(*s));
+		s->xname = strdup(xname);
+		s->yname = strdup(yname);
+		if (s->xname == NULL || s->yname == NULL) {
+			perror("pts-compare");
+			exit(PTS_UNRESOLVED);
+		}
+	}
+	if (s->n == s->alloc) {
+		s->alloc = s->alloc ? 2 * s->alloc : 256;
+		s->x = xrealloc(s->x, s->alloc * sizeof(*s->x));
+		s->y = xrealloc(s->y, s->alloc * sizeof(*s->y));
+	}
+	s->x[s->n] = x;
+	s->y[s->n] = y;
+	s->n++;
+}
+
+#define MAX_COLUMNS	64
+
+/*
+ * The rows of the "# COLUMNS n X Y1 Y2..." dumps in the output of a test:
+ * lines of n numbers, after that header.  The columns without a name are
+ * named by their number, as do-plot does; a 0 stands for no measure.
+ * The "[seconds.nanoseconds]" stamp which output() of testfrmw.c puts before every
+ * line is skipped.
+ */
+static void parse_series(struct entry *e, const char *output, size_t len)
+{
+	char names[MAX_COLUMNS][64], line[4096], *row, *tok, *save, *end, *p;
+	double v[MAX_COLUMNS];
+	const char *s = output, *nl;
+	int cols = 0, i, n;
+
+	while (s < output + len) {
+		nl = memchr(s, '\n', output + len - s);
+		if (nl == NULL)
+			nl = output + len;
+		snprintf(line, sizeof(line), "%.*s", (int)(nl - s), s);
+		s = nl + 1;
+		row = line;
+		if (*row == '[' && (p = strchr(row, ']')) != NULL)
+			row = p + 1;
+
+		p = strchr(row, '#');
+		if (p != NULL && strncmp(p + 1 + strspn(p + 1, " "), "COLUMNS", 7) == 0) {
+			p += 1 + strspn(p + 1, " ") + 7;
+			cols = strtol(p, &end, 10);
+			if (end == p || cols < 2 || cols > MAX_COLUMNS) {
+				cols = 0;
+				continue;
+			}
+			for (i = 0; i < cols; i++)
+				snprintf(names[i], sizeof(names[i]), "%d", i + 1);
+			tok = strtok_r(end, " \t", &save);
+			for (i = 0; i < cols && tok != NULL; i++) {
+				snprintf(names[i], sizeof(names[i]), "%s", tok);
+				tok = strtok_r(NULL, " \t", &save);
+			}
+			continue;
+		}
+		if (cols == 0)
+			continue;
+
+		n = 0;
+		for (tok = strtok_r(row, " \t", &save); tok != NULL;
+		     tok = strtok_r(NULL, " \t", &save)) {
+			if (n == cols)
+				break;
+			v[n] = strtod(tok, &end);
+			if (end == tok || *end != '\0')
+				break;
+			n++;
+		}
+		if (n != cols || tok != NULL)
+			continue;
+		for (i = 1; i < cols; i++)
+			if (v[i] != 0 && !isnan(v[i]))
+				add_point(e, names[0], names[i], v[0], v[i]);
+	}
+}
+
+/* The output of a test, as one record named after the file */
+static int read_output(const char *file, struct merged **v, size_t *n)
+{
+	const char *base = strrchr(file, '/');
+	size_t alloc = 0, got;
+	struct merged *m;
+	FILE *fp;
+
+	if (*n % 1024 == 0)
+		*v = xrealloc(*v, (*n + 1024) * sizeof(**v));
+	m = &(*v)[*n];
+	memset(m, 0, sizeof(*m));
+	fp = fopen(file, "r");
+	if (fp == NULL) {
+		perror(file);
+		return -1;
+	}
+	do {
+		if (m->len == alloc) {
+			alloc = alloc ? 2 * alloc : 65536;
+			m->output = xrealloc(m->output, alloc);
+		}
+		got = fread(m->output + m->len, 1, alloc - m->len, fp);
+		m->len += got;
+	} while (got > 0);
+	fclose(fp);
+	m->t.name = strdup(base != NULL ? base + 1 : file);
+	if (m->t.name == NULL) {
+		perror("pts-compare");
+		exit(PTS_UNRESOLVED);
+	}
+	m->t.verdict = -1;
+	m->cached = 1;		/* no duration */
+	m->t.slot = *n;
+	(*n)++;
+	return 0;
+}
+
+/* JSON Lines, or the output of a test */
+static int read_any(const char *file, struct merged **v, size_t *n)
+{
+	FILE *fp;
+	int c;
+
+	fp = fopen(file, "r");
+	if (fp == NULL) {
+		perror(file);
+		return -1;
+	}
+	while ((c = getc(fp)) == ' ' || c == '\t' || c == '\n')
+		;
+	fclose(fp);
+	return c == '{' ? merge_read(file, v, n) : read_output(file, v, n);
+}
+
+static int cmp_record(const void *a, const void *b)
+{
+	const struct merged *x = a, *y = b;
+	int c = strcmp(x->t.name, y->t.name);
+
+	return c != 0 ? c : (x->t.slot > y->t.slot) - (x->t.slot < y->t.slot);
+}
+
+static int load_set(struct set *set, char *files)
+{
+	struct entry *e = NULL;
+	struct merged *m;
+	char *file, *save;
+	size_t i;
+
+	set->files = strdup(files);
+	if (set->files == NULL) {
+		perror("pts-compare");
+		exit(PTS_UNRESOLVED);
+	}
+	for (file = strtok_r(files, ",", &save); file != NULL;
+	     file = strtok_r(NULL, ",", &save))
+		if (read_any(file, &set->rec, &set->nrec) != 0)
+			return -1;
+
+	qsort(set->rec, set->nrec, sizeof(*set->rec), cmp_record);
+	set->v = xrealloc(NULL, set->nrec * sizeof(*set->v));
+	for (i = 0; i < set->nrec; i++) {
+		m = &set->rec[i];
+		if (e == NULL || strcmp(e->name, m->t.name) != 0) {
+			e = &set->v[set->n++];
+			memset(e, 0, sizeof(*e));
+			e->name = m->t.name;
+			e->us = xrealloc(NULL, (set->nrec - i) * sizeof(*e->us));
+		}
+		if ((int)m->t.verdict >= 0) {
+			e->runs++;
+			e->verdicts[m->t.verdict]++;
+		}
+		if (!m->cached && m->t.verdict != V_HUNG &&
+		    m->t.verdict != V_INTERRUPTED)
+			e->us[e->nus++] = m->t.end.tv_sec * 1e6 +
+					  m->t.end.tv_nsec / 1e3;
+		if (m->output != NULL)
+			parse_series(e, m->output, m->len);
+		if (m->kernel != NULL && set->origin[0] == '\0')
+			snprintf(set->origin, sizeof(set->origin), "kernel %s, %s%s%s",
+				 m->kernel, m->libc != NULL ? m->libc : "unknown libc",
+				 m->load != NULL ? ", under load " : "",
+				 m->load != NULL ? m->load : "");
+	}
+	return 0;
+}
+
+static struct entry *find(struct set *set, const char *name)
+{
+	size_t lo = 0, hi = set->n, mid;
+	int c;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		c = strcmp(name, set->v[mid].name);
+		if (c == 0)
+			return &set->v[mid];
+		if (c < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+static struct finding *findings;
+static size_t nfindings, falloc;
+
+static struct finding *add_finding(const char *test, enum finding_kind kind,
+				   double change, double p)
+{
+	struct finding *f;
+
+	if (nfindings == falloc) {
+		falloc = falloc ? 2 * falloc : 256;
+		findings = xrealloc(findings, falloc * sizeof(*findings));
+	}
+	f = &findings[nfindings++];
+	f->test = test;
+	f->kind = kind;
+	f->change = change;
+	f->p = p;
+	f->what[0] = '\0';
+	return f;
+}
+
+static void compare_verdicts(const struct entry *b, const struct entry *e)
+{
+	struct finding *f;
+	unsigned bad;
+	int v;
+
+	if (b->runs == 0 || e->runs == 0)
+		return;
+	/* Compared only for the tests which always passed before */
+	if (b->verdicts[V_PASS] != b->runs || e->verdicts[V_PASS] == e->runs)
+		return;
+	bad = e->runs - e->verdicts[V_PASS];
+	for (v = 0; v < V_NVERDICTS && (v == V_PASS || e->verdicts[v] == 0); v++)
+		;
+	f = add_finding(e->name, F_VERDICT, INFINITY, 0);
+	snprintf(f->what, sizeof(f->what), "verdict: PASS -> %s (%u of %u runs)",
+		 verdict_names[v], bad, e->runs);
+}
+
+static void compare_durations(const struct entry *b, const struct entry *e)
+{
+	struct finding *f;
+	double mb, me;
+
+	if (b->nus < 2 || e->nus < 2)
+		return;
+	mb = median(b->us, b->nus);
+	me = median(e->us, e->nus);
+	if (mb <= 0)
+		return;
+	f = add_finding(e->name, F_DURATION, me / mb - 1,
+			mann_whitney(b->us, b->nus, e->us, e->nus));
+	snprintf(f->what, sizeof(f->what),
+		 "duration: median %.0f -> %.0f us (%zu and %zu runs)",
+		 mb, me, b->nus, e->nus);
+}
+
+/* The points of s with lo <= x < hi (x <= hi for the last range) */
+static size_t in_range(const struct series *s, double lo, double hi, int last,
+		       double *x, double *y)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < s->n; i++) {
+		if (s->x[i] < lo || s->x[i] > hi || (!last && s->x[i] == hi))
+			continue;
+		x[n] = s->x[i];
+		y[n] = s->y[i];
+		n++;
+	}
+	return n;
+}
+
+static void compare_series(const char *test, const struct series *b,
+			   const struct series *e)
+{
+	double lo, hi, from, to, *bx, *by, *ex, *ey, ab, seb, ae, see, level, z;
+	struct finding *f;
+	size_t nb, ne, i;
+	int r;
+
+	lo = INFINITY;
+	hi = -INFINITY;
+	for (i = 0; i < b->n; i++) {
+		lo = fmin(lo, b->x[i]);
+		hi = fmax(hi, b->x[i]);
+	}
+	from = lo;
+	to = hi;
+	lo = INFINITY;
+	hi = -INFINITY;
+	for (i = 0; i < e->n; i++) {
+		lo = fmin(lo, e->x[i]);
+		hi = fmax(hi, e->x[i]);
+	}
+	from = fmax(from, lo);
+	to = fmin(to, hi);
+	if (!(from < to))
+		return;
+
+	bx = xrealloc(NULL, 2 * b->n * sizeof(*bx));
+	by = bx + b->n;
+	ex = xrealloc(NULL, 2 * e->n * sizeof(*ex));
+	ey = ex + e->n;
+
+	for (r = 0; r < opt.ranges; r++) {
+		lo = from + (to - from) * r / opt.ranges;
+		hi = from + (to - from) * (r + 1) / opt.ranges;
+		nb = in_range(b, lo, hi, r == opt.ranges - 1, bx, by);
+		ne = in_range(e, lo, hi, r == opt.ranges - 1, ex, ey);
+		if (nb < MIN_POINTS || ne < MIN_POINTS)
+			continue;
+		level = median(by, nb);
+		if (level <= 0)
+			continue;
+
+		f = add_finding(test, F_LEVEL, median(ey, ne) / level - 1,
+				mann_whitney(by, nb, ey, ne));
+		snprintf(f->what, sizeof(f->what),
+			 "%s at %s %g-%g: median %g -> %g",
+			 b->yname, b->xname, lo, hi, level, median(ey, ne));
+
+		if (fit_slope(bx, by, nb, &ab, &seb) != 0 ||
+		    fit_slope(ex, ey, ne, &ae, &see) != 0)
+			continue;
+		z = fabs(ae - ab) / sqrt(seb * seb + see * see);
+		f = add_finding(test, F_SLOPE, (ae - ab) * (hi - lo) / level,
+				isnan(z) ? 1 : erfc(z / M_SQRT2));
+		if (ab > 0 && ae > 0)
+			snprintf(f->what, sizeof(f->what),
+				 "%s slope at %s %g-%g: %.3g -> %.3g (x%.2f)",
+				 b->yname, b->xname, lo, hi, ab, ae, ae / ab);
+		else
+			snprintf(f->what, sizeof(f->what),
+				 "%s slope at %s %g-%g: %.3g -> %.3g",
+				 b->yname, b->xname, lo, hi, ab, ae);
+	}
+	free(bx);
+	free(ex);
+}
+
+static int cmp_p(const void *a, const void *b)
+{
+	return cmp_double(&(*(struct finding *const *)a)->p,
+			  &(*(struct finding *const *)b)->p);
+}
+
+/*
+ * Benjamini-Hochberg: the k smallest p-values are significant for the
+ * largest k with p(k) <= k / m * alpha.  The others get a p of 1.
+ */
+static void adjust(void)
+{
+	struct finding **by_p;
+	size_t i, k = 0;
+
+	by_p = xrealloc(NULL, nfindings * sizeof(*by_p));
+	for (i = 0; i < nfindings; i++)
+		by_p[i] = &findings[i];
+	qsort(by_p, nfindings, sizeof(*by_p), cmp_p);
+	for (i = 0; i < nfindings; i++)
+		if (by_p[i]->p <= (i + 1) * opt.alpha / nfindings)
+			k = i + 1;
+	for (i = k; i < nfindings; i++)
+		by_p[i]->p = 1;
+	free(by_p);
+}
+
+static int cmp_change(const void *a, const void *b)
+{
+	const struct finding *x = a, *y = b;
+
+	if (fabs(x->change) != fabs(y->change))
+		return fabs(x->change) > fabs(y->change) ? -1 : 1;
+	return strcmp(x->test, y->test);
+}
+
+static int reported(const struct finding *f, int worse)
+{
+	if (f->p > opt.alpha || fabs(f->change) < opt.change)
+		return 0;
+	return worse ? f->change > 0 : f->change < 0;
+}
+
+static void html_text(FILE *fp, const char *s)
+{
+	for (; *s != '\0'; s++) {
+		if (*s == '<')
+			fputs("&lt;", fp);
+		else if (*s == '>')
+			fputs("&gt;", fp);
+		else if (*s == '&')
+			fputs("&amp;", fp);
+		else
+			fputc(*s, fp);
+	}
+}
+
+static void print_change(FILE *fp, const struct finding *f)
+{
+	if (isinf(f->change))
+		fprintf(fp, "%8s", "-");
+	else
+		fprintf(fp, "%+7.1f%%", 100 * f->change);
+}
+
+static unsigned report_set(const struct set *set, FILE *html)
+{
+	static const char *const titles[2] = { "Improvements", "Regressions" };
+	unsigned count[2] = { 0, 0 };
+	size_t i;
+	int worse;
+
+	qsort(findings, nfindings, sizeof(*findings), cmp_change);
+
+	printf("\n%s (%s):\n", set->files,
+	       set->origin[0] ? set->origin : "unknown system");
+	if (html != NULL) {
+		fputs("<h2>", html);
+		html_text(html, set->files);
+		fputs("</h2>\n<p>", html);
+		html_text(html, set->origin[0] ? set->origin : "unknown system");
+		fputs("</p>\n", html);
+	}
+
+	for (worse = 1; worse >= 0; worse--) {
+		for (i = 0; i < nfindings; i++)
+			count[worse] += reported(&findings[i], worse);
+		printf("\n %s: %u\n", titles[worse], count[worse]);
+		if (count[worse] == 0)
+			continue;
+		if (html != NULL)
+			fprintf(html, "<h3>%s</h3>\n<table>\n"
+				"<tr><th>change</th><th>p</th><th>test</th><th></th></tr>\n",
+				titles[worse]);
+		for (i = 0; i < nfindings; i++) {
+			if (!reported(&findings[i], worse))
+				continue;
+			print_change(stdout, &findings[i]);
+			printf("  p=%-7.2g %s  %s\n", findings[i].p,
+			       findings[i].test, findings[i].what);
+			if (html == NULL)
+				continue;
+			fprintf(html, "<tr class=\"%s\"><td>",
+				worse ? "worse" : "better");
+			print_change(html, &findings[i]);
+			fprintf(html, "</td><td>%.2g</td><td>", findings[i].p);
+			html_text(html, findings[i].test);
+			fputs("</td><td>", html);
+			html_text(html, findings[i].what);
+			fputs("</td></tr>\n", html);
+		}
+		if (html != NULL)
+			fputs("</table>\n", html);
+	}
+	return count[1];
+}
+
+static unsigned compare(struct set *base, struct set *set, FILE *html)
+{
+	const struct series *s;
+	struct entry *b, *e;
+	size_t i;
+	int j, k;
+
+	nfindings = 0;
+	for (i = 0; i < set->n; i++) {
+		e = &set->v[i];
+		b = find(base, e->name);
+		if (b == NULL)
+			continue;
+		compare_verdicts(b, e);
+		compare_durations(b, e);
+		for (j = 0; j < e->nseries; j++) {
+			s = &e->series[j];
+			for (k = 0; k < b->nseries; k++)
+				if (strcmp(b->series[k].yname, s->yname) == 0)
+					compare_series(e->name, &b->series[k], s);
+		}
+	}
+	adjust();
+	return report_set(set, html);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned regressions = 0;
+	struct set *sets;
+	FILE *html = NULL;
+	int c, i, nsets;
+
+	while ((c = getopt(argc, argv, "a:r:k:o:h")) != -1) {
+		switch (c) {
+		case 'a':
+			opt.alpha = atof(optarg);
+			break;
+		case 'r':
+			opt.change = atof(optarg) / 100;
+			break;
+		case 'k':
+			opt.ranges = atoi(optarg);
+			break;
+		case 'o':
+			opt.html = optarg;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return PTS_PASS;
+		default:
+			usage(argv[0]);
+			return PTS_UNRESOLVED;
+		}
+	}
+	nsets = argc - optind;
+	if (nsets < 2 || opt.alpha <= 0 || opt.alpha >= 1 || opt.change < 0 ||
+	    opt.ranges < 1) {
+		usage(argv[0]);
+		return PTS_UNRESOLVED;
+	}
+
+	sets = calloc(nsets, sizeof(*sets));
+	if (sets == NULL) {
+		perror("pts-compare");
+		return PTS_UNRESOLVED;
+	}
+	for (i = 0; i < nsets; i++)
+		if (load_set(&sets[i], argv[optind + i]) != 0)
+			return PTS_UNRESOLVED;
+
+	if (opt.html != NULL) {
+		html = fopen(opt.html, "w");
+		if (html == NULL) {
+			perror(opt.html);
+			return PTS_UNRESOLVED;
+		}
+		fputs("<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">"
+		      "<title>pts-compare</title>\n<style>\n"
+		      "body { font-family: sans-serif; }\n"
+		      "td { padding: 0 1em; font-family: monospace; }\n"
+		      "tr.worse td:first-child { color: #b00; }\n"
+		      "tr.better td:first-child { color: #070; }\n"
+		      "</style></head><body>\n<h1>Compared with ", html);
+		html_text(html, sets[0].files);
+		fputs("</h1>\n<p>", html);
+		html_text(html, sets[0].origin[0] ? sets[0].origin : "unknown system");
+		fputs("</p>\n", html);
+	}
+	printf("Compared with %s (%s)\n", sets[0].files,
+	       sets[0].origin[0] ? sets[0].origin : "unknown system");
+
+	for (i = 1; i < nsets; i++)
+		regressions += compare(&sets[0], &sets[i], html);
+
+	if (html != NULL) {
+		fputs("</body></html>\n", html);
+		if (fclose(html) != 0)
+			perror(opt.html);
+	}
+	return regressions ? PTS_FAIL : PTS_PASS;
+}
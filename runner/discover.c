@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Test discovery.  This follows the rules of "locate-test --buildable"
+ * and "locate-test --execs":
+ *
+ * NUMBER-*.c          is built into NUMBER-*.test
+ * NUMBER-NUMBER.c     runs NUMBER-NUMBER.test once it has been built
+ * NUMBER-NUMBER.sh    runs the script
+ *
+ * and anything with "-buildonly" in its name is never executed.
+ *
+ * From the top directory, the tests are read from the manifest written
+ * by locate-test when it is up to date, rather than from a walk.
+ *
+ * The scalability tests of the stress areas are only found when pts-run
+ * is given stress/ or a directory or test below it, as they run for
+ * minutes and load the whole machine:
+ *
+ * s-c*.c              is built by "make s-c*" in its directory, which
+ *                     must have a Makefile, and runs s-c*
+ *
+ * Those directories are always walked: the manifest does not list them.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "runner.h"
+
+static int add_test(struct testlist *list, const char *path, enum test_kind kind,
+		    int run)
+{
+	struct test *t;
+	size_t len = strlen(path);
+
+	if (list->n == list->alloc) {
+		size_t alloc = list->alloc ? 2 * list->alloc : 256;
+		struct test *v = realloc(list->v, alloc * sizeof(*v));
+
+		if (v == NULL)
+			return -1;
+		list->v = v;
+		list->alloc = alloc;
+	}
+
+	t = &list->v[list->n];
+	memset(t, 0, sizeof(*t));
+	t->kind = kind;
+	t->build = kind != KIND_SH;
+	t->run = run;
+
+	/* Strip the leading "./" as make does for its targets */
+	while (strncmp(path, "./", 2) == 0) {
+		path += 2;
+		len -= 2;
+	}
+
+	/* Both extensions (".c" and ".sh") are removed from the name */
+	t->name = strndup(path, len - (kind == KIND_SH ? 3 : 2));
+	if (t->name == NULL)
+		return -1;
+
+	if (kind == KIND_C) {
+		t->exe = malloc(strlen(t->name) + sizeof(".test"));
+		t->src = malloc(strlen(t->name) + sizeof(".c"));
+		t->obj = malloc(strlen(t->name) + sizeof(".o"));
+		t->so = malloc(strlen(t->name) + sizeof(".so"));
+		if (t->exe == NULL || t->src == NULL || t->obj == NULL ||
+		    t->so == NULL)
+			return -1;
+		sprintf(t->exe, "%s.test", t->name);
+		sprintf(t->src, "%s.c", t->name);
+		sprintf(t->obj, "%s.o", t->name);
+		sprintf(t->so, "%s.so", t->name);
+	} else if (kind == KIND_SCAL) {
+		t->exe = strdup(t->name);
+		t->src = strdup(path);
+		if (t->exe == NULL || t->src == NULL)
+			return -1;
+	} else {
+		t->exe = strdup(path);
+		if (t->exe == NULL)
+			return -1;
+	}
+
+	list->n++;
+	return 0;
+}
+
+/* Is the path stress/ or below?  See the scalability tests above */
+static int in_stress(const char *path)
+{
+	const char *p;
+
+	for (p = path; (p = strstr(p, "stress")) != NULL; p += 6)
+		if ((p == path || p[-1] == '/') && (p[6] == '\0' || p[6] == '/'))
+			return 1;
+	return 0;
+}
+
+/* Is there a Makefile in the directory of path? */
+static int has_makefile(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+	char mk[4096];
+
+	snprintf(mk, sizeof(mk), "%.*sMakefile",
+		 slash ? (int)(slash - path + 1) : 0, path);
+	return access(mk, R_OK) == 0;
+}
+
+/*
+ * Returns 1 for a test, and whether it is to be executed.  "path" is
+ * that of the file, under stress/ when "scal" is set.
+ */
+static int classify(const char *path, int scal, enum test_kind *kind,
+		    int *run)
+{
+	const char *base = strrchr(path, '/');
+
+	base = base ? base + 1 : path;
+	*run = strstr(base, "-buildonly") == NULL;
+
+	if (scal && fnmatch("s-c*.c", base, 0) == 0 && has_makefile(path)) {
+		*kind = KIND_SCAL;
+		*run = 1;
+		return 1;
+	}
+
+	if (fnmatch("[0-9]*-*.c", base, 0) == 0) {
+		*kind = KIND_C;
+		*run = *run && fnmatch("[0-9]*-[0-9]*.c", base, 0) == 0;
+		return 1;
+	}
+	if (*run && fnmatch("[0-9]*-[0-9]*.sh", base, 0) == 0) {
+		*kind = KIND_SH;
+		return 1;
+	}
+	return 0;
+}
+
+/* See locate-test for the format */
+#define MANIFEST_VERSION "# pts-manifest 1"
+
+struct mrecord {
+	char *path;		/* from the top directory */
+	enum test_kind kind;
+	int run;
+};
+
+static struct {
+	int state;		/* 0: not read yet, 1: usable, -1: not usable */
+	struct mrecord *v;
+	size_t n;
+} manifest;
+
+static int newer(const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec > b->tv_sec ||
+	       (a->tv_sec == b->tv_sec && a->tv_nsec > b->tv_nsec);
+}
+
+/*
+ * The manifest is up to date when none of its directories was modified
+ * after it, and the top directory has the same subdirectories: it is
+ * itself modified each time the manifest is written.
+ */
+static int manifest_read(const char *file)
+{
+	struct stat mst, st;
+	struct mrecord *r;
+	struct dirent *de;
+	char line[4096], *kind, *path, *nl;
+	size_t ntop = 0, alloc = 0;
+	DIR *d;
+	FILE *f;
+	int ret = -1;
+
+	f = fopen(file, "r");
+	if (f == NULL)
+		return -1;
+	if (fstat(fileno(f), &mst) != 0 || fgets(line, sizeof(line), f) == NULL ||
+	    strcmp(line, MANIFEST_VERSION "\n") != 0)
+		goto out;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		nl = strchr(line, '\n');
+		if (nl == NULL)
+			goto out;
+		*nl = '\0';
+		kind = strtok(line, "\t");
+		path = strtok(NULL, "\t");
+		if (kind == NULL || path == NULL)
+			goto out;
+
+		if (strcmp(kind, "dir") == 0) {
+			if (stat(path, &st) != 0 || newer(&st.st_mtim, &mst.st_mtim))
+				goto out;
+			ntop += strchr(path, '/') == NULL;
+			continue;
+		}
+		if (strcmp(kind, "run") != 0 && strcmp(kind, "build") != 0 &&
+		    strcmp(kind, "buildonly") != 0 && strcmp(kind, "sh") != 0)
+			continue;
+
+		if (manifest.n == alloc) {
+			alloc = alloc ? 2 * alloc : 1024;
+			r = realloc(manifest.v, alloc * sizeof(*r));
+			if (r == NULL)
+				goto out;
+			manifest.v = r;
+		}
+		r = &manifest.v[manifest.n];
+		r->path = strdup(path);
+		if (r->path == NULL)
+			goto out;
+		r->kind = strcmp(kind, "sh") == 0 ? KIND_SH : KIND_C;
+		r->run = strcmp(kind, "run") == 0 || r->kind == KIND_SH;
+		manifest.n++;
+	}
+
+	/* The top level directories were all checked above, count them */
+	d = opendir(".");
+	if (d == NULL)
+		goto out;
+	while ((de = readdir(d)) != NULL) {
+		if (de->d_name[0] == '.')
+			continue;
+		if (stat(de->d_name, &st) == 0 && S_ISDIR(st.st_mode))
+			ntop--;
+	}
+	closedir(d);
+	ret = ntop == 0 ? 0 : -1;
+out:
+	fclose(f);
+	return ret;
+}
+
+/*
+ * Add the tests of the manifest under the directory, which is relative
+ * to the top directory.  Returns 1 when the manifest cannot be used.
+ */
+static int manifest_discover(struct testlist *list, const char *dir)
+{
+	const char *file;
+	size_t i, len;
+	int ret = 0;
+
+	if (dir[0] == '/' || strstr(dir, "..") != NULL)
+		return 1;
+
+	if (manifest.state == 0) {
+		file = getenv("PTS_MANIFEST");
+		if (file == NULL || *file == '\0')
+			file = ".pts-manifest";
+		manifest.state = manifest_read(file) == 0 ? 1 : -1;
+	}
+	if (manifest.state < 0)
+		return 1;
+
+	while (strncmp(dir, "./", 2) == 0)
+		dir += 2;
+	if (strcmp(dir, ".") == 0)
+		dir = "";
+	len = strlen(dir);
+
+	for (i = 0; i < manifest.n && ret == 0; i++) {
+		const struct mrecord *r = &manifest.v[i];
+
+		if (len == 0 || (strncmp(r->path, dir, len) == 0 &&
+				 r->path[len] == '/'))
+			ret = add_test(list, r->path, r->kind, r->run);
+	}
+	return ret;
+}
+
+static int walk(struct testlist *list, const char *dir, int scal)
+{
+	DIR *d;
+	struct dirent *de;
+	struct stat st;
+	enum test_kind kind;
+	char *path;
+	int ret = 0, run;
+
+	d = opendir(dir);
+	if (d == NULL) {
+		fprintf(stderr, "pts-run: %s: %s\n", dir, strerror(errno));
+		return -1;
+	}
+
+	while ((de = readdir(d)) != NULL) {
+		if (de->d_name[0] == '.')
+			continue;
+
+		path = malloc(strlen(dir) + strlen(de->d_name) + 2);
+		if (path == NULL) {
+			ret = -1;
+			break;
+		}
+		sprintf(path, "%s/%s", dir, de->d_name);
+
+		if (lstat(path, &st) != 0) {
+			free(path);
+			continue;
+		}
+
+		if (S_ISDIR(st.st_mode))
+			ret = walk(list, path, scal);
+		else if (S_ISREG(st.st_mode) &&
+			 classify(path, scal, &kind, &run))
+			ret = add_test(list, path, kind, run);
+
+		free(path);
+		if (ret != 0)
+			break;
+	}
+
+	closedir(d);
+	return ret;
+}
+
+/*
+ * Add the tests found under "root" to the list.  "root" may also name
+ * a single test source or script.
+ */
+int discover(struct testlist *list, const char *root)
+{
+	struct stat st;
+	enum test_kind kind;
+	char *dir;
+	size_t len;
+	int ret, run, scal = in_stress(root);
+
+	if (stat(root, &st) != 0) {
+		fprintf(stderr, "pts-run: %s: %s\n", root, strerror(errno));
+		return -1;
+	}
+
+	if (!S_ISDIR(st.st_mode)) {
+		if (!classify(root, scal, &kind, &run)) {
+			fprintf(stderr, "pts-run: %s: not a test\n", root);
+			return -1;
+		}
+		return add_test(list, root, kind, run);
+	}
+
+	/* Avoid "dir//file" names when the root is given with a slash */
+	dir = strdup(root);
+	if (dir == NULL)
+		return -1;
+	len = strlen(dir);
+	while (len > 1 && dir[len - 1] == '/')
+		dir[--len] = '\0';
+
+	ret = scal ? 1 : manifest_discover(list, dir);
+	if (ret == 1)
+		ret = walk(list, dir, scal);
+	free(dir);
+	return ret;
+}
+
+static int cmp_test(const void *a, const void *b)
+{
+	return strcmp(((const struct test *)a)->name,
+		      ((const struct test *)b)->name);
+}
+
+/* find(1) order depends on the filesystem; always run in name order */
+void testlist_sort(struct testlist *list)
+{
+	qsort(list->v, list->n, sizeof(*list->v), cmp_test);
+}
+
+static void test_free(struct test *t)
+{
+	free(t->name);
+	free(t->exe);
+	free(t->src);
+	free(t->obj);
+	free(t->so);
+}
+
+/* Drop the tests which have nothing to execute (not built) */
+void testlist_prune(struct testlist *list)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < list->n; i++) {
+		if (access(list->v[i].exe, F_OK) == 0)
+			list->v[n++] = list->v[i];
+		else
+			test_free(&list->v[i]);
+	}
+	list->n = n;
+}
+
+/* Drop the build-only tests */
+void testlist_runnable(struct testlist *list)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < list->n; i++) {
+		if (list->v[i].run)
+			list->v[n++] = list->v[i];
+		else
+			test_free(&list->v[i]);
+	}
+	list->n = n;
+}
+
+/* Drop the tests i for which keep[i] is 0 */
+void testlist_keep(struct testlist *list, const char *keep)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < list->n; i++) {
+		if (keep[i])
+			list->v[n++] = list->v[i];
+		else
+			test_free(&list->v[i]);
+	}
+	list->n = n;
+}
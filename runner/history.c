@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Durations of the past runs of each test (.pts-history at the top of
+ * the tree), one line per test with the number of durations kept and its
+ * last HISTORY_KEEP wall times in microseconds, the latest first:
+ *
+ * conformance/interfaces/nanosleep/10000-1 3 5004127 5003310 5003998
+ *
+ * They serve two purposes:
+ *
+ * -> the queue is ordered longest first (see sched.c), so that the long
+ *    tests start at once rather than end a parallel run alone;
+ * -> once a test has HISTORY_MIN durations, it is HUNG after "adapt"
+ *    times the longest of them (pts-run -T; with so few runs, the longest
+ *    is the p99), if that is shorter than its budget (pts-run -t,
+ *    RUNPOLICY), but never before ADAPT_FLOOR_MS.
+ *    A hang is then found in seconds rather than minutes.  A test which
+ *    overruns such a timeout loses its history, so that it gets its full
+ *    budget the next time in case it has merely become slower.
+ *
+ * Only tests which completed are recorded: the duration of a HUNG or
+ * INTERRUPTED test says nothing of how long it takes.
+ *
+ * As the cache, the file is saved under a lock and merged with what the
+ * other pts-run which share it (the shards of a run) saved meanwhile.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+#define HISTORY_MAGIC	"# pts-run history v1"
+#define HISTORY_KEEP	32
+#define HISTORY_MIN	3
+#define ADAPT_FLOOR_MS	5000
+#define NBUCKETS	4096
+
+struct hentry {
+	char *name;
+	int n;
+	long us[HISTORY_KEEP];
+	int dirty;		/* changed by this run */
+	struct hentry *next;
+};
+
+static struct hentry *buckets[NBUCKETS];
+
+static struct hentry *lookup(const char *name)
+{
+	struct hentry *e;
+
+	for (e = buckets[hash_str(FNV_OFFSET, name) % NBUCKETS]; e != NULL; e = e->next)
+		if (strcmp(e->name, name) == 0)
+			return e;
+	return NULL;
+}
+
+static struct hentry *get(const char *name)
+{
+	struct hentry *e;
+	unsigned b;
+
+	e = lookup(name);
+	if (e != NULL)
+		return e;
+
+	e = calloc(1, sizeof(*e));
+	if (e == NULL || (e->name = strdup(name)) == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+	b = hash_str(FNV_OFFSET, name) % NBUCKETS;
+	e->next = buckets[b];
+	buckets[b] = e;
+	return e;
+}
+
+/* With merge, the tests recorded by this run are kept as they are */
+static void load(const char *path, int merge)
+{
+	char line[8192], name[4096], *p, *end;
+	struct hentry *e;
+	long v;
+	int n, off, b;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return;
+
+	if (fgets(line, sizeof(line), fp) == NULL ||
+	    strncmp(line, HISTORY_MAGIC, strlen(HISTORY_MAGIC)) != 0) {
+		fclose(fp);
+		return;
+	}
+
+	/* The file holds the tests which this run did not record */
+	for (b = 0; merge && b < NBUCKETS; b++)
+		for (e = buckets[b]; e != NULL; e = e->next)
+			if (!e->dirty)
+				e->n = 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%4095s %d%n", name, &n, &off) != 2 ||
+		    n < 0 || n > HISTORY_KEEP)
+			break;
+		if (merge && (e = lookup(name)) != NULL && e->dirty)
+			continue;
+		e = get(name);
+		for (p = line + off, e->n = 0; e->n < n; p = end) {
+			v = strtol(p, &end, 10);
+			if (end == p || v < 0)
+				break;
+			e->us[e->n++] = v;
+		}
+	}
+	fclose(fp);
+}
+
+/* A missing or unreadable file is simply empty */
+void history_load(const char *path)
+{
+	load(path, 0);
+}
+
+/* Written to a temporary file first, as the cache is */
+int history_save(const char *path)
+{
+	char tmp[4096];
+	struct hentry *e;
+	FILE *fp;
+	int b, i, lock;
+
+	lock = lock_path(path);
+	load(path, 1);
+
+	snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+	fp = fopen(tmp, "w");
+	if (fp == NULL) {
+		if (lock != -1)
+			close(lock);
+		return -1;
+	}
+
+	fprintf(fp, "%s\n", HISTORY_MAGIC);
+	for (b = 0; b < NBUCKETS; b++) {
+		for (e = buckets[b]; e != NULL; e = e->next) {
+			if (e->n == 0)
+				continue;
+			fprintf(fp, "%s %d", e->name, e->n);
+			for (i = 0; i < e->n; i++)
+				fprintf(fp, " %ld", e->us[i]);
+			fputc('\n', fp);
+		}
+	}
+
+	if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+		unlink(tmp);
+		if (lock != -1)
+			close(lock);
+		return -1;
+	}
+	if (lock != -1)
+		close(lock);
+	return 0;
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+	long x = *(const long *)a, y = *(const long *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Fill the expected and longest durations of t, 0 when unknown */
+void history_get(struct test *t)
+{
+	struct hentry *e = lookup(t->name);
+	long v[HISTORY_KEEP];
+
+	t->expect_us = 0;
+	t->longest_us = 0;
+	t->nruns = 0;
+	if (e == NULL || e->n == 0)
+		return;
+
+	memcpy(v, e->us, e->n * sizeof(*v));
+	qsort(v, e->n, sizeof(*v), cmp_long);
+	t->expect_us = v[e->n / 2];
+	t->longest_us = v[e->n - 1];
+	t->nruns = e->n;
+}
+
+/* The time after which t is HUNG, given its budget */
+long history_timeout(const struct test *t, long budget_ms, int adapt,
+		     int *adaptive)
+{
+	long ms;
+
+	*adaptive = 0;
+	if (adapt <= 0 || t->nruns < HISTORY_MIN)
+		return budget_ms;
+	ms = t->longest_us / 1000 * adapt;
+	if (ms < ADAPT_FLOOR_MS)
+		ms = ADAPT_FLOOR_MS;
+	if (ms >= budget_ms)
+		return budget_ms;
+	*adaptive = 1;
+	return ms;
+}
+
+void history_put(const struct test *t, long us)
+{
+	struct hentry *e;
+
+	if (t->verdict == V_HUNG || t->verdict == V_INTERRUPTED) {
+		/* Overran a timeout from its history: give it a fresh start */
+		if (t->adaptive && t->timedout && (e = lookup(t->name)) != NULL) {
+			e->n = 0;
+			e->dirty = 1;
+		}
+		return;
+	}
+
+	e = get(t->name);
+	e->dirty = 1;
+	if (e->n == HISTORY_KEEP)
+		e->n--;
+	memmove(e->us + 1, e->us, e->n * sizeof(*e->us));
+	e->us[0] = us;
+	e->n++;
+}
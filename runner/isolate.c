@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Per-test isolation helpers, called in the child between fork() and exec().
+ *
+ * Tests use fixed names for their semaphores, queues and shared memory
+ * objects ("/sem_open_1-1", "/fork_scal_sync", ...), so two tests which
+ * happen to pick the same name collide when they run at the same time.
+ * Where the system allows it, each test gets a private IPC namespace
+ * (message queues) and a private /dev/shm (named semaphores and shared
+ * memory).  As root, they are created directly; otherwise, in a user
+ * namespace of the test's own, where the runner's user and group are
+ * mapped to themselves.  Elsewhere the tests share the namespace, and
+ * those which use named IPC objects run alone (see policy_shared_ipc()).
+ *
+ * The CPU helpers bind a test to a range of the CPUs the runner itself
+ * was allowed to use, numbered from 0 (see sched.c).
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <linux/capability.h>
+#include <sys/mount.h>
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+#ifdef __linux__
+static int cpu_ids[CPU_SETSIZE];
+#endif
+static int ncpu_ids;
+
+#ifdef __linux__
+static int write_file(const char *path, const char *s)
+{
+	ssize_t len = strlen(s);
+	int fd, ret;
+
+	fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	ret = write(fd, s, len) == len ? 0 : -1;
+	close(fd);
+	return ret;
+}
+
+/* Unprivileged: the namespaces are owned by a new user namespace */
+static int unshare_user(void)
+{
+	char map[64];
+	uid_t uid = geteuid();
+	gid_t gid = getegid();
+
+	if (unshare(CLONE_NEWUSER | CLONE_NEWIPC | CLONE_NEWNS) != 0)
+		return -1;
+	/* The gid_map of an unprivileged process requires this */
+	if (write_file("/proc/self/setgroups", "deny") != 0 && errno != ENOENT)
+		return -1;
+	snprintf(map, sizeof(map), "%ld %ld 1", (long)uid, (long)uid);
+	if (write_file("/proc/self/uid_map", map) != 0)
+		return -1;
+	snprintf(map, sizeof(map), "%ld %ld 1", (long)gid, (long)gid);
+	return write_file("/proc/self/gid_map", map);
+}
+
+/*
+ * The user namespace gave us every capability in it: drop them, or the
+ * tests which run from the fork server would see no EACCES on their own
+ * objects.  An executed test loses them anyway, as it is not uid 0.
+ */
+static int drop_caps(void)
+{
+	struct __user_cap_header_struct hdr = { _LINUX_CAPABILITY_VERSION_3, 0 };
+	struct __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3];
+
+	memset(data, 0, sizeof(data));
+	return syscall(SYS_capset, &hdr, data);
+}
+#endif
+
+int isolate_ipc(void)
+{
+#ifdef __linux__
+	int userns = 0;
+
+	if (unshare(CLONE_NEWIPC | CLONE_NEWNS) != 0) {
+		if (errno != EPERM || unshare_user() != 0)
+			return -1;
+		userns = 1;
+	}
+
+	/* Do not let our private /dev/shm propagate back to the host */
+	if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) != 0)
+		return -1;
+	if (mount("pts-shm", "/dev/shm", "tmpfs", MS_NOSUID | MS_NODEV,
+		  "mode=1777") != 0)
+		return -1;
+
+	if (userns && drop_caps() != 0)
+		return -1;
+	return 0;
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/* Returns the number of CPUs available to the tests */
+int cpus_init(void)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int c;
+
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (c = 0; c < CPU_SETSIZE; c++)
+			if (CPU_ISSET(c, &set))
+				cpu_ids[ncpu_ids++] = c;
+		return ncpu_ids;
+	}
+#endif
+	/* We cannot bind anything; report a single CPU so nothing is reserved */
+	ncpu_ids = 0;
+	return 1;
+}
+
+/* Bind the calling process to the CPUs [first, first + count) */
+int isolate_cpus(int first, int count)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int c;
+
+	if (count == 0 || ncpu_ids == 0)
+		return 0;
+
+	CPU_ZERO(&set);
+	for (c = first; c < first + count && c < ncpu_ids; c++)
+		CPU_SET(cpu_ids[c], &set);
+	return sched_setaffinity(0, sizeof(set), &set);
+#else
+	(void)first;
+	(void)count;
+	return 0;
+#endif
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Background load (pts-run -L, pts-load): the tests run while other
+ * processes keep the machine busy, for their latencies under the noise of
+ * a production machine rather than on an idle one.
+ *
+ * A profile lists the loads, comma-separated:
+ *
+ *	cpu[=n]		n processes spinning (default: one per online CPU)
+ *	mem[=n]		n processes copying buffers larger than the caches
+ *	io[=n]		n processes writing a file, syncing it, dropping it
+ *			from the page cache and reading it back
+ *	fork[=n]	n processes forking and reaping children
+ *	timer[=hz]	one process woken hz times a second by a timer
+ *			(default: 1000)
+ *
+ * or is one of the presets below, e.g. "pts-run -L busy" or
+ * "pts-run -L cpu=2,timer=10000".  The files of the io load go to TMPDIR.
+ *
+ * The load processes count what they do in shared memory.  How much of
+ * it happened while a test ran goes to its results (see results.c):
+ *
+ *	"load":"cpu=8,mem=1","load_cpu_us":981220,"load_mem_mb":3072
+ *
+ * i.e. the CPU time the spinners got, the MiB copied or written and read,
+ * the forks and the timer wakeups.  They fall when the tests take the
+ * machine from the load, and so tell how loaded it actually was.
+ *
+ * The load processes form a process group of their own, led by a
+ * process which terminates it once pts-run has stopped the load or
+ * exited.
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE		/* MAP_ANONYMOUS */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "runner.h"
+
+#define MEM_BUFFER	(64 << 20)	/* larger than the last level cache */
+#define IO_FILE		(64 << 20)
+#define IO_CHUNK	(1 << 20)
+#define CPU_SPIN	(1 << 18)	/* iterations between two counts */
+
+/* As in the profiles; the results add "load_" and their unit */
+static const char *kind_names[LOAD_NKINDS] = {
+	[LOAD_CPU] = "cpu",
+	[LOAD_MEM] = "mem",
+	[LOAD_IO] = "io",
+	[LOAD_FORK] = "fork",
+	[LOAD_TIMER] = "timer",
+};
+
+const char *load_names[LOAD_NKINDS] = {
+	[LOAD_CPU] = "load_cpu_us",
+	[LOAD_MEM] = "load_mem_mb",
+	[LOAD_IO] = "load_io_mb",
+	[LOAD_FORK] = "load_forks",
+	[LOAD_TIMER] = "load_timer_ticks",
+};
+
+static const struct {
+	const char *name;
+	const char *profile;
+} presets[] = {
+	{ "light", "cpu=1,timer=250" },
+	{ "busy", "cpu,mem=1,io=1" },
+	{ "storm", "cpu,mem=2,io=2,fork=2,timer=10000" },
+};
+
+static long levels[LOAD_NKINDS];
+static char profile[128];	/* canonical, "" when no load */
+static uint64_t *counters;	/* shared with the load processes */
+static pid_t leader = -1;
+static int alive = -1;		/* its EOF stops the load */
+
+static void add(int kind, uint64_t v)
+{
+	__atomic_fetch_add(&counters[kind], v, __ATOMIC_RELAXED);
+}
+
+static long online_cpus(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? n : 1;
+}
+
+/* Returns -1 if the profile is malformed */
+static int parse(const char *s)
+{
+	char buf[256], *item, *save, *eq, *end;
+	size_t i;
+	int k;
+
+	for (i = 0; i < sizeof(presets) / sizeof(presets[0]); i++)
+		if (strcmp(s, presets[i].name) == 0)
+			s = presets[i].profile;
+	if (strlen(s) >= sizeof(buf))
+		return -1;
+	strcpy(buf, s);
+
+	memset(levels, 0, sizeof(levels));
+	for (item = strtok_r(buf, ",", &save); item != NULL;
+	     item = strtok_r(NULL, ",", &save)) {
+		eq = strchr(item, '=');
+		if (eq != NULL)
+			*eq = '\0';
+		for (k = 0; k < LOAD_NKINDS; k++)
+			if (strcmp(item, kind_names[k]) == 0)
+				break;
+		if (k == LOAD_NKINDS)
+			return -1;
+		if (eq == NULL) {
+			levels[k] = k == LOAD_CPU ? online_cpus() :
+				    k == LOAD_TIMER ? 1000 : 1;
+			continue;
+		}
+		levels[k] = strtol(eq + 1, &end, 10);
+		if (end == eq + 1 || *end != '\0' || levels[k] < 0 ||
+		    (k == LOAD_TIMER && levels[k] > 1000000))
+			return -1;
+	}
+
+	profile[0] = '\0';
+	for (k = 0; k < LOAD_NKINDS; k++)
+		if (levels[k] > 0)
+			snprintf(profile + strlen(profile),
+				 sizeof(profile) - strlen(profile), "%s%s=%ld",
+				 profile[0] ? "," : "", kind_names[k], levels[k]);
+	return 0;
+}
+
+static uint64_t cpu_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void spin(void)
+{
+	volatile unsigned long x = 1;
+	uint64_t last = cpu_us(), now;
+	long i;
+
+	for (;;) {
+		for (i = 0; i < CPU_SPIN; i++)
+			x = x * 1103515245 + 12345;
+		now = cpu_us();
+		add(LOAD_CPU, now - last);
+		last = now;
+	}
+}
+
+static void stream(void)
+{
+	char *a = malloc(MEM_BUFFER), *b = malloc(MEM_BUFFER);
+
+	if (a == NULL || b == NULL)
+		_exit(1);
+	memset(a, 1, MEM_BUFFER);
+	for (;;) {
+		memcpy(b, a, MEM_BUFFER);
+		memcpy(a, b, MEM_BUFFER);
+		add(LOAD_MEM, 2 * (MEM_BUFFER >> 20));
+	}
+}
+
+static void churn(const char *dir)
+{
+	char path[4096], *buf = malloc(IO_CHUNK);
+	int fd;
+	long i;
+
+	snprintf(path, sizeof(path), "%s/pts-load.XXXXXX", dir);
+	fd = mkstemp(path);
+	if (fd == -1 || buf == NULL)
+		_exit(1);
+	unlink(path);
+	memset(buf, 1, IO_CHUNK);
+
+	for (;;) {
+		for (i = 0; i < IO_FILE / IO_CHUNK; i++)
+			if (pwrite(fd, buf, IO_CHUNK, i * IO_CHUNK) != IO_CHUNK)
+				_exit(1);
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		for (i = 0; i < IO_FILE / IO_CHUNK; i++)
+			if (pread(fd, buf, IO_CHUNK, i * IO_CHUNK) != IO_CHUNK)
+				_exit(1);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		add(LOAD_IO, 2 * (IO_FILE >> 20));
+	}
+}
+
+static void fork_storm(void)
+{
+	pid_t pid;
+
+	for (;;) {
+		pid = fork();
+		if (pid == 0)
+			_exit(0);
+		if (pid == -1) {
+			usleep(1000);
+			continue;
+		}
+		waitpid(pid, NULL, 0);
+		add(LOAD_FORK, 1);
+	}
+}
+
+static void tick(long hz)
+{
+	struct itimerval it;
+	long us = 1000000 / hz;
+	sigset_t set;
+	int sig;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGALRM);
+	sigprocmask(SIG_BLOCK, &set, NULL);
+	it.it_interval.tv_sec = us / 1000000;
+	it.it_interval.tv_usec = us % 1000000;
+	it.it_value = it.it_interval;
+	if (setitimer(ITIMER_REAL, &it, NULL) != 0)
+		_exit(1);
+	for (;;)
+		if (sigwait(&set, &sig) == 0)
+			add(LOAD_TIMER, 1);
+}
+
+static void worker(int kind, const char *tmpdir)
+{
+	signal(SIGCHLD, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	switch (kind) {
+	case LOAD_CPU:
+		spin();
+		break;
+	case LOAD_MEM:
+		stream();
+		break;
+	case LOAD_IO:
+		churn(tmpdir);
+		break;
+	case LOAD_FORK:
+		fork_storm();
+		break;
+	case LOAD_TIMER:
+		tick(levels[LOAD_TIMER]);
+		break;
+	}
+	_exit(0);
+}
+
+/* Leads the load processes, until "fd" is closed */
+static void lead(int fd, const char *tmpdir)
+{
+	sigset_t set;
+	char c;
+	long i;
+	int k;
+
+	setpgid(0, 0);
+	signal(SIGTERM, SIG_IGN);
+	sigemptyset(&set);
+	sigprocmask(SIG_SETMASK, &set, NULL);
+
+	for (k = 0; k < LOAD_NKINDS; k++) {
+		for (i = 0; i < (k == LOAD_TIMER ? !!levels[k] : levels[k]); i++) {
+			switch (fork()) {
+			case -1:
+				perror("pts-load: fork");
+				break;
+			case 0:
+				close(fd);
+				worker(k, tmpdir);
+			}
+		}
+	}
+
+	while (read(fd, &c, 1) == -1 && errno == EINTR)
+		;
+	/* Gone once load_stop() returns */
+	kill(0, SIGTERM);
+	while (wait(NULL) > 0 || errno == EINTR)
+		;
+	_exit(0);
+}
+
+/* The profile as it was understood, "" if there is no load */
+const char *load_profile(void)
+{
+	return profile;
+}
+
+/* Returns -1, with a message, if the profile is malformed */
+int load_parse(const char *s)
+{
+	if (parse(s) == 0)
+		return 0;
+	fprintf(stderr, "Invalid load \"%s\": expected light, busy, storm "
+		"or a list of cpu[=n], mem[=n], io[=n], fork[=n] and timer[=hz].\n",
+		s);
+	return -1;
+}
+
+/* Start the load of the profile parsed last, if any */
+int load_start(const char *tmpdir)
+{
+	int fd[2];
+
+	if (profile[0] == '\0')
+		return 0;
+
+	counters = mmap(NULL, LOAD_NKINDS * sizeof(*counters),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counters == MAP_FAILED || pipe(fd) != 0) {
+		perror("pts-load");
+		return -1;
+	}
+	fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+
+	fflush(NULL);
+	leader = fork();
+	if (leader == -1) {
+		perror("pts-load: fork");
+		return -1;
+	}
+	if (leader == 0) {
+		close(fd[1]);
+		lead(fd[0], tmpdir);
+	}
+	close(fd[0]);
+	alive = fd[1];
+	setpgid(leader, leader);
+	return 0;
+}
+
+/* The counts so far, -1 for the loads not running */
+void load_read(long long v[LOAD_NKINDS])
+{
+	int k;
+
+	for (k = 0; k < LOAD_NKINDS; k++)
+		v[k] = levels[k] > 0 && counters != NULL ?
+		       (long long)__atomic_load_n(&counters[k], __ATOMIC_RELAXED) : -1;
+}
+
+/* Around a test: what the load did while it ran goes to t->load */
+void load_begin(struct test *t)
+{
+	load_read(t->load);
+}
+
+void load_end(struct test *t)
+{
+	long long now[LOAD_NKINDS];
+	int k;
+
+	load_read(now);
+	for (k = 0; k < LOAD_NKINDS; k++)
+		if (t->load[k] >= 0)
+			t->load[k] = now[k] - t->load[k];
+}
+
+void load_stop(void)
+{
+	if (leader == -1)
+		return;
+	close(alive);
+	/* The leader may have been reaped along with the tests already */
+	waitpid(leader, NULL, 0);
+	leader = -1;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * pts-load: run a command under the background load of pts-run -L, e.g.
+ * a scalability test by hand or from stress/threads/sweep.
+ *
+ * The syntax is:
+ * $ runner/pts-load profile command [arg...]
+ *
+ * with a profile as described in load.c.  Once the command has exited,
+ * what the load did meanwhile is reported on stderr:
+ *
+ *	# LOAD cpu=8,mem=1: 12.31 s, load_cpu_us 96311502 load_mem_mb 24576
+ *
+ * and pts-load exits with the status of the command, 128 + the signal
+ * number if it was killed.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "posixtest.h"
+#include "runner.h"
+
+static void usage(const char *argv0)
+{
+	printf("Usage: %s profile command [arg...]\n", argv0);
+	printf("  profile     light, busy, storm or e.g. cpu=4,mem=1,io=1,fork=1,timer=1000:\n");
+	printf("              cpu, mem, io and fork count processes, timer wakeups per\n");
+	printf("              second (see load.c)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	long long before[LOAD_NKINDS], after[LOAD_NKINDS];
+	struct timespec start, end;
+	const char *tmpdir;
+	int status, k;
+	pid_t pid;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return PTS_UNRESOLVED;
+	}
+	if (load_parse(argv[1]) != 0)
+		return PTS_UNRESOLVED;
+	tmpdir = getenv("TMPDIR");
+	if (load_start(tmpdir != NULL && *tmpdir != '\0' ? tmpdir : "/tmp") != 0)
+		return PTS_UNRESOLVED;
+
+	load_read(before);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid = fork();
+	if (pid == -1) {
+		perror("pts-load: fork");
+		load_stop();
+		return PTS_UNRESOLVED;
+	}
+	if (pid == 0) {
+		execvp(argv[2], argv + 2);
+		perror(argv[2]);
+		_exit(127);
+	}
+	while (waitpid(pid, &status, 0) == -1) {
+		if (errno != EINTR) {
+			perror("pts-load: waitpid");
+			load_stop();
+			return PTS_UNRESOLVED;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	load_read(after);
+	load_stop();
+
+	fprintf(stderr, "# LOAD %s: %.2f s,", load_profile(),
+		end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9);
+	for (k = 0; k < LOAD_NKINDS; k++)
+		if (after[k] >= 0)
+			fprintf(stderr, " %s %lld", load_names[k], after[k] - before[k]);
+	fputc('\n', stderr);
+
+	if (WIFSIGNALED(status))
+		return 128 + WTERMSIG(status);
+	return WEXITSTATUS(status);
+}
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Merging of results (pts-run -m): the JSON Lines files written by the
+ * shards of a run (pts-run -s ... -J file, see shard.c) are read back,
+ * and the tests reported as if a single pts-run had run them all, in
+ * name order: the same lines on stdout and in the logfile, the summary,
+ * and with -J and -X one JSON Lines file and one JUnit report.  Each
+ * record keeps the kernel, libc, shard and load it came from.
+ *
+ * Only the JSON written by results.c is understood: one flat object per
+ * line, with string, number and boolean values.  A test found in more
+ * than one file is reported once, from the last of them.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "runner.h"
+
+struct value {
+	int string;
+	char *s;		/* decoded, NUL-terminated */
+	size_t len;
+	long long num;
+};
+
+static void *xrealloc(void *p, size_t size)
+{
+	p = realloc(p, size);
+	if (p == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+	return p;
+}
+
+static const char *skip_space(const char *p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+/* A JSON string at p (after the quote); returns the end, or NULL */
+static const char *parse_string(const char *p, struct value *v)
+{
+	size_t alloc = 64;
+	unsigned c;
+	int k;
+
+	v->s = xrealloc(NULL, alloc);
+	v->len = 0;
+	while (*p != '"') {
+		if (*p == '\0')
+			return NULL;
+		c = (unsigned char)*p++;
+		if (c == '\\') {
+			switch (*p++) {
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case 'r': c = '\r'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case '/': c = '/'; break;
+			case '"': c = '"'; break;
+			case '\\': c = '\\'; break;
+			case 'u':
+				/*
+				 * results.c writes UTF-8 as is, and control
+				 * characters and stray bytes this way: below
+				 * 0x100, it is that byte.
+				 */
+				if (sscanf(p, "%4x%n", &c, &k) != 1 || k != 4)
+					return NULL;
+				p += 4;
+				if (c < 0x100)
+					break;
+				/* From elsewhere: a character, in UTF-8 */
+				if (v->len + 4 > alloc) {
+					alloc *= 2;
+					v->s = xrealloc(v->s, alloc);
+				}
+				if (c < 0x800) {
+					v->s[v->len++] = 0xc0 | c >> 6;
+				} else {
+					v->s[v->len++] = 0xe0 | c >> 12;
+					v->s[v->len++] = 0x80 | (c >> 6 & 0x3f);
+				}
+				c = 0x80 | (c & 0x3f);
+				break;
+			default:
+				return NULL;
+			}
+		}
+		if (v->len + 2 > alloc) {
+			alloc *= 2;
+			v->s = xrealloc(v->s, alloc);
+		}
+		v->s[v->len++] = c;
+	}
+	v->s[v->len] = '\0';
+	return p + 1;
+}
+
+static int verdict_of(const char *s)
+{
+	int v;
+
+	for (v = 0; v < V_NVERDICTS; v++)
+		if (strcmp(s, verdict_names[v]) == 0)
+			return v;
+	return -1;
+}
+
+static void set_us(struct timeval *tv, long long us)
+{
+	tv->tv_sec = us / 1000000;
+	tv->tv_usec = us % 1000000;
+}
+
+static void set_field(struct merged *m, const char *key, struct value *v)
+{
+	long long *cg[] = {
+		&m->t.cg.memory_peak, &m->t.cg.pids_peak, &m->t.cg.cpu_usec,
+		&m->t.cg.user_usec, &m->t.cg.system_usec,
+		&m->t.cg.throttled_usec, &m->t.cg.oom_kill,
+	};
+	static const char *cg_keys[] = {
+		"memory_peak", "pids_peak", "cpu_us", "cpu_user_us",
+		"cpu_system_us", "throttled_us", "oom_kills",
+	};
+	char **str = NULL;
+	size_t i;
+
+	if (v->string) {
+		if (strcmp(key, "name") == 0)
+			str = &m->t.name;
+		else if (strcmp(key, "kernel") == 0)
+			str = &m->kernel;
+		else if (strcmp(key, "libc") == 0)
+			str = &m->libc;
+		else if (strcmp(key, "shard") == 0)
+			str = &m->shard;
+		else if (strcmp(key, "load") == 0)
+			str = &m->load;
+		else if (strcmp(key, "output") == 0) {
+			str = &m->output;
+			m->len = v->len;
+		} else if (strcmp(key, "verdict") == 0)
+			m->t.verdict = verdict_of(v->s);
+		if (str != NULL) {
+			free(*str);
+			*str = v->s;
+			v->s = NULL;
+		}
+		return;
+	}
+
+	if (strcmp(key, "exit") == 0)
+		m->t.status = (v->num & 0xff) << 8;
+	else if (strcmp(key, "signal") == 0)
+		m->t.status = v->num & 0x7f;
+	else if (strcmp(key, "wall_us") == 0) {
+		m->t.end.tv_sec = v->num / 1000000;
+		m->t.end.tv_nsec = v->num % 1000000 * 1000;
+	} else if (strcmp(key, "utime_us") == 0)
+		set_us(&m->ru.ru_utime, v->num);
+	else if (strcmp(key, "stime_us") == 0)
+		set_us(&m->ru.ru_stime, v->num);
+	else if (strcmp(key, "maxrss_kb") == 0)
+		m->ru.ru_maxrss = v->num;
+	else if (strcmp(key, "nvcsw") == 0)
+		m->ru.ru_nvcsw = v->num;
+	else if (strcmp(key, "nivcsw") == 0)
+		m->ru.ru_nivcsw = v->num;
+	else if (strcmp(key, "cached") == 0)
+		m->cached = v->num != 0;
+
+	for (i = 0; i < sizeof(cg_keys) / sizeof(cg_keys[0]); i++)
+		if (strcmp(key, cg_keys[i]) == 0)
+			*cg[i] = v->num;
+	for (i = 0; i < EV_NEVENTS; i++)
+		if (strcmp(key, event_names[i]) == 0)
+			m->t.events[i] = v->num;
+	for (i = 0; i < LOAD_NKINDS; i++)
+		if (strcmp(key, load_names[i]) == 0)
+			m->t.load[i] = v->num;
+}
+
+/* Returns -1 if the line is not a record of results.c */
+static int parse_record(const char *p, struct merged *m)
+{
+	struct value key, v;
+	char *end;
+
+	memset(m, 0, sizeof(*m));
+	memset(&m->t.cg, 0xff, sizeof(m->t.cg));
+	perf_reset(&m->t);
+	memset(m->t.load, 0xff, sizeof(m->t.load));
+	m->t.verdict = -1;
+
+	p = skip_space(p);
+	if (*p++ != '{')
+		return -1;
+	for (p = skip_space(p); *p != '}'; p = skip_space(p + 1)) {
+		memset(&key, 0, sizeof(key));
+		if (*p != '"' || (p = parse_string(p + 1, &key)) == NULL) {
+			free(key.s);
+			return -1;
+		}
+		p = skip_space(p);
+		if (*p != ':') {
+			free(key.s);
+			return -1;
+		}
+		p = skip_space(p + 1);
+
+		memset(&v, 0, sizeof(v));
+		if (*p == '"') {
+			v.string = 1;
+			p = parse_string(p + 1, &v);
+		} else if (strncmp(p, "true", 4) == 0) {
+			v.num = 1;
+			p += 4;
+		} else if (strncmp(p, "false", 5) == 0) {
+			p += 5;
+		} else {
+			v.num = strtoll(p, &end, 10);
+			p = end == p ? NULL : end;
+		}
+		if (p != NULL)
+			set_field(m, key.s, &v);
+		free(key.s);
+		free(v.s);
+		if (p == NULL)
+			return -1;
+
+		p = skip_space(p);
+		if (*p == '}')
+			break;
+		if (*p != ',')
+			return -1;
+	}
+	return m->t.name != NULL && (int)m->t.verdict >= 0 ? 0 : -1;
+}
+
+static void clear(struct merged *m)
+{
+	free(m->t.name);
+	free(m->output);
+	free(m->kernel);
+	free(m->libc);
+	free(m->shard);
+	free(m->load);
+}
+
+static int cmp_merged(const void *a, const void *b)
+{
+	return strcmp(((const struct merged *)a)->t.name,
+		      ((const struct merged *)b)->t.name);
+}
+
+/*
+ * Append the records of a file to the *n of *v, each with its position
+ * in *v as t.slot; returns -1 if the file cannot be read.
+ */
+int merge_read(const char *file, struct merged **v, size_t *n)
+{
+	char *line = NULL;
+	size_t cap = 0, lineno;
+	FILE *fp;
+
+	fp = fopen(file, "r");
+	if (fp == NULL) {
+		perror(file);
+		return -1;
+	}
+	for (lineno = 1; getline(&line, &cap, fp) != -1; lineno++) {
+		if (*n % 1024 == 0)
+			*v = xrealloc(*v, (*n + 1024) * sizeof(**v));
+		if (parse_record(line, &(*v)[*n]) != 0) {
+			fprintf(stderr, "%s:%zu: not a pts-run result\n",
+				file, lineno);
+			clear(&(*v)[*n]);
+			continue;
+		}
+		(*v)[*n].t.slot = *n;
+		(*n)++;
+	}
+	free(line);
+	fclose(fp);
+	return 0;
+}
+
+/* Returns -1 if a file cannot be read */
+int merge_load(char **files, int nfiles, struct merged **v, size_t *n)
+{
+	struct merged *all = NULL;
+	size_t count = 0, i, j;
+	int f;
+
+	for (f = 0; f < nfiles; f++)
+		if (merge_read(files[f], &all, &count) != 0)
+			return -1;
+
+	/* Later files win, by the order of the records */
+	qsort(all, count, sizeof(*all), cmp_merged);
+	for (i = j = 0; i < count; i++) {
+		if (j > 0 && strcmp(all[j - 1].t.name, all[i].t.name) == 0) {
+			fprintf(stderr, "pts-run: %s reported twice\n",
+				all[i].t.name);
+			if (all[i].t.slot > all[j - 1].t.slot) {
+				clear(&all[j - 1]);
+				all[j - 1] = all[i];
+			} else {
+				clear(&all[i]);
+			}
+			continue;
+		}
+		all[j++] = all[i];
+	}
+
+	*v = all;
+	*n = j;
+	return 0;
+}
+
+void merge_free(struct merged *v, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		clear(&v[i]);
+	free(v);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Performance counters of each test (pts-run -e, Linux only).
+ *
+ * With -e, counters are attached to every test before it runs: cycles,
+ * instructions, cache misses, branch misses, context switches, CPU
+ * migrations and page faults, of the test and of every process and
+ * thread it starts.  Their totals go to the results next to the
+ * resource usage (see results.c).
+ *
+ * An executed test waits between fork() and exec() until its counters
+ * are attached, and is counted from exec() on.  A test forked by the
+ * server of -z (see zygote.c) is held likewise, and is counted from
+ * then on.  The counters which the processor or perf_event_paranoid do
+ * not allow are left out; with perf_event_paranoid 2, only user space
+ * is counted.  When a counter had to share the hardware with others,
+ * its total is scaled to the time the test ran.
+ *
+ * -e also sets PTS_PERF in the environment of the tests, for those
+ * which count their own samples (see measure.h).
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+/* As in the results */
+const char *event_names[EV_NEVENTS] = {
+	[EV_CYCLES] = "cycles",
+	[EV_INSTRUCTIONS] = "instructions",
+	[EV_CACHE_MISSES] = "cache_misses",
+	[EV_BRANCH_MISSES] = "branch_misses",
+	[EV_CONTEXT_SWITCHES] = "context_switches",
+	[EV_CPU_MIGRATIONS] = "cpu_migrations",
+	[EV_PAGE_FAULTS] = "page_faults",
+};
+
+void perf_reset(struct test *t)
+{
+	int i;
+
+	for (i = 0; i < EV_NEVENTS; i++) {
+		t->perf_fd[i] = -1;
+		t->events[i] = -1;
+	}
+}
+
+#if defined(__linux__) && defined(SYS_perf_event_open)
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} events[EV_NEVENTS] = {
+	[EV_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	[EV_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	[EV_CACHE_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	[EV_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	[EV_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	[EV_CPU_MIGRATIONS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+	[EV_PAGE_FAULTS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+static unsigned int available;	/* mask of the events which can be counted */
+static int user_only;
+
+static int open_event(int e, pid_t pid, int on_exec)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[e].type;
+	attr.config = events[e].config;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			   PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.disabled = on_exec;
+	attr.enable_on_exec = on_exec;
+	attr.inherit = 1;
+	attr.exclude_kernel = user_only;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, pid, -1, -1,
+		       PERF_FLAG_FD_CLOEXEC);
+}
+
+/* Returns -1 when nothing can be counted */
+int perf_init(void)
+{
+	int e, fd;
+
+	for (e = 0; e < EV_NEVENTS; e++) {
+		fd = open_event(e, 0, 1);
+		if (fd == -1 && (errno == EACCES || errno == EPERM) &&
+		    !user_only && available == 0) {
+			user_only = 1;
+			fd = open_event(e, 0, 1);
+		}
+		if (fd == -1)
+			continue;
+		close(fd);
+		available |= 1U << e;
+	}
+	return available != 0 ? 0 : -1;
+}
+
+/* Once the test is forked; counting starts at its exec() when "on_exec" */
+void perf_attach(struct test *t, int on_exec)
+{
+	int e;
+
+	for (e = 0; e < EV_NEVENTS; e++)
+		if (available & (1U << e))
+			t->perf_fd[e] = open_event(e, t->pid, on_exec);
+}
+
+/* Once the test has exited */
+void perf_finish(struct test *t)
+{
+	uint64_t v[3];		/* value, time enabled, time running */
+	int e;
+
+	for (e = 0; e < EV_NEVENTS; e++) {
+		if (t->perf_fd[e] == -1)
+			continue;
+		if (read(t->perf_fd[e], v, sizeof(v)) == sizeof(v)) {
+			if (v[2] != 0 && v[2] < v[1])
+				v[0] = (double)v[0] * v[1] / v[2];
+			t->events[e] = v[0];
+		}
+		close(t->perf_fd[e]);
+		t->perf_fd[e] = -1;
+	}
+}
+
+#else /* no perf events */
+
+int perf_init(void)
+{
+	return -1;
+}
+
+void perf_attach(struct test *t, int on_exec)
+{
+	(void)t;
+	(void)on_exec;
+}
+
+void perf_finish(struct test *t)
+{
+	(void)t;
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Per-test run policy, read from the RUNPOLICY file at the top of the
+ * tree.  Each line holds a shell pattern matched against the test name
+ * (the path without extension, "*" also matches "/") followed by one or
+ * more key=value settings:
+ *
+ * conformance/interfaces/sched_*          class=rt
+ * conformance/interfaces/mq_open/[0-9]*   timeout=10s
+ *
+ * The keys are "class" (see sched.c), "timeout", the time after which
+ * the test is HUNG, in seconds or with an "ms", "s" or "m" suffix, and
+ * "zygote", "no" for a test which must be executed even with pts-run -z
+ * (see zygote.c).  "pids", "memory" and "cpu" bound the processes and
+ * threads, the memory (in bytes, or with a K, M or G suffix) and the
+ * share of a CPU (e.g. "50%", or "200%" for two CPUs) of the test and
+ * of everything it starts (see cgroup.c); "max" removes a bound.
+ *
+ * Lines are applied in order, so a later line overrides what an earlier
+ * one set for the same test.  Everything after a '#' is a comment.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runner.h"
+
+struct setting {
+	char *key;
+	char *value;
+};
+
+struct rule {
+	char *pattern;
+	struct setting *settings;
+	int nsettings;
+};
+
+static struct rule *rules;
+static int nrules;
+
+const char *class_names[CLASS_NCLASSES] = {
+	[CLASS_PARALLEL] = "parallel-safe",
+	[CLASS_PINNED] = "cpu-pinned",
+	[CLASS_EXCLUSIVE] = "exclusive",
+	[CLASS_RT] = "rt",
+};
+
+static int parse_class(const char *s)
+{
+	int c;
+
+	for (c = 0; c < CLASS_NCLASSES; c++)
+		if (strcmp(s, class_names[c]) == 0)
+			return c;
+	return -1;
+}
+
+/* A count, or with one of the suffixes; "max" is always valid */
+static int valid_limit(const char *s, const char *suffixes)
+{
+	char *end;
+
+	if (strcmp(s, "max") == 0)
+		return 1;
+	if (strtol(s, &end, 10) <= 0 || end == s || *s == '-' || *s == '+')
+		return 0;
+	return *end == '\0' || (end[1] == '\0' && strchr(suffixes, *end) != NULL);
+}
+
+/* "50%", the % is required */
+static int valid_cpu(const char *s)
+{
+	size_t len = strlen(s);
+
+	return strcmp(s, "max") == 0 ||
+	       (valid_limit(s, "%") && len > 0 && s[len - 1] == '%');
+}
+
+/* "90", "90s", "1500ms" or "2m"; returns -1 if not a positive duration */
+int parse_duration(const char *s, long *ms)
+{
+	char *end;
+	long v;
+
+	v = strtol(s, &end, 10);
+	if (end == s || v <= 0)
+		return -1;
+	if (*end == '\0' || strcmp(end, "s") == 0)
+		*ms = v * 1000;
+	else if (strcmp(end, "ms") == 0)
+		*ms = v;
+	else if (strcmp(end, "m") == 0)
+		*ms = v * 60000;
+	else
+		return -1;
+	return 0;
+}
+
+static int add_rule(const char *file, int line, char *buf)
+{
+	struct rule *r, *v;
+	struct setting *s;
+	char *tok, *save, *eq;
+	long ms;
+
+	tok = strtok_r(buf, " \t", &save);
+	if (tok == NULL)
+		return 0;
+
+	v = realloc(rules, (nrules + 1) * sizeof(*rules));
+	if (v == NULL)
+		return -1;
+	rules = v;
+	r = &rules[nrules];
+	memset(r, 0, sizeof(*r));
+	r->pattern = strdup(tok);
+	if (r->pattern == NULL)
+		return -1;
+
+	while ((tok = strtok_r(NULL, " \t", &save)) != NULL) {
+		eq = strchr(tok, '=');
+		if (eq == NULL || eq == tok) {
+			fprintf(stderr, "%s:%d: expected key=value, got \"%s\"\n",
+				file, line, tok);
+			return -1;
+		}
+		*eq = '\0';
+
+		if (strcmp(tok, "class") == 0 && parse_class(eq + 1) < 0) {
+			fprintf(stderr, "%s:%d: unknown class \"%s\"\n",
+				file, line, eq + 1);
+			return -1;
+		}
+		if (strcmp(tok, "timeout") == 0 && parse_duration(eq + 1, &ms) != 0) {
+			fprintf(stderr, "%s:%d: bad timeout \"%s\"\n",
+				file, line, eq + 1);
+			return -1;
+		}
+		if (strcmp(tok, "zygote") == 0 && strcmp(eq + 1, "yes") != 0 &&
+		    strcmp(eq + 1, "no") != 0) {
+			fprintf(stderr, "%s:%d: zygote is yes or no, not \"%s\"\n",
+				file, line, eq + 1);
+			return -1;
+		}
+
+		if ((strcmp(tok, "pids") == 0 && !valid_limit(eq + 1, "")) ||
+		    (strcmp(tok, "memory") == 0 && !valid_limit(eq + 1, "KMG")) ||
+		    (strcmp(tok, "cpu") == 0 && !valid_cpu(eq + 1))) {
+			fprintf(stderr, "%s:%d: bad %s limit \"%s\"\n",
+				file, line, tok, eq + 1);
+			return -1;
+		}
+
+		s = realloc(r->settings, (r->nsettings + 1) * sizeof(*s));
+		if (s == NULL)
+			return -1;
+		r->settings = s;
+		s = &r->settings[r->nsettings++];
+		s->key = strdup(tok);
+		s->value = strdup(eq + 1);
+		if (s->key == NULL || s->value == NULL)
+			return -1;
+	}
+
+	nrules++;
+	return 0;
+}
+
+/* A missing file is not an error: every test is then parallel-safe */
+int policy_load(const char *path)
+{
+	char buf[1024], *p;
+	FILE *fp;
+	int line = 0, ret = 0;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return 0;
+
+	while (ret == 0 && fgets(buf, sizeof(buf), fp) != NULL) {
+		line++;
+		p = strchr(buf, '#');
+		if (p != NULL)
+			*p = '\0';
+		for (p = buf + strlen(buf); p > buf && isspace((unsigned char)p[-1]); p--)
+			p[-1] = '\0';
+		ret = add_rule(path, line, buf);
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+static const char *limit(const char *value)
+{
+	return strcmp(value, "max") == 0 ? NULL : value;
+}
+
+static void apply(struct test *t, const struct setting *s)
+{
+	if (strcmp(s->key, "class") == 0)
+		t->class = parse_class(s->value);
+	else if (strcmp(s->key, "timeout") == 0)
+		parse_duration(s->value, &t->timeout_ms);
+	else if (strcmp(s->key, "zygote") == 0)
+		t->zygote = strcmp(s->value, "yes") == 0;
+	else if (strcmp(s->key, "pids") == 0)
+		t->pids_max = limit(s->value);
+	else if (strcmp(s->key, "memory") == 0)
+		t->memory_max = limit(s->value);
+	else if (strcmp(s->key, "cpu") == 0)
+		t->cpu_max = limit(s->value);
+}
+
+void policy_apply(struct test *t)
+{
+	int r, i;
+
+	t->class = CLASS_PARALLEL;
+	t->timeout_ms = 0;
+	t->zygote = 1;
+	t->pids_max = NULL;
+	t->memory_max = NULL;
+	t->cpu_max = NULL;
+
+	for (r = 0; r < nrules; r++) {
+		if (fnmatch(rules[r].pattern, t->name, 0) != 0)
+			continue;
+		for (i = 0; i < rules[r].nsettings; i++)
+			apply(t, &rules[r].settings[i]);
+	}
+}
+
+/*
+ * Without a private IPC namespace (see isolate.c), the semaphore, message
+ * queue and shared memory tests share their fixed object names and the
+ * system limits: they run alone.
+ */
+static const char *const shared_ipc[] = {
+	"conformance/interfaces/sem_*/*",
+	"conformance/interfaces/mq_*/*",
+	"conformance/interfaces/shm_*/*",
+};
+
+void policy_shared_ipc(struct test *t)
+{
+	size_t i;
+
+	if (t->class == CLASS_RT)
+		return;
+	for (i = 0; i < sizeof(shared_ipc) / sizeof(shared_ipc[0]); i++)
+		if (fnmatch(shared_ipc[i], t->name, 0) == 0)
+			t->class = CLASS_EXCLUSIVE;
+}
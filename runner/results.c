@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Machine-readable results, next to the logfile.
+ *
+ * pts-run -J file streams one JSON object per line and per test, as soon
+ * as the test completes:
+ *
+ * {"name":"conformance/interfaces/sem_open/1-1","verdict":"PASS",
+ *  "exit":0,"wall_us":1204,"utime_us":310,"stime_us":1022,
+ *  "maxrss_kb":1480,"nvcsw":3,"nivcsw":0,"cached":false,
+ *  "kernel":"6.1.0","libc":"glibc 2.36",
+ *  "output":"Test PASSED\n"}
+ *
+ * "exit" is replaced by "signal" when the test was killed by a signal.
+ * The resource usage is that of the test and of all the processes it
+ * waited for, as returned by wait4().  When the test ran in a cgroup of
+ * its own (see cgroup.c), the usage of everything it started follows,
+ * as far as the kernel accounts for it:
+ *
+ *  "memory_peak":2125824,"pids_peak":3,"cpu_us":1420,"cpu_user_us":340,
+ *  "cpu_system_us":1080,"throttled_us":0,"oom_kills":0
+ *
+ * With pts-run -e, the counters of the test follow (see perf.c):
+ *
+ *  "cycles":4123302,"instructions":3310922,"cache_misses":10210,
+ *  "branch_misses":20133,"context_switches":4,"cpu_migrations":0,
+ *  "page_faults":190
+ *
+ * Under a background load (pts-run -L), its profile and what it did while
+ * the test ran follow (see load.c):
+ *
+ *  "load":"cpu=8,timer=1000","load_cpu_us":7913220,"load_timer_ticks":1002
+ *
+ * Results replayed from the cache have "cached":true and no timing or
+ * resource fields.  A shard of a run (pts-run -s) adds "shard":"i/N".
+ *
+ * pts-run -X file writes a JUnit XML report once all tests have run.
+ * FAILED tests are <failure>s; UNRESOLVED, HUNG and INTERRUPTED ones are
+ * <error>s; UNSUPPORTED and UNTESTED ones are <skipped>.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#include "runner.h"
+
+struct record {
+	char *name;
+	enum verdict verdict;
+	long wall_us;
+	char *output;
+	size_t len;
+};
+
+/* As in the logfile */
+const char *verdict_names[V_NVERDICTS] = {
+	[V_PASS] = "PASS",
+	[V_FAILED] = "FAILED",
+	[V_UNRESOLVED] = "UNRESOLVED",
+	[V_UNSUPPORTED] = "UNSUPPORTED",
+	[V_UNTESTED] = "UNTESTED",
+	[V_HUNG] = "HUNG",
+	[V_INTERRUPTED] = "INTERRUPTED",
+};
+
+static FILE *jsonl;
+static const char *junit_path;
+static struct record *records;
+static size_t nrecords, alloc;
+static char kernel[256], libc[256], shard[32], load[128];
+
+/*
+ * The length of the UTF-8 sequence at s, or 0 if it is not one: test
+ * output need not be UTF-8, and bytes which do not make a character are
+ * taken as Latin-1, one by one.
+ */
+static size_t utf8_len(const unsigned char *s, size_t len)
+{
+	unsigned long cp;
+	size_t n, i;
+
+	if (s[0] < 0x80)
+		return 1;
+	if (s[0] >= 0xc2 && s[0] <= 0xdf)
+		n = 2, cp = s[0] & 0x1f;
+	else if (s[0] >= 0xe0 && s[0] <= 0xef)
+		n = 3, cp = s[0] & 0x0f;
+	else if (s[0] >= 0xf0 && s[0] <= 0xf4)
+		n = 4, cp = s[0] & 0x07;
+	else
+		return 0;
+	if (n > len)
+		return 0;
+	for (i = 1; i < n; i++) {
+		if ((s[i] & 0xc0) != 0x80)
+			return 0;
+		cp = cp << 6 | (s[i] & 0x3f);
+	}
+	/* Overlong forms, surrogates and beyond U+10FFFF */
+	if ((n == 3 && cp < 0x800) || (n == 4 && cp < 0x10000) ||
+	    (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+		return 0;
+	return n;
+}
+
+static void json_string(FILE *fp, const char *s, size_t len)
+{
+	unsigned char c;
+	size_t i, n;
+
+	fputc('"', fp);
+	for (i = 0; i < len; i++) {
+		c = s[i];
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c == '\n')
+			fputs("\\n", fp);
+		else if (c == '\t')
+			fputs("\\t", fp);
+		else if (c < 0x20 || c == 0x7f)
+			fprintf(fp, "\\u%04x", c);
+		else if (c < 0x80)
+			fputc(c, fp);
+		else if ((n = utf8_len((const unsigned char *)s + i,
+				       len - i)) != 0) {
+			fwrite(s + i, 1, n, fp);
+			i += n - 1;
+		} else
+			/* merge.c reads \u00XX back as that byte */
+			fprintf(fp, "\\u%04x", c);
+	}
+	fputc('"', fp);
+}
+
+static void xml_string(FILE *fp, const char *s, size_t len)
+{
+	unsigned char c;
+	size_t i, n;
+
+	for (i = 0; i < len; i++) {
+		c = s[i];
+		if (c == '&')
+			fputs("&amp;", fp);
+		else if (c == '<')
+			fputs("&lt;", fp);
+		else if (c == '>')
+			fputs("&gt;", fp);
+		else if (c == '"')
+			fputs("&quot;", fp);
+		else if (c == 0x7f)
+			fputs("&#x7f;", fp);
+		else if (c >= 0x80) {
+			n = utf8_len((const unsigned char *)s + i, len - i);
+			if (n == 0) {
+				fprintf(fp, "&#x%x;", c);
+				continue;
+			}
+			fwrite(s + i, 1, n, fp);
+			i += n - 1;
+		} else if (c >= 0x20 || c == '\n' || c == '\t' || c == '\r')
+			fputc(c, fp);
+		/* Other control characters cannot appear in XML 1.0 */
+	}
+}
+
+/* -1: not known, left out */
+static void json_usage(FILE *fp, const char *key, long long v)
+{
+	if (v >= 0)
+		fprintf(fp, ",\"%s\":%lld", key, v);
+}
+
+static long tv_us(const struct timeval *tv)
+{
+	return tv->tv_sec * 1000000L + tv->tv_usec;
+}
+
+/* Either file may be NULL */
+int results_open(const char *jsonl_path, const char *junit)
+{
+	struct utsname u;
+
+	if (jsonl_path != NULL) {
+		jsonl = fopen(jsonl_path, "a");
+		if (jsonl == NULL) {
+			perror(jsonl_path);
+			return -1;
+		}
+	}
+	junit_path = junit;
+
+	if (uname(&u) == 0)
+		snprintf(kernel, sizeof(kernel), "%s", u.release);
+#ifdef _CS_GNU_LIBC_VERSION
+	if (confstr(_CS_GNU_LIBC_VERSION, libc, sizeof(libc)) == 0)
+		libc[0] = '\0';
+#endif
+	return 0;
+}
+
+/*
+ * Where the next results come from, when it is not this run on this
+ * system: a shard (see shard.c), or another machine (see merge.c); and
+ * the background load they ran under (see load.c).  NULL leaves a field
+ * as it is.
+ */
+void results_origin(const char *kernel_, const char *libc_, const char *shard_,
+		    const char *load_)
+{
+	if (kernel_ != NULL)
+		snprintf(kernel, sizeof(kernel), "%s", kernel_);
+	if (libc_ != NULL)
+		snprintf(libc, sizeof(libc), "%s", libc_);
+	if (shard_ != NULL)
+		snprintf(shard, sizeof(shard), "%s", shard_);
+	if (load_ != NULL)
+		snprintf(load, sizeof(load), "%s", load_);
+}
+
+/* "ru" is NULL for a result replayed from the cache */
+void results_add(const struct test *t, const struct rusage *ru,
+		 const char *output, size_t len)
+{
+	struct record *r;
+	long wall_us = 0;
+	int e;
+
+	if (ru != NULL)
+		wall_us = (t->end.tv_sec - t->start.tv_sec) * 1000000L +
+			  (t->end.tv_nsec - t->start.tv_nsec) / 1000;
+
+	if (jsonl != NULL) {
+		fputs("{\"name\":", jsonl);
+		json_string(jsonl, t->name, strlen(t->name));
+		fprintf(jsonl, ",\"verdict\":\"%s\"", verdict_names[t->verdict]);
+		if (WIFSIGNALED(t->status))
+			fprintf(jsonl, ",\"signal\":%d", WTERMSIG(t->status));
+		else
+			fprintf(jsonl, ",\"exit\":%d", WEXITSTATUS(t->status));
+		if (ru != NULL) {
+			fprintf(jsonl, ",\"wall_us\":%ld,\"utime_us\":%ld,"
+				"\"stime_us\":%ld,\"maxrss_kb\":%ld,"
+				"\"nvcsw\":%ld,\"nivcsw\":%ld",
+				wall_us, tv_us(&ru->ru_utime), tv_us(&ru->ru_stime),
+				ru->ru_maxrss, ru->ru_nvcsw, ru->ru_nivcsw);
+			json_usage(jsonl, "memory_peak", t->cg.memory_peak);
+			json_usage(jsonl, "pids_peak", t->cg.pids_peak);
+			json_usage(jsonl, "cpu_us", t->cg.cpu_usec);
+			json_usage(jsonl, "cpu_user_us", t->cg.user_usec);
+			json_usage(jsonl, "cpu_system_us", t->cg.system_usec);
+			json_usage(jsonl, "throttled_us", t->cg.throttled_usec);
+			json_usage(jsonl, "oom_kills", t->cg.oom_kill);
+			for (e = 0; e < EV_NEVENTS; e++)
+				json_usage(jsonl, event_names[e], t->events[e]);
+		}
+		if (load[0] != '\0') {
+			fputs(",\"load\":", jsonl);
+			json_string(jsonl, load, strlen(load));
+			for (e = 0; ru != NULL && e < LOAD_NKINDS; e++)
+				json_usage(jsonl, load_names[e], t->load[e]);
+		}
+		fprintf(jsonl, ",\"cached\":%s,\"kernel\":",
+			ru == NULL ? "true" : "false");
+		json_string(jsonl, kernel, strlen(kernel));
+		fputs(",\"libc\":", jsonl);
+		json_string(jsonl, libc, strlen(libc));
+		if (shard[0] != '\0') {
+			fputs(",\"shard\":", jsonl);
+			json_string(jsonl, shard, strlen(shard));
+		}
+		fputs(",\"output\":", jsonl);
+		json_string(jsonl, output ? output : "", output ? len : 0);
+		fputs("}\n", jsonl);
+		fflush(jsonl);
+	}
+
+	if (junit_path == NULL)
+		return;
+
+	if (nrecords == alloc) {
+		alloc = alloc ? 2 * alloc : 256;
+		r = realloc(records, alloc * sizeof(*records));
+		if (r == NULL) {
+			perror("pts-run");
+			exit(2);
+		}
+		records = r;
+	}
+	r = &records[nrecords++];
+	r->name = strdup(t->name);
+	r->verdict = t->verdict;
+	r->wall_us = wall_us;
+	r->len = output ? len : 0;
+	r->output = malloc(r->len + 1);
+	if (r->name == NULL || r->output == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+	memcpy(r->output, output ? output : "", r->len);
+}
+
+static const char *junit_element(enum verdict v)
+{
+	switch (v) {
+	case V_PASS:
+		return NULL;
+	case V_FAILED:
+		return "failure";
+	case V_UNSUPPORTED:
+	case V_UNTESTED:
+		return "skipped";
+	default:
+		return "error";
+	}
+}
+
+static void write_junit(void)
+{
+	unsigned long failures = 0, errors = 0, skipped = 0;
+	long total_us = 0;
+	const char *elem, *slash;
+	struct record *r;
+	FILE *fp;
+	size_t i;
+
+	fp = fopen(junit_path, "w");
+	if (fp == NULL) {
+		perror(junit_path);
+		return;
+	}
+
+	for (i = 0; i < nrecords; i++) {
+		total_us += records[i].wall_us;
+		elem = junit_element(records[i].verdict);
+		if (elem == NULL)
+			continue;
+		if (elem[0] == 'f')
+			failures++;
+		else if (elem[0] == 's')
+			skipped++;
+		else
+			errors++;
+	}
+
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(fp, "<testsuite name=\"pts-run\" tests=\"%zu\" failures=\"%lu\" "
+		"errors=\"%lu\" skipped=\"%lu\" time=\"%ld.%06ld\">\n",
+		nrecords, failures, errors, skipped,
+		total_us / 1000000, total_us % 1000000);
+
+	for (i = 0; i < nrecords; i++) {
+		r = &records[i];
+		slash = strrchr(r->name, '/');
+		fputs("  <testcase classname=\"", fp);
+		xml_string(fp, r->name, slash ? (size_t)(slash - r->name) : 0);
+		fputs("\" name=\"", fp);
+		slash = slash ? slash + 1 : r->name;
+		xml_string(fp, slash, strlen(slash));
+		fprintf(fp, "\" time=\"%ld.%06ld\">\n",
+			r->wall_us / 1000000, r->wall_us % 1000000);
+		elem = junit_element(r->verdict);
+		if (elem != NULL)
+			fprintf(fp, "    <%s message=\"%s\"/>\n", elem,
+				verdict_names[r->verdict]);
+		if (r->len > 0) {
+			fputs("    <system-out>", fp);
+			xml_string(fp, r->output, r->len);
+			fputs("</system-out>\n", fp);
+		}
+		fputs("  </testcase>\n", fp);
+	}
+	fputs("</testsuite>\n", fp);
+
+	if (fclose(fp) != 0)
+		perror(junit_path);
+}
+
+void results_close(void)
+{
+	size_t i;
+
+	if (jsonl != NULL)
+		fclose(jsonl);
+	if (junit_path != NULL)
+		write_junit();
+
+	for (i = 0; i < nrecords; i++) {
+		free(records[i].name);
+		free(records[i].output);
+	}
+	free(records);
+}
@@ -0,0 +1,848 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * pts-run: run the built conformance tests with a pool of N workers.
+ *
+ * The syntax is:
+ * $ runner/pts-run [-j jobs] [-t timeout] [-l logfile] [-n]
+ *                  [-P policy] [-p cpus] [-b|-B] [-c cache] [-f]
+ *                  [-J jsonl] [-X junit] [-z] [-e] [-H history] [-T n]
+ *                  [-s i/N[:K]] [-L load] [dir|test ...]
+ * $ runner/pts-run -m [-l logfile] [-J jsonl] [-X junit] jsonl ...
+ *
+ * Tests are found as "locate-test --execs" finds them and every test is
+ * classified as the %.run-test rule of the top-level Makefile does, with
+ * the same "name: execution: VERDICT" lines on stdout and in the logfile.
+ * Given stress/ or a directory below it, pts-run also runs the
+ * scalability tests (s-c*) of the stress areas (see discover.c).
+ * Each test runs in its own process group, with its own TMPDIR and,
+ * where the system permits, its own IPC namespace and /dev/shm (see
+ * isolate.c), so that concurrent tests do not step on each other.
+ * Timing-sensitive tests are kept apart according to their class in the
+ * RUNPOLICY file (see policy.c and sched.c), which can also give them
+ * their own time budget.  A test which overruns its budget has the state
+ * of its threads appended to its output, then is killed (see
+ * supervise.c).  Where cgroup v2 permits, each test also runs in a cgroup
+ * of its own, which bounds what it may take from the machine and
+ * accounts for everything it started (see cgroup.c).
+ *
+ * With -b, the tests are built first (see build.c); -B only builds them.
+ * Builds and results are cached (see cache.c): a test is rebuilt only
+ * when its sources or the build flags change, and run again only when
+ * its executable or the system under test change; otherwise its last
+ * verdict is replayed.  -f ignores the cached results.
+ *
+ * -J and -X also write the results as JSON Lines and JUnit XML, with the
+ * timing and resource usage of each test (see results.c).
+ *
+ * With -z, the tests are forked from a server process which has their
+ * libraries loaded already, rather than executed (see zygote.c).
+ *
+ * With -e, the hardware and scheduler events of each test are counted
+ * and added to its results (see perf.c).
+ *
+ * The durations of the tests are kept from one run to the next (see
+ * history.c): the longest tests are started first, and a test which
+ * takes far longer than it ever did (-T times) is HUNG well before the
+ * -t timeout.
+ *
+ * With -s i/N, only the i-th of N shards of the tests is built and run,
+ * so that N machines share a run; -m merges the JSON Lines files of the
+ * shards into the results of the whole run (see shard.c and merge.c).
+ * To try it on one machine (the shards share the cache and the history,
+ * which are saved under a lock, see cache.c):
+ *
+ * $ for i in 1 2 3 4; do runner/pts-run -s $i/4 -j 2 -J s$i.jsonl -l s$i.log & done; wait
+ * $ runner/pts-run -m -J all.jsonl -X all.xml s1.jsonl s2.jsonl s3.jsonl s4.jsonl
+ *
+ * With -L, the tests run under a background load: CPU spinners, memory
+ * streamers, page cache churn, forks, timer wakeups (see load.c).  What
+ * the load did while each test ran is in its results.
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE		/* wait4() */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "posixtest.h"
+#include "runner.h"
+
+/* Same defaults as the top-level Makefile */
+#define DEFAULT_TIMEOUT	240
+#define DEFAULT_LOGFILE	"./logfile"
+#define DEFAULT_POLICY	"./RUNPOLICY"
+#define DEFAULT_PINNED	4
+#define DEFAULT_CACHE	"./.pts-cache"
+#define DEFAULT_HISTORY	"./.pts-history"
+#define DEFAULT_ADAPT	5
+
+static struct {
+	long jobs;
+	long timeout_ms;
+	const char *logfile;
+	const char *tmproot;
+	int isolate;
+	const char *policy;
+	int pinned;		/* most CPUs reserved for cpu-pinned tests */
+	int build;		/* 0: run only, 1: build and run, 2: build only */
+	const char *cache;
+	int force;
+	const char *jsonl;
+	const char *junit;
+	int zygote;
+	int perf;
+	const char *history;
+	int adapt;		/* timeouts at that many times the past durations */
+	int shard, shards;	/* shard "shard" (from 1) of "shards" */
+	int serial_shards;	/* the first ones, which run the serial tests */
+	int merge;
+	const char *load;
+} opt = {
+	.timeout_ms = DEFAULT_TIMEOUT * 1000,
+	.logfile = DEFAULT_LOGFILE,
+	.isolate = 1,
+	.policy = DEFAULT_POLICY,
+	.pinned = DEFAULT_PINNED,
+	.cache = DEFAULT_CACHE,
+	.history = DEFAULT_HISTORY,
+	.adapt = DEFAULT_ADAPT,
+};
+
+static FILE *logfp;
+static struct test **slots;
+static long running;
+static unsigned long counts[V_NVERDICTS];
+static unsigned long cached;
+static uint64_t syskey;
+
+static void usage(const char *prog)
+{
+	printf("\nUsage: \n");
+	printf("  $ %s [-j jobs] [-t timeout] [-l logfile] [-n]\n", prog);
+	printf("       [-P policy] [-p cpus] [-b|-B] [-d files] [-c cache] [-f]\n");
+	printf("       [-J jsonl] [-X junit] [-z] [-e] [-H history] [-T n]\n");
+	printf("       [-s i/N[:K]] [-L load] [dir|test ...]\n");
+	printf("  $ %s -m [-l logfile] [-J jsonl] [-X junit] jsonl ...\n", prog);
+	printf("\nWhere:\n");
+	printf("  -j jobs     is the number of tests run at once (default: # of CPUs),\n");
+	printf("  -t timeout  is the time after which a test is HUNG, in seconds or with\n");
+	printf("              an ms, s or m suffix (default: %d, see also RUNPOLICY),\n", DEFAULT_TIMEOUT);
+	printf("  -l logfile  is where the results and failure output go (default: %s),\n", DEFAULT_LOGFILE);
+	printf("  -n          disables the IPC namespace isolation of the tests (the\n");
+	printf("              sem_*, mq_* and shm_* tests then run alone),\n");
+	printf("  -P policy   is the file assigning classes to tests (default: %s),\n", DEFAULT_POLICY);
+	printf("  -p cpus     is the most CPUs set aside for cpu-pinned tests (default: %d),\n", DEFAULT_PINNED);
+	printf("  -b          builds the tests before running them, -B only builds them,\n");
+	printf("  -c cache    is the build and result cache (default: %s, \"\" for none),\n", DEFAULT_CACHE);
+	printf("  -f          runs every test again even if its result is cached,\n");
+	printf("  -J jsonl    appends a JSON record per test to that file,\n");
+	printf("  -X junit    writes a JUnit XML report to that file,\n");
+	printf("  -z          forks the tests from a server instead of executing them,\n");
+	printf("  -e          counts the cycles, cache misses, page faults... of each test,\n");
+	printf("  -H history  keeps the durations of the tests (default: %s, \"\" for none),\n", DEFAULT_HISTORY);
+	printf("  -T n        times out a test at n times its longest past duration if that\n");
+	printf("              is sooner than the timeout (default: %d, 0 to disable),\n", DEFAULT_ADAPT);
+	printf("  -s i/N[:K]  runs only the i-th of N shards of the tests, the exclusive and\n");
+	printf("              rt ones going to the first K shards (default: 1),\n");
+	printf("  -m          merges the JSON Lines results of the shards of a run,\n");
+	printf("  -L load     runs the tests under a background load: light, busy, storm\n");
+	printf("              or e.g. cpu=4,mem=1,io=1,fork=1,timer=1000 (see load.c),\n");
+	printf("  dir|test    are the directories to search, or tests to run (default: .);\n");
+	printf("              under stress/, the scalability tests (s-c*) are run too.\n\n");
+}
+
+static void ts_add_ms(struct timespec *ts, long ms)
+{
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (ms % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+static int ts_before(const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec < b->tv_sec ||
+	       (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static int rm_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	(void)st;
+	(void)flag;
+	(void)ftw;
+	remove(path);
+	return 0;
+}
+
+static void rm_tree(const char *path)
+{
+	nftw(path, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/*
+ * Probe once whether the namespace isolation is available, so that we
+ * can tell the user instead of silently running without it.  Without it,
+ * the tests which use named IPC objects run alone.
+ */
+static void probe_isolation(struct testlist *list)
+{
+	pid_t pid;
+	int status;
+	size_t i;
+
+	if (opt.isolate) {
+		pid = fork();
+		if (pid == 0)
+			_exit(isolate_ipc() == 0 ? 0 : 1);
+		if (pid == -1 || waitpid(pid, &status, 0) != pid ||
+		    !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "pts-run: IPC namespaces unavailable, "
+				"the IPC tests run alone\n");
+			opt.isolate = 0;
+		}
+	}
+	if (!opt.isolate)
+		for (i = 0; i < list->n; i++)
+			policy_shared_ipc(&list->v[i]);
+}
+
+/* In the child, before the test runs: also used by the fork server */
+void child_setup(const struct test *t, int outfd)
+{
+	sigset_t set;
+	int fd;
+
+	cgroup_enter(t->cgroup);
+
+	/* Own process group, so that a timeout kills everything the test forked */
+	setpgid(0, 0);
+
+	sigemptyset(&set);
+	sigprocmask(SIG_SETMASK, &set, NULL);
+	signal(SIGCHLD, SIG_DFL);
+
+	fd = open("/dev/null", O_RDONLY);
+	if (fd != -1) {
+		dup2(fd, STDIN_FILENO);
+		close(fd);
+	}
+	dup2(outfd, STDOUT_FILENO);
+	dup2(outfd, STDERR_FILENO);
+	close(outfd);
+
+	setenv("TMPDIR", t->tmpdir, 1);
+	if (opt.isolate)
+		isolate_ipc();
+	isolate_cpus(t->cpu_first, t->cpu_count);
+}
+
+/* "hold": a pipe to wait on until the parent is ready, or -1 */
+static void child_exec(struct test *t, int outfd, int hold)
+{
+	char c;
+
+	child_setup(t, outfd);
+	if (hold != -1) {
+		while (read(hold, &c, 1) == -1 && errno == EINTR)
+			;
+		close(hold);
+	}
+	execl(t->exe, t->exe, (char *)NULL);
+
+	/* Same outcome as t0 when the application could not be launched */
+	perror("Unable to run child application");
+	_exit(PTS_UNRESOLVED);
+}
+
+static void start_test(struct test *t, int slot)
+{
+	char path[4096];
+	int outfd, hold[2] = { -1, -1 };
+
+	if (t->kind == KIND_SH)
+		chmod(t->exe, 0755);
+
+	snprintf(path, sizeof(path), "%s/pts-run.XXXXXX", opt.tmproot);
+	t->tmpdir = strdup(path);
+	if (t->tmpdir == NULL || mkdtemp(t->tmpdir) == NULL) {
+		perror("pts-run: mkdtemp");
+		exit(PTS_UNRESOLVED);
+	}
+
+	snprintf(path, sizeof(path), "%s/output", t->tmpdir);
+	/* O_APPEND: a hang report may be added while the test runs */
+	outfd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (outfd == -1) {
+		perror("pts-run: output file");
+		exit(PTS_UNRESOLVED);
+	}
+
+	t->slot = slot;
+	cgroup_create(t);
+	load_begin(t);
+	clock_gettime(CLOCK_MONOTONIC, &t->start);
+	t->deadline = t->start;
+	t->timeout_used = history_timeout(t, t->timeout_ms ? t->timeout_ms :
+					  opt.timeout_ms, opt.adapt, &t->adaptive);
+	ts_add_ms(&t->deadline, t->timeout_used);
+
+	fflush(stdout);
+	fflush(logfp);
+	t->pid = -1;
+	perf_reset(t);
+	if (opt.zygote && t->zygote && t->kind == KIND_C &&
+	    access(t->so, R_OK) == 0)
+		t->pid = zygote_spawn(t, outfd, opt.perf);
+	if (t->pid == -1) {
+		/* Held before exec() until its counters are attached */
+		if (opt.perf && pipe(hold) == 0) {
+			fcntl(hold[0], F_SETFD, FD_CLOEXEC);
+			fcntl(hold[1], F_SETFD, FD_CLOEXEC);
+		}
+		t->pid = fork();
+		if (t->pid == -1) {
+			perror("pts-run: fork");
+			exit(PTS_UNRESOLVED);
+		}
+		if (t->pid == 0) {
+			if (hold[1] != -1)
+				close(hold[1]);
+			child_exec(t, outfd, hold[0]);
+		}
+		if (hold[1] != -1) {
+			perf_attach(t, 1);
+			close(hold[0]);
+			close(hold[1]);
+		}
+	}
+
+	/* Also done here: we may kill the group before the child ran setpgid */
+	setpgid(t->pid, t->pid);
+	close(outfd);
+	supervise_watch(t);
+
+	slots[slot] = t;
+	running++;
+	sched_started(t);
+}
+
+/*
+ * Translate the wait status as the shell would ($? is 128 + signal) and
+ * then as the %.run-test rule does.
+ */
+static enum verdict classify(const struct test *t)
+{
+	int ret;
+
+	if (t->timedout)
+		return V_HUNG;
+
+	if (WIFEXITED(t->status))
+		ret = WEXITSTATUS(t->status);
+	else if (WIFSIGNALED(t->status))
+		ret = 128 + WTERMSIG(t->status);
+	else
+		ret = 255;
+
+	if (t->kind == KIND_SH)
+		return ret == 0 ? V_PASS : V_FAILED;
+
+	switch (ret) {
+	case PTS_PASS:
+		return V_PASS;
+	case PTS_FAIL:
+		return V_FAILED;
+	case PTS_UNRESOLVED:
+	case 3:
+		return V_UNRESOLVED;
+	case PTS_UNSUPPORTED:
+		return V_UNSUPPORTED;
+	case PTS_UNTESTED:
+		return V_UNTESTED;
+	default:
+		return V_INTERRUPTED;
+	}
+}
+
+/* Read a whole file into a NUL-terminated buffer */
+int read_file(const char *path, char **buf, size_t *len)
+{
+	char chunk[4096], *p;
+	FILE *fp;
+	size_t n;
+
+	*buf = NULL;
+	*len = 0;
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+		p = realloc(*buf, *len + n + 1);
+		if (p == NULL)
+			break;
+		*buf = p;
+		memcpy(*buf + *len, chunk, n);
+		*len += n;
+	}
+	fclose(fp);
+	if (*buf != NULL)
+		(*buf)[*len] = '\0';
+	return 0;
+}
+
+/*
+ * Print a result as the Makefile rules do: PASS (and SKIP) lines go to
+ * both stdout and the logfile, failures get "label" and the output in
+ * the logfile only.
+ */
+void report(const char *name, const char *stage, const char *verdict,
+	    const char *label, const char *output, size_t len)
+{
+	if (label == NULL) {
+		printf("%s: %s: %s\n", name, stage, verdict);
+		fprintf(logfp, "%s: %s: %s\n", name, stage, verdict);
+	} else {
+		printf("%s: %s: %s \n", name, stage, verdict);
+		fprintf(logfp, "%s: %s: %s%s\n", name, stage, verdict, label);
+		if (output != NULL)
+			fwrite(output, 1, len, logfp);
+	}
+	fflush(stdout);
+	fflush(logfp);
+}
+
+static void report_run(const struct test *t, const char *output, size_t len)
+{
+	if (t->verdict == V_PASS)
+		report(t->name, "execution", "PASS", NULL, NULL, 0);
+	else
+		report(t->name, "execution", verdict_names[t->verdict],
+		       ": Output: ", output, len);
+}
+
+static void finish_test(struct test *t, const struct rusage *ru)
+{
+	char path[4096], *output;
+	size_t len;
+
+	load_end(t);
+	supervise_unwatch(t);
+	cgroup_finish(t);
+	perf_finish(t);
+
+	t->verdict = classify(t);
+	counts[t->verdict]++;
+
+	snprintf(path, sizeof(path), "%s/output", t->tmpdir);
+	read_file(path, &output, &len);
+	report_run(t, output, len);
+	results_add(t, ru, output, len);
+	if (*opt.history != '\0')
+		history_put(t, (t->end.tv_sec - t->start.tv_sec) * 1000000L +
+			       (t->end.tv_nsec - t->start.tv_nsec) / 1000);
+	if (t->runkey != 0)
+		cache_put_run(t, t->runkey, output ? output : "", len);
+	free(output);
+
+	rm_tree(t->tmpdir);
+	free(t->tmpdir);
+	t->tmpdir = NULL;
+
+	slots[t->slot] = NULL;
+	running--;
+	sched_done(t);
+}
+
+static void reap(void)
+{
+	struct rusage ru;
+	siginfo_t si;
+	pid_t pid;
+	int status;
+	long i;
+
+	for (;;) {
+		si.si_pid = 0;
+		if (waitid(P_ALL, 0, &si, WEXITED | WNOHANG | WNOWAIT) != 0 ||
+		    si.si_pid == 0)
+			break;
+		pid = si.si_pid;
+
+		for (i = 0; i < opt.jobs; i++)
+			if (slots[i] != NULL && slots[i]->pid == pid)
+				break;
+		/*
+		 * Anything the test left behind in its group goes too, while
+		 * the test is a zombie: its pid, hence its group, cannot have
+		 * been given to another process yet.
+		 */
+		if (i < opt.jobs)
+			kill(-pid, SIGKILL);
+
+		if (wait4(pid, &status, 0, &ru) != pid)
+			break;
+		if (i < opt.jobs) {
+			clock_gettime(CLOCK_MONOTONIC, &slots[i]->end);
+			slots[i]->status = status;
+			finish_test(slots[i], &ru);
+		}
+	}
+}
+
+/*
+ * Kill the expired tests, once their threads are described in their
+ * output, and wait until something happens.
+ */
+static void wait_event(void)
+{
+	struct timespec now, *next = NULL;
+	char path[4096];
+	struct test *t;
+	long i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (i = 0; i < opt.jobs; i++) {
+		t = slots[i];
+		if (t == NULL || t->timedout)
+			continue;
+		if (!ts_before(&now, &t->deadline)) {
+			snprintf(path, sizeof(path), "%s/output", t->tmpdir);
+			supervise_hang_report(t, path, t->timeout_used);
+			t->timedout = 1;
+			kill(-t->pid, SIGKILL);
+			continue;
+		}
+		if (next == NULL || ts_before(&t->deadline, next))
+			next = &t->deadline;
+	}
+
+	supervise_wait(slots, opt.jobs, next);
+}
+
+/*
+ * Replay the cached results and drop those tests from the list.  The
+ * key of the others is kept to cache their result.  The scalability
+ * tests measure the machine as it is now: they always run.
+ */
+static void replay_cached(struct testlist *list)
+{
+	const char *output;
+	struct test *t;
+	size_t i, n = 0, len;
+
+	for (i = 0; i < list->n; i++) {
+		t = &list->v[i];
+		t->runkey = syskey;
+		if (t->kind == KIND_SCAL || hash_file(&t->runkey, t->exe) != 0)
+			t->runkey = 0;
+
+		if (!opt.force && t->runkey != 0 &&
+		    cache_get_run(t, t->runkey, &output, &len)) {
+			counts[t->verdict]++;
+			cached++;
+			report_run(t, output, len);
+			results_add(t, NULL, output, len);
+			continue;
+		}
+		list->v[n++] = *t;
+	}
+	list->n = n;
+}
+
+static void run_all(struct testlist *list)
+{
+	struct test *t;
+	sigset_t chld;
+	long i;
+
+	slots = calloc(opt.jobs, sizeof(*slots));
+	if (slots == NULL) {
+		perror("pts-run");
+		exit(PTS_UNRESOLVED);
+	}
+
+	/* SIGCHLD stays blocked and is only consumed by sigtimedwait */
+	sigemptyset(&chld);
+	sigaddset(&chld, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &chld, NULL);
+	supervise_init(opt.jobs);
+
+	sched_init(list, opt.pinned);
+
+	while (sched_pending() || running > 0) {
+		for (i = 0; i < opt.jobs; i++) {
+			if (slots[i] != NULL)
+				continue;
+			t = sched_next();
+			if (t == NULL)
+				break;
+			start_test(t, i);
+		}
+		wait_event();
+		reap();
+	}
+
+	free(slots);
+}
+
+static void summary(void)
+{
+	unsigned long total = 0;
+	int v;
+
+	for (v = 0; v < V_NVERDICTS; v++)
+		total += counts[v];
+
+	printf("\n\t\t***************************\n");
+	printf("\t\t* TOTAL:  %lu\n", total);
+	for (v = 0; v < V_NVERDICTS; v++)
+		printf("\t\t* %s: %lu\n", verdict_names[v], counts[v]);
+	if (cached)
+		printf("\t\t* (of which replayed from cache: %lu)\n", cached);
+	printf("\t\t***************************\n");
+}
+
+/* pts-run -m: report the results of the shards as one run */
+static int merge(char **files, int nfiles)
+{
+	struct merged *v;
+	size_t n, i;
+
+	logfp = fopen(opt.logfile, "a");
+	if (logfp == NULL) {
+		perror(opt.logfile);
+		return PTS_UNRESOLVED;
+	}
+	if (results_open(opt.jsonl, opt.junit) != 0 ||
+	    merge_load(files, nfiles, &v, &n) != 0)
+		return PTS_UNRESOLVED;
+
+	for (i = 0; i < n; i++) {
+		results_origin(v[i].kernel ? v[i].kernel : "",
+			       v[i].libc ? v[i].libc : "",
+			       v[i].shard ? v[i].shard : "",
+			       v[i].load ? v[i].load : "");
+		counts[v[i].t.verdict]++;
+		if (v[i].cached)
+			cached++;
+		report_run(&v[i].t, v[i].output, v[i].len);
+		results_add(&v[i].t, v[i].cached ? NULL : &v[i].ru,
+			    v[i].output, v[i].len);
+	}
+	summary();
+	results_close();
+
+	merge_free(v, n);
+	fclose(logfp);
+	return PTS_PASS;
+}
+
+int main(int argc, char *argv[])
+{
+	struct testlist list = { NULL, 0, 0 };
+	char shard[32];
+	int c, i;
+
+	while ((c = getopt(argc, argv, "j:t:l:nP:p:bBc:fJ:X:zeH:T:s:mL:h")) != -1) {
+		switch (c) {
+		case 'j':
+			opt.jobs = atol(optarg);
+			break;
+		case 't':
+			if (parse_duration(optarg, &opt.timeout_ms) != 0)
+				opt.timeout_ms = -1;
+			break;
+		case 'l':
+			opt.logfile = optarg;
+			break;
+		case 'n':
+			opt.isolate = 0;
+			break;
+		case 'P':
+			opt.policy = optarg;
+			break;
+		case 'p':
+			opt.pinned = atoi(optarg);
+			break;
+		case 'b':
+			opt.build = 1;
+			break;
+		case 'B':
+			opt.build = 2;
+			break;
+		case 'c':
+			opt.cache = optarg;
+			break;
+		case 'f':
+			opt.force = 1;
+			break;
+		case 'J':
+			opt.jsonl = optarg;
+			break;
+		case 'X':
+			opt.junit = optarg;
+			break;
+		case 'z':
+			opt.zygote = 1;
+			break;
+		case 'e':
+			opt.perf = 1;
+			break;
+		case 'H':
+			opt.history = optarg;
+			break;
+		case 'T':
+			opt.adapt = atoi(optarg);
+			break;
+		case 's':
+			if (parse_shard(optarg, &opt.shard, &opt.shards,
+					&opt.serial_shards) != 0) {
+				fprintf(stderr, "Invalid shard \"%s\", expected i/N or i/N:K.\n",
+					optarg);
+				return PTS_UNRESOLVED;
+			}
+			break;
+		case 'm':
+			opt.merge = 1;
+			break;
+		case 'L':
+			if (load_parse(optarg) != 0)
+				return PTS_UNRESOLVED;
+			opt.load = optarg;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return PTS_PASS;
+		default:
+			usage(argv[0]);
+			return PTS_UNRESOLVED;
+		}
+	}
+
+	if (opt.jobs <= 0)
+		opt.jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (opt.jobs <= 0)
+		opt.jobs = 1;
+	if (opt.timeout_ms < 1) {
+		fprintf(stderr, "Invalid timeout value. Timeout must be a positive duration.\n");
+		return PTS_UNRESOLVED;
+	}
+	opt.tmproot = getenv("TMPDIR");
+	if (opt.tmproot == NULL || *opt.tmproot == '\0')
+		opt.tmproot = "/tmp";
+
+	if (opt.merge)
+		return merge(argv + optind, argc - optind);
+
+	if (optind == argc) {
+		if (discover(&list, ".") != 0)
+			return PTS_UNRESOLVED;
+	}
+	for (i = optind; i < argc; i++) {
+		if (discover(&list, argv[i]) != 0)
+			return PTS_UNRESOLVED;
+	}
+	testlist_sort(&list);
+
+	if (policy_load(opt.policy) != 0)
+		return PTS_UNRESOLVED;
+	for (i = 0; i < (int)list.n; i++)
+		policy_apply(&list.v[i]);
+	if (*opt.history != '\0') {
+		history_load(opt.history);
+		for (i = 0; i < (int)list.n; i++)
+			history_get(&list.v[i]);
+	}
+	if (opt.shards) {
+		shard_select(&list, opt.shard, opt.shards, opt.serial_shards,
+			     opt.jobs);
+		snprintf(shard, sizeof(shard), "%d/%d", opt.shard, opt.shards);
+		results_origin(NULL, NULL, shard, NULL);
+	}
+	if (opt.load != NULL)
+		results_origin(NULL, NULL, NULL, load_profile());
+
+	logfp = fopen(opt.logfile, "a");
+	if (logfp == NULL) {
+		perror(opt.logfile);
+		return PTS_UNRESOLVED;
+	}
+
+	if (*opt.cache != '\0')
+		cache_load(opt.cache);
+
+	if (opt.build) {
+		build_all(&list, opt.jobs, opt.tmproot, *opt.cache != '\0',
+			  opt.zygote);
+		if (*opt.cache != '\0')
+			cache_save(opt.cache);
+		if (opt.build == 2) {
+			fclose(logfp);
+			return PTS_PASS;
+		}
+	}
+
+	/* As in the Makefile, tests which were not built are silently skipped */
+	testlist_runnable(&list);
+	testlist_prune(&list);
+
+	if (results_open(opt.jsonl, opt.junit) != 0)
+		return PTS_UNRESOLVED;
+
+	if (*opt.cache != '\0') {
+		syskey = system_key();
+		/* A result under a load is not one on an idle system */
+		if (opt.load != NULL)
+			syskey = hash_str(syskey, load_profile());
+		replay_cached(&list);
+	}
+
+	probe_isolation(&list);
+	cgroup_init();
+	if (opt.perf) {
+		if (perf_init() == 0) {
+			setenv("PTS_PERF", "1", 1);
+		} else {
+			fprintf(stderr, "pts-run: no performance counters, "
+				"the tests are not counted\n");
+			opt.perf = 0;
+		}
+	}
+	if (opt.zygote && zygote_start() != 0) {
+		fprintf(stderr, "pts-run: no fork server, the tests are executed\n");
+		opt.zygote = 0;
+	}
+
+	if (load_start(opt.tmproot) != 0)
+		return PTS_UNRESOLVED;
+
+	run_all(&list);
+	load_stop();
+	zygote_stop();
+	cgroup_cleanup();
+	summary();
+	results_close();
+
+	if (*opt.cache != '\0' && cache_save(opt.cache) != 0)
+		fprintf(stderr, "pts-run: could not save %s\n", opt.cache);
+	if (*opt.history != '\0' && history_save(opt.history) != 0)
+		fprintf(stderr, "pts-run: could not save %s\n", opt.history);
+
+	fclose(logfp);
+	return PTS_PASS;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Shared definitions for the parallel test runner (pts-run).
+ */
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/* 64-bit FNV-1a, see cache.c */
+#define FNV_OFFSET	0xcbf29ce484222325ULL
+#define FNV_PRIME	0x100000001b3ULL
+
+/*
+ * Verdicts, named as the %.run-test rule of the top-level Makefile
+ * prints them so that logs from both paths can be compared.
+ */
+enum verdict {
+	V_PASS = 0,
+	V_FAILED,
+	V_UNRESOLVED,
+	V_UNSUPPORTED,
+	V_UNTESTED,
+	V_HUNG,
+	V_INTERRUPTED,
+	V_NVERDICTS
+};
+
+enum test_kind {
+	KIND_C,		/* NUMBER-NUMBER.c, runs NUMBER-NUMBER.test */
+	KIND_SH,	/* NUMBER-NUMBER.sh, runs the script itself */
+	KIND_SCAL,	/* stress s-c*.c, built by the Makefile next to it */
+};
+
+/* Usage of a test's cgroup, -1 where not known (see cgroup.c) */
+struct cg_usage {
+	long long memory_peak;	/* bytes */
+	long long pids_peak;
+	long long cpu_usec;
+	long long user_usec;
+	long long system_usec;
+	long long throttled_usec;
+	long long oom_kill;
+};
+
+/* Counters of pts-run -e, see perf.c */
+enum event {
+	EV_CYCLES = 0,
+	EV_INSTRUCTIONS,
+	EV_CACHE_MISSES,
+	EV_BRANCH_MISSES,
+	EV_CONTEXT_SWITCHES,
+	EV_CPU_MIGRATIONS,
+	EV_PAGE_FAULTS,
+	EV_NEVENTS
+};
+
+/* Background loads of pts-run -L, see load.c */
+enum load_kind {
+	LOAD_CPU = 0,
+	LOAD_MEM,
+	LOAD_IO,
+	LOAD_FORK,
+	LOAD_TIMER,
+	LOAD_NKINDS
+};
+
+/* See sched.c */
+enum run_class {
+	CLASS_PARALLEL = 0,
+	CLASS_PINNED,
+	CLASS_EXCLUSIVE,
+	CLASS_RT,
+	CLASS_NCLASSES
+};
+
+struct test {
+	char *name;		/* path without the extension */
+	char *exe;		/* what we actually execute */
+	char *src;		/* KIND_C: the source and object files */
+	char *obj;
+	char *so;		/* KIND_C: shared object for pts-run -z */
+	enum test_kind kind;
+	int build;		/* needs compiling (NUMBER-*.c, s-c*.c) */
+	int run;		/* is executed (not -buildonly) */
+	uint64_t buildkey;	/* see build.c */
+	uint64_t runkey;	/* see cache.c */
+
+	/* Policy, see policy.c */
+	enum run_class class;
+	long timeout_ms;	/* 0: the -t value */
+	int zygote;		/* may run from the fork server */
+	long expect_us;		/* median past duration, 0: unknown */
+	long longest_us;	/* see history.c */
+	int nruns;
+	const char *pids_max;	/* cgroup limits, NULL for none */
+	const char *memory_max;
+	const char *cpu_max;	/* percent of a CPU */
+
+	/* Scheduling state */
+	int started;
+	int cpu_first;		/* CPUs the test is bound to, see isolate.c */
+	int cpu_count;		/* 0 means not bound */
+
+	/* Execution state, only meaningful while the test runs */
+	pid_t pid;
+	int pidfd;		/* see supervise.c */
+	int slot;
+	char *tmpdir;
+	char *cgroup;		/* NULL when the test has none */
+	int perf_fd[EV_NEVENTS];	/* -1 when not counted */
+	struct timespec start;
+	struct timespec end;
+	struct timespec deadline;
+	long timeout_used;	/* ms, from the policy or the history */
+	int adaptive;		/* timeout_used comes from the history */
+	int timedout;
+
+	/* Outcome */
+	int status;		/* raw wait status */
+	enum verdict verdict;
+	struct cg_usage cg;
+	long long events[EV_NEVENTS];	/* -1 when not counted */
+	long long load[LOAD_NKINDS];	/* done by the load meanwhile, -1: none */
+};
+
+struct testlist {
+	struct test *v;
+	size_t n;
+	size_t alloc;
+};
+
+/* discover.c */
+int discover(struct testlist *list, const char *root);
+void testlist_sort(struct testlist *list);
+void testlist_prune(struct testlist *list);
+void testlist_runnable(struct testlist *list);
+void testlist_keep(struct testlist *list, const char *keep);
+
+/* cgroup.c */
+int cgroup_init(void);
+void cgroup_create(struct test *t);
+void cgroup_enter(const char *dir);
+void cgroup_finish(struct test *t);
+void cgroup_cleanup(void);
+
+/* history.c */
+void history_load(const char *path);
+int history_save(const char *path);
+void history_get(struct test *t);
+long history_timeout(const struct test *t, long budget_ms, int adapt,
+		     int *adaptive);
+void history_put(const struct test *t, long us);
+
+/* isolate.c */
+int isolate_ipc(void);
+int cpus_init(void);
+int isolate_cpus(int first, int count);
+
+/* load.c */
+extern const char *load_names[LOAD_NKINDS];
+int load_parse(const char *profile);
+int load_start(const char *tmpdir);
+const char *load_profile(void);
+void load_read(long long v[LOAD_NKINDS]);
+void load_begin(struct test *t);
+void load_end(struct test *t);
+void load_stop(void);
+
+/* perf.c */
+extern const char *event_names[EV_NEVENTS];
+void perf_reset(struct test *t);
+int perf_init(void);
+void perf_attach(struct test *t, int on_exec);
+void perf_finish(struct test *t);
+
+/* policy.c */
+extern const char *class_names[CLASS_NCLASSES];
+int parse_duration(const char *s, long *ms);
+int policy_load(const char *path);
+void policy_apply(struct test *t);
+void policy_shared_ipc(struct test *t);
+
+/* sched.c */
+void sched_init(struct testlist *list, int want_pinned);
+struct test *sched_next(void);
+void sched_started(struct test *t);
+void sched_done(struct test *t);
+int sched_pending(void);
+
+/* shard.c */
+int parse_shard(const char *s, int *index, int *count, int *serial);
+void shard_select(struct testlist *list, int index, int count, int serial,
+		  long jobs);
+
+/* merge.c */
+struct merged {
+	struct test t;
+	struct rusage ru;
+	int cached;		/* no timing nor resource usage */
+	char *output;
+	size_t len;
+	char *kernel;
+	char *libc;
+	char *shard;
+	char *load;
+};
+int merge_read(const char *file, struct merged **v, size_t *n);
+int merge_load(char **files, int nfiles, struct merged **v, size_t *n);
+void merge_free(struct merged *v, size_t n);
+
+/* supervise.c */
+void supervise_init(long slots);
+void supervise_watch(struct test *t);
+void supervise_unwatch(struct test *t);
+void supervise_wait(struct test **slots, long n, const struct timespec *deadline);
+void supervise_hang_report(const struct test *t, const char *path, long ms);
+
+/* build.c */
+void build_all(struct testlist *list, long jobs, const char *tmproot,
+	       int use_cache, int shared);
+
+/* cache.c */
+uint64_t hash_bytes(uint64_t h, const void *buf, size_t len);
+uint64_t hash_str(uint64_t h, const char *s);
+int hash_file(uint64_t *h, const char *path);
+uint64_t system_key(void);
+int lock_path(const char *path);
+void cache_load(const char *path);
+int cache_save(const char *path);
+int cache_get_build(const char *name, uint64_t key, int *main_);
+void cache_put_build(const char *name, uint64_t key, int main_);
+void cache_drop_build(const char *name);
+int cache_get_run(struct test *t, uint64_t key, const char **output, size_t *len);
+void cache_put_run(const struct test *t, uint64_t key, const char *output, size_t len);
+
+/* results.c */
+extern const char *verdict_names[V_NVERDICTS];
+int results_open(const char *jsonl_path, const char *junit);
+void results_origin(const char *kernel, const char *libc, const char *shard,
+		    const char *load);
+void results_add(const struct test *t, const struct rusage *ru,
+		 const char *output, size_t len);
+void results_close(void);
+
+/* zygote.c */
+int zygote_start(void);
+pid_t zygote_spawn(struct test *t, int outfd, int count);
+void zygote_stop(void);
+
+/* runner.c */
+int read_file(const char *path, char **buf, size_t *len);
+void report(const char *name, const char *stage, const char *verdict,
+	    const char *label, const char *output, size_t len);
+void child_setup(const struct test *t, int outfd);
+
+#endif /* RUNNER_H */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Scheduling of the tests onto the workers, according to their class:
+ *
+ * parallel-safe  run on the shared CPUs, alongside any other such test.
+ * cpu-pinned     run on a CPU of their own: a few CPUs are set aside for
+ *                them, and no other test is allowed onto those.
+ * exclusive      run alone on the machine.
+ * rt             run alone on the machine, bound to a single CPU, which
+ *                is what the SCHED_FIFO/SCHED_RR ordering tests assume.
+ *
+ * The exclusive and rt tests are moved to the end of the queue, so the
+ * workers are drained only once rather than each time one comes up.
+ * Without a CPU to spare for pinning, cpu-pinned tests are run as
+ * exclusive ones.
+ *
+ * Otherwise the longest tests go first, as far as their past durations
+ * tell (see history.c), so that the run does not end with a few long
+ * tests on otherwise idle workers.  A test never run before is taken to
+ * last as long as the average test.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runner.h"
+
+static struct testlist *queue;
+static size_t first;		/* all tests before this one were started */
+static long running;
+static int exclusive_running;
+
+static long unknown_us;		/* expected duration of new tests */
+
+static int npinned;		/* CPUs [0, npinned) are for cpu-pinned tests */
+static int ncpus;
+static char *pinned_busy;
+
+static int is_exclusive(const struct test *t)
+{
+	if (t->class == CLASS_PINNED)
+		return npinned == 0;
+	return t->class == CLASS_EXCLUSIVE || t->class == CLASS_RT;
+}
+
+static long expected(const struct test *t)
+{
+	return t->nruns ? t->expect_us : unknown_us;
+}
+
+static int cmp_queue(const void *a, const void *b)
+{
+	int ea = is_exclusive(a), eb = is_exclusive(b);
+	long da = expected(a), db = expected(b);
+
+	if (ea != eb)
+		return ea - eb;
+	if (da != db)
+		return da > db ? -1 : 1;
+	return strcmp(((const struct test *)a)->name,
+		      ((const struct test *)b)->name);
+}
+
+/*
+ * Set the CPUs aside and order the queue.  "want_pinned" is the most
+ * CPUs we may reserve for the cpu-pinned tests.
+ */
+void sched_init(struct testlist *list, int want_pinned)
+{
+	size_t i, pinned = 0, known = 0;
+	double total = 0;
+
+	queue = list;
+	ncpus = cpus_init();
+
+	for (i = 0; i < list->n; i++) {
+		if (list->v[i].class == CLASS_PINNED)
+			pinned++;
+		if (list->v[i].nruns) {
+			total += list->v[i].expect_us;
+			known++;
+		}
+	}
+	unknown_us = known ? total / known : 0;
+
+	/* Keep at least one CPU for everybody else */
+	npinned = want_pinned;
+	if ((size_t)npinned > pinned)
+		npinned = pinned;
+	if (npinned > ncpus - 1)
+		npinned = ncpus - 1;
+	if (npinned < 0)
+		npinned = 0;
+
+	pinned_busy = calloc(npinned + 1, 1);
+	if (pinned_busy == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+
+	qsort(list->v, list->n, sizeof(*list->v), cmp_queue);
+}
+
+static int can_start(struct test *t)
+{
+	int c;
+
+	if (exclusive_running)
+		return 0;
+
+	if (is_exclusive(t)) {
+		if (running > 0)
+			return 0;
+		t->cpu_first = 0;
+		t->cpu_count = t->class == CLASS_RT ? 1 : 0;
+		return 1;
+	}
+
+	if (t->class == CLASS_PINNED) {
+		for (c = 0; c < npinned; c++) {
+			if (!pinned_busy[c]) {
+				t->cpu_first = c;
+				t->cpu_count = 1;
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	/* parallel-safe: everything but the reserved CPUs */
+	t->cpu_first = npinned;
+	t->cpu_count = npinned ? ncpus - npinned : 0;
+	return 1;
+}
+
+/* The next test which may start now, or NULL */
+struct test *sched_next(void)
+{
+	struct test *t;
+	size_t i;
+
+	while (first < queue->n && queue->v[first].started)
+		first++;
+
+	for (i = first; i < queue->n; i++) {
+		t = &queue->v[i];
+		if (t->started)
+			continue;
+		if (can_start(t))
+			return t;
+		/* Nothing may overtake a waiting exclusive test */
+		if (is_exclusive(t))
+			break;
+	}
+	return NULL;
+}
+
+void sched_started(struct test *t)
+{
+	t->started = 1;
+	running++;
+	if (is_exclusive(t))
+		exclusive_running = 1;
+	else if (t->class == CLASS_PINNED)
+		pinned_busy[t->cpu_first] = 1;
+}
+
+void sched_done(struct test *t)
+{
+	running--;
+	if (is_exclusive(t))
+		exclusive_running = 0;
+	else if (t->class == CLASS_PINNED)
+		pinned_busy[t->cpu_first] = 0;
+}
+
+int sched_pending(void)
+{
+	while (first < queue->n && queue->v[first].started)
+		first++;
+	return first < queue->n;
+}
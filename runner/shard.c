@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Sharding (pts-run -s i/N): N machines, or N pts-run processes, each
+ * run a part of the tests, and their results are merged afterwards
+ * (pts-run -m, see merge.c).
+ *
+ * The tests are packed into the shards longest first, each into the
+ * shard which is the least loaded so far, by their past durations (see
+ * history.c); a test never run is taken to last as long as the average
+ * test.  The build-only tests never run: they are left out of the
+ * packing and dealt to the shards in turn, for their builds.
+ *
+ * The load of a shard is the time it should take: the exclusive and rt
+ * tests run alone, so they count for their whole duration, the others
+ * for their duration divided by the -j workers.
+ *
+ * The exclusive and rt tests need a quiet machine and only go to the
+ * first K shards (-s i/N:K, K is 1 by default), which then get fewer of
+ * the other tests.
+ *
+ * Every shard computes the same partition on its own, as long as they
+ * all see the same tests, the same RUNPOLICY, the same history file and
+ * the same -j: give them a copy of one .pts-history (-H) rather than the
+ * history of the machine they happen to run on.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runner.h"
+
+struct item {
+	struct test *t;
+	double us;
+	int serial;		/* exclusive or rt */
+};
+
+/* "i/N" or "i/N:K"; returns -1 if malformed */
+int parse_shard(const char *s, int *index, int *count, int *serial)
+{
+	char *end;
+	long v;
+
+	v = strtol(s, &end, 10);
+	if (end == s || *end != '/' || v < 1)
+		return -1;
+	*index = v;
+	s = end + 1;
+	v = strtol(s, &end, 10);
+	if (end == s || v < *index)
+		return -1;
+	*count = v;
+	*serial = 1;
+	if (*end == ':') {
+		s = end + 1;
+		v = strtol(s, &end, 10);
+		if (end == s || v < 1 || v > *count)
+			return -1;
+		*serial = v;
+	}
+	return *end == '\0' ? 0 : -1;
+}
+
+static int cmp_item(const void *a, const void *b)
+{
+	const struct item *x = a, *y = b;
+
+	if (x->serial != y->serial)
+		return y->serial - x->serial;
+	if (x->us != y->us)
+		return x->us > y->us ? -1 : 1;
+	return strcmp(x->t->name, y->t->name);
+}
+
+/* Keep only the tests of shard "index" (from 1) out of "count" */
+void shard_select(struct testlist *list, int index, int count, int serial,
+		  long jobs)
+{
+	double *load, total = 0, unknown;
+	struct item *items;
+	char *mine;
+	size_t i, n = 0, known = 0;
+	int s, best, nshards, turn = 0;
+
+	items = malloc(list->n * sizeof(*items));
+	load = calloc(count, sizeof(*load));
+	mine = calloc(list->n + 1, 1);
+	if ((items == NULL && list->n > 0) || load == NULL || mine == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+
+	for (i = 0; i < list->n; i++) {
+		if (list->v[i].nruns) {
+			total += list->v[i].expect_us;
+			known++;
+		}
+	}
+	unknown = known ? total / known : 1;
+
+	for (i = 0; i < list->n; i++) {
+		if (!list->v[i].run) {
+			if (turn++ % count == index - 1)
+				mine[i] = 1;
+			continue;
+		}
+		items[n].t = &list->v[i];
+		items[n].us = list->v[i].nruns ? list->v[i].expect_us : unknown;
+		items[n].serial = list->v[i].class == CLASS_EXCLUSIVE ||
+				  list->v[i].class == CLASS_RT;
+		n++;
+	}
+	/* The serial tests first, each group longest first */
+	qsort(items, n, sizeof(*items), cmp_item);
+
+	for (i = 0; i < n; i++) {
+		nshards = items[i].serial ? serial : count;
+		best = 0;
+		for (s = 1; s < nshards; s++)
+			if (load[s] < load[best])
+				best = s;
+		load[best] += items[i].serial ? items[i].us : items[i].us / jobs;
+		if (best == index - 1)
+			mine[items[i].t - list->v] = 1;
+	}
+
+	testlist_keep(list, mine);
+
+	free(items);
+	free(load);
+	free(mine);
+}
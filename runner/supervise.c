@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Supervision of the running tests: waiting for them to exit or for the
+ * nearest deadline, and describing a test which has hung.
+ *
+ * On Linux, each test is watched through a pidfd, and the deadlines
+ * through a timerfd armed on CLOCK_MONOTONIC, so that a test is killed
+ * within a millisecond of its budget.  Where pidfds are missing, a
+ * signalfd for SIGCHLD is polled instead.  Elsewhere, sigtimedwait()
+ * does the job.
+ *
+ * Before a hung test is killed, the state of every thread of every
+ * process in its group is appended to its output: the scheduler state,
+ * the wait channel, the current system call and, when we are allowed to
+ * read it, the kernel stack, all from /proc/<pid>/task/<tid>/.  The
+ * HUNG verdict then says where the test was stuck.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#endif
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+#ifdef __linux__
+static int timer_fd = -1;
+static int signal_fd = -1;
+static struct pollfd *fds;
+#endif
+
+/* SIGCHLD must already be blocked */
+void supervise_init(long slots)
+{
+#ifdef __linux__
+	sigset_t chld;
+
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	sigemptyset(&chld);
+	sigaddset(&chld, SIGCHLD);
+	signal_fd = signalfd(-1, &chld, SFD_CLOEXEC | SFD_NONBLOCK);
+
+	fds = calloc(slots + 2, sizeof(*fds));
+	if (fds == NULL) {
+		perror("pts-run");
+		exit(2);
+	}
+#else
+	(void)slots;
+#endif
+}
+
+void supervise_watch(struct test *t)
+{
+	t->pidfd = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+	t->pidfd = syscall(SYS_pidfd_open, t->pid, 0);
+#endif
+}
+
+void supervise_unwatch(struct test *t)
+{
+	if (t->pidfd != -1)
+		close(t->pidfd);
+	t->pidfd = -1;
+}
+
+#ifdef __linux__
+static int wait_poll(struct test **slots, long n, const struct timespec *deadline)
+{
+	struct itimerspec its;
+	struct signalfd_siginfo si;
+	uint64_t ticks;
+	int nfds = 0, need_signals = 0;
+	long i;
+
+	if (timer_fd == -1)
+		return -1;
+
+	memset(&its, 0, sizeof(its));
+	if (deadline != NULL) {
+		its.it_value = *deadline;
+		/* A zero it_value would disarm the timer */
+		if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+			its.it_value.tv_nsec = 1;
+	}
+	if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+		return -1;
+
+	fds[nfds].fd = timer_fd;
+	fds[nfds++].events = POLLIN;
+	for (i = 0; i < n; i++) {
+		if (slots[i] == NULL)
+			continue;
+		if (slots[i]->pidfd == -1) {
+			need_signals = 1;
+			continue;
+		}
+		fds[nfds].fd = slots[i]->pidfd;
+		fds[nfds++].events = POLLIN;
+	}
+	if (need_signals) {
+		if (signal_fd == -1)
+			return -1;
+		fds[nfds].fd = signal_fd;
+		fds[nfds++].events = POLLIN;
+	}
+
+	if (poll(fds, nfds, -1) == -1 && errno != EINTR)
+		return -1;
+
+	/* Drain the level-triggered sources; reap() collects the exits */
+	while (read(timer_fd, &ticks, sizeof(ticks)) > 0)
+		;
+	if (signal_fd != -1)
+		while (read(signal_fd, &si, sizeof(si)) > 0)
+			;
+	return 0;
+}
+#endif
+
+/*
+ * Wait until a test may have exited or "deadline" (CLOCK_MONOTONIC, may
+ * be NULL) is reached.  SIGCHLD is blocked.
+ */
+void supervise_wait(struct test **slots, long n, const struct timespec *deadline)
+{
+	struct timespec now, wait;
+	sigset_t chld;
+
+#ifdef __linux__
+	if (wait_poll(slots, n, deadline) == 0)
+		return;
+#else
+	(void)slots;
+	(void)n;
+#endif
+
+	wait.tv_sec = 1;
+	wait.tv_nsec = 0;
+	if (deadline != NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		wait.tv_sec = deadline->tv_sec - now.tv_sec;
+		wait.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+		if (wait.tv_nsec < 0) {
+			wait.tv_sec--;
+			wait.tv_nsec += 1000000000;
+		}
+		if (wait.tv_sec < 0)
+			return;
+	}
+	sigemptyset(&chld);
+	sigaddset(&chld, SIGCHLD);
+	sigtimedwait(&chld, NULL, &wait);
+}
+
+#ifdef __linux__
+static void dump_file(FILE *out, const char *prefix, const char *path)
+{
+	char line[512];
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		fprintf(out, "%s%s", prefix, line);
+		if (strchr(line, '\n') == NULL)
+			fputc('\n', out);
+	}
+	fclose(fp);
+}
+
+/* Process group and state of a process or thread, from its stat file */
+static int read_stat(const char *path, char *comm, size_t commlen,
+		     char *state, pid_t *pgrp)
+{
+	char buf[1024], *lp, *rp;
+	int ppid, grp;
+	size_t n;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	n = fread(buf, 1, sizeof(buf) - 1, fp);
+	fclose(fp);
+	buf[n] = '\0';
+
+	/* The command may contain spaces and parentheses */
+	lp = strchr(buf, '(');
+	rp = strrchr(buf, ')');
+	if (lp == NULL || rp == NULL || rp < lp)
+		return -1;
+	snprintf(comm, commlen, "%.*s", (int)(rp - lp - 1), lp + 1);
+	if (sscanf(rp + 1, " %c %d %d", state, &ppid, &grp) != 3)
+		return -1;
+	*pgrp = grp;
+	return 0;
+}
+
+static void dump_process(FILE *out, pid_t pid)
+{
+	char path[512], comm[64], wchan[128], state;
+	struct dirent *de;
+	pid_t pgrp;
+	DIR *dir;
+	FILE *fp;
+	size_t n;
+
+	snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+	dir = opendir(path);
+	if (dir == NULL)
+		return;
+
+	while ((de = readdir(dir)) != NULL) {
+		if (de->d_name[0] < '0' || de->d_name[0] > '9')
+			continue;
+
+		snprintf(path, sizeof(path), "/proc/%d/task/%s/stat",
+			 (int)pid, de->d_name);
+		if (read_stat(path, comm, sizeof(comm), &state, &pgrp) != 0)
+			continue;
+
+		wchan[0] = '\0';
+		snprintf(path, sizeof(path), "/proc/%d/task/%s/wchan",
+			 (int)pid, de->d_name);
+		fp = fopen(path, "r");
+		if (fp != NULL) {
+			n = fread(wchan, 1, sizeof(wchan) - 1, fp);
+			wchan[n] = '\0';
+			fclose(fp);
+		}
+
+		fprintf(out, "pid %d tid %s (%s) state %c wchan %s\n", (int)pid,
+			de->d_name, comm, state, wchan[0] ? wchan : "-");
+		snprintf(path, sizeof(path), "/proc/%d/task/%s/syscall",
+			 (int)pid, de->d_name);
+		dump_file(out, "  syscall: ", path);
+		snprintf(path, sizeof(path), "/proc/%d/task/%s/stack",
+			 (int)pid, de->d_name);
+		dump_file(out, "  ", path);
+	}
+	closedir(dir);
+}
+#endif
+
+/* Append the state of every thread of the group of t to "path" */
+void supervise_hang_report(const struct test *t, const char *path, long ms)
+{
+	FILE *out;
+#ifdef __linux__
+	char stat[256], comm[64], state;
+	struct dirent *de;
+	pid_t pid, pgrp;
+	DIR *proc;
+#endif
+
+	out = fopen(path, "a");
+	if (out == NULL)
+		return;
+	fprintf(out, "\npts-run: no exit after %ld ms%s, state of process group %d:\n",
+		ms, t->adaptive ? " (from its past durations)" : "", (int)t->pid);
+
+#ifdef __linux__
+	proc = opendir("/proc");
+	if (proc != NULL) {
+		while ((de = readdir(proc)) != NULL) {
+			pid = atoi(de->d_name);
+			if (pid <= 0)
+				continue;
+			snprintf(stat, sizeof(stat), "/proc/%d/stat", (int)pid);
+			if (read_stat(stat, comm, sizeof(comm), &state, &pgrp) == 0 &&
+			    pgrp == t->pid)
+				dump_process(out, pid);
+		}
+		closedir(proc);
+	}
+#endif
+	fclose(out);
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Fork server of pts-run -z.
+ *
+ * Most tests run for a few milliseconds, less than it takes to exec them
+ * and have the dynamic linker map and relocate libc, libpthread and
+ * librt.  With -z, the tests are also linked as shared objects (NAME.so,
+ * see build.c), and a server process started once, with those libraries
+ * already loaded, forks a child per test which loads the test and calls
+ * its main().  A test without its shared object, or which RUNPOLICY says
+ * must be executed (zygote=no), is executed as usual.
+ *
+ * The server has a single thread and never runs a test itself, so each
+ * test starts in a fresh single-threaded process, as after exec: the
+ * fork, signal and scheduling tests keep their meaning.  The test is
+ * forked by an intermediate process which exits at once, and pts-run, a
+ * child subreaper, adopts it: pts-run waits for it, watches it and gets
+ * its resource usage as for an executed test.  The test itself waits to
+ * be adopted before it starts, so that getppid() is pts-run.
+ *
+ * pts-run sends one request per test on a socket, with the output file
+ * of the test; the intermediate process answers with the test's pid.
+ * With pts-run -e, it then waits for pts-run to have attached counters
+ * to the test (see perf.c) before it exits.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "posixtest.h"
+#include "runner.h"
+
+#ifdef __linux__
+#define ZYGOTE_PATH	1024
+
+struct request {
+	int count;		/* hold the test until pts-run counts it */
+	int slot;
+	int cpu_first;
+	int cpu_count;
+	char so[ZYGOTE_PATH];
+	char exe[ZYGOTE_PATH];
+	char tmpdir[ZYGOTE_PATH];
+	char cgroup[ZYGOTE_PATH];
+};
+
+/* What the tests link with (LDFLAGS), by their glibc soname */
+static const char *preload[] = {
+	"libpthread.so.0",
+	"librt.so.1",
+	"libm.so.6",
+	"libdl.so.2",
+};
+
+static int sock = -1;
+static pid_t server = -1;
+
+extern char **environ;
+
+/*
+ * In the test process: wait for pts-run to adopt us, i.e. for "parent"
+ * to exit, then run the test.
+ */
+static void run_test(const struct request *rq, int outfd, pid_t parent,
+		     pid_t runner)
+{
+	int (*test_main)(int, char **, char **);
+	struct pollfd pfd = { -1, POLLIN, 0 };
+	pid_t ppid;
+	struct test t;
+	char *argv[2];
+	void *h;
+
+	/* The pidfd of the parent is readable once we have been adopted */
+#ifdef SYS_pidfd_open
+	if (getppid() == parent)
+		pfd.fd = syscall(SYS_pidfd_open, parent, 0);
+#endif
+	if (pfd.fd != -1) {
+		while (poll(&pfd, 1, -1) == -1 && errno == EINTR)
+			;
+		close(pfd.fd);
+	}
+	while ((ppid = getppid()) != runner) {
+		if (ppid != parent)
+			_exit(PTS_UNRESOLVED);
+		usleep(10);
+	}
+
+	memset(&t, 0, sizeof(t));
+	t.slot = rq->slot;
+	t.cpu_first = rq->cpu_first;
+	t.cpu_count = rq->cpu_count;
+	t.tmpdir = (char *)rq->tmpdir;
+	t.cgroup = (char *)rq->cgroup;
+	child_setup(&t, outfd);
+
+	h = dlopen(rq->so, RTLD_NOW);
+	test_main = h ? (int (*)(int, char **, char **))dlsym(h, "main") : NULL;
+	if (test_main == NULL) {
+		/* Same outcome as t0 when the application could not be launched */
+		fprintf(stderr, "Unable to run child application: %s\n", dlerror());
+		_exit(PTS_UNRESOLVED);
+	}
+
+	argv[0] = (char *)rq->exe;
+	argv[1] = NULL;
+	exit(test_main(1, argv, environ));
+}
+
+static int recv_request(struct request *rq, int *outfd)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { rq, sizeof(*rq) };
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	ssize_t n;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	do
+		n = recvmsg(sock, &msg, 0);
+	while (n == -1 && errno == EINTR);
+	if (n != sizeof(*rq))
+		return -1;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS)
+		return -1;
+	memcpy(outfd, CMSG_DATA(cmsg), sizeof(int));
+	return 0;
+}
+
+static void serve(pid_t runner)
+{
+	struct request rq;
+	pid_t pid, test;
+	long fd, maxfd;
+	size_t i;
+	int outfd;
+
+	/* Nothing of pts-run but the socket: the logfile, the cache... */
+	maxfd = sysconf(_SC_OPEN_MAX);
+	if (maxfd < 0 || maxfd > 65536)
+		maxfd = 65536;
+	for (fd = 3; fd < maxfd; fd++)
+		if (fd != sock)
+			close(fd);
+
+	for (i = 0; i < sizeof(preload) / sizeof(preload[0]); i++)
+		dlopen(preload[i], RTLD_NOW | RTLD_GLOBAL);
+
+	while (recv_request(&rq, &outfd) == 0) {
+		pid = fork();
+		if (pid == 0) {
+			pid = getpid();
+			test = fork();
+			if (test == 0) {
+				close(sock);
+				run_test(&rq, outfd, pid, runner);
+			}
+			/* Before pts-run may kill the group */
+			if (test > 0)
+				setpgid(test, test);
+			if (write(sock, &test, sizeof(test)) != sizeof(test))
+				_exit(1);
+			/* The test starts when we exit */
+			if (rq.count && test > 0 &&
+			    read(sock, &test, sizeof(test)) != sizeof(test))
+				_exit(1);
+			_exit(0);
+		}
+		if (pid == -1) {
+			test = -1;
+			if (write(sock, &test, sizeof(test)) != sizeof(test))
+				_exit(1);
+		} else {
+			waitpid(pid, NULL, 0);
+		}
+		close(outfd);
+	}
+	_exit(0);
+}
+
+/* Returns -1 when there is no fork server: the tests are then executed */
+int zygote_start(void)
+{
+	int sv[2];
+
+	if (prctl(PR_SET_CHILD_SUBREAPER, 1) != 0)
+		return -1;
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) != 0)
+		return -1;
+
+	fflush(NULL);
+	server = fork();
+	if (server == 0) {
+		close(sv[0]);
+		sock = sv[1];
+		serve(getppid());
+	}
+	close(sv[1]);
+	if (server == -1) {
+		close(sv[0]);
+		return -1;
+	}
+	sock = sv[0];
+	return 0;
+}
+
+/*
+ * Start the test from the server; returns its pid, or -1 to execute it.
+ * With "count", the test has its counters attached before it starts.
+ */
+pid_t zygote_spawn(struct test *t, int outfd, int count)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))];
+	struct request rq;
+	struct iovec iov = { &rq, sizeof(rq) };
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	pid_t pid;
+
+	if (sock == -1 || strlen(t->so) >= ZYGOTE_PATH ||
+	    strlen(t->exe) >= ZYGOTE_PATH || strlen(t->tmpdir) >= ZYGOTE_PATH ||
+	    (t->cgroup != NULL && strlen(t->cgroup) >= ZYGOTE_PATH))
+		return -1;
+
+	memset(&rq, 0, sizeof(rq));
+	rq.count = count;
+	rq.slot = t->slot;
+	rq.cpu_first = t->cpu_first;
+	rq.cpu_count = t->cpu_count;
+	strcpy(rq.so, t->so);
+	strcpy(rq.exe, t->exe);
+	strcpy(rq.tmpdir, t->tmpdir);
+	if (t->cgroup != NULL)
+		strcpy(rq.cgroup, t->cgroup);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &outfd, sizeof(int));
+
+	if (sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(rq) ||
+	    read(sock, &pid, sizeof(pid)) != sizeof(pid) || pid <= 0) {
+		/* The server is gone, or out of processes */
+		zygote_stop();
+		return -1;
+	}
+	if (count) {
+		t->pid = pid;
+		perf_attach(t, 0);
+		if (write(sock, &pid, sizeof(pid)) != sizeof(pid)) {
+			kill(pid, SIGKILL);
+			perf_finish(t);
+			perf_reset(t);
+			zygote_stop();
+			return -1;
+		}
+	}
+	return pid;
+}
+
+void zygote_stop(void)
+{
+	if (sock == -1)
+		return;
+	close(sock);
+	sock = -1;
+	waitpid(server, NULL, 0);
+}
+
+#else /* !__linux__ */
+
+int zygote_start(void)
+{
+	return -1;
+}
+
+pid_t zygote_spawn(struct test *t, int outfd, int count)
+{
+	(void)t;
+	(void)outfd;
+	(void)count;
+	return -1;
+}
+
+void zygote_stop(void)
+{
+}
+
+#endif
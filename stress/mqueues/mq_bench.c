@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Benchmark of mq_send and mq_receive.  Where multi_send_rev_*.c check
+ * that a few messages get through, this program measures how fast they
+ * do.  Producers send as fast as they can, for -d ms, to consumers which
+ * receive from the same queue; each message carries the time it was sent.
+ * Every run reports the messages and the bytes received per second, and
+ * the latency from mq_send to the return of mq_receive (p50, p99, max),
+ * which includes the time the message spent in the queue.
+ *
+ * One setting is varied at a time, from: 256 byte messages, the default
+ * queue depth, one priority, one producer and one consumer thread, and
+ * blocking receives:
+ *
+ * -> size: 16 bytes to the largest message allowed (msgsize_max on Linux);
+ * -> depth: 1 message to the deepest queue allowed (msg_max on Linux);
+ * -> priorities: the messages of the producers cycle through n of them;
+ * -> pairs: 1, 2, 4 ... producers, as many consumers;
+ * -> receive: blocking mq_receive, mq_receive on an O_NONBLOCK queue
+ *    polled with sched_yield(), mq_timedreceive;
+ *
+ * the size, pairs and receive sweeps between threads and between
+ * processes.  A setting which the system refuses (e.g. a queue larger
+ * than RLIMIT_MSGQUEUE) is reported as skipped.
+ *
+ * Options:
+ *  -z n   largest message size (default: the largest allowed)
+ *  -q n   deepest queue (default: the deepest allowed)
+ *  -P n   most priorities (default 32)
+ *  -t n   most producer/consumer pairs (default: the CPUs)
+ *  -d ms  duration of each run (default 200)
+ *  -s str only run the settings whose description contains str
+ *
+ * The benchmark only reports numbers; it is UNRESOLVED when a queue
+ * cannot be used and PASSED otherwise.
+ */
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE		/* MAP_ANONYMOUS */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <time.h>
+#include <mqueue.h>
+
+#include "posixtest.h"
+#include "measure.h"
+
+#define BASE_SIZE	256
+#define MIN_SIZE	16
+
+enum recv_mode { RECV_BLOCK, RECV_POLL, RECV_TIMED };
+static const char *recv_names[] = { "block", "poll", "timed" };
+
+/* The setting of a run */
+struct setting {
+	const char *sweep;
+	int processes;
+	long size;
+	long depth;
+	long prios;
+	long pairs;
+	enum recv_mode recv;
+};
+
+/* The first bytes of each message */
+struct header {
+	struct timespec sent;	/* tv_nsec -1: no more messages */
+};
+
+/* Shared with the workers, which may be processes */
+struct shared {
+	volatile int stop;
+	unsigned long received[];	/* per consumer, then the histograms */
+};
+
+static struct {
+	long size, depth, prios, pairs, duration_ms;
+	const char *only;
+} opt = { 0, 0, 32, 0, 200, NULL };
+
+static struct shared *shm;
+static struct mes_hist *hists;	/* per consumer, in *shm */
+static mqd_t mq_send_d, mq_recv_d;
+static const struct setting *cur;
+
+static void fail(const char *what)
+{
+	perror(what);
+	exit(PTS_UNRESOLVED);
+}
+
+/* A limit of /proc/sys/fs/mqueue (Linux), or def */
+static long mq_limit(const char *name, long def)
+{
+	char path[128];
+	FILE *fp;
+	long v;
+
+	snprintf(path, sizeof(path), "/proc/sys/fs/mqueue/%s", name);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return def;
+	if (fscanf(fp, "%ld", &v) != 1)
+		v = def;
+	fclose(fp);
+	return v;
+}
+
+static void *producer(void *arg)
+{
+	long id = (long)arg;
+	struct header *h;
+	char *buf;
+	unsigned prio;
+	long i;
+
+	buf = calloc(1, cur->size);
+	if (buf == NULL)
+		fail("malloc");
+	h = (struct header *)buf;
+
+	for (i = id; !shm->stop; i++) {
+		prio = i % cur->prios;
+		mes_now(&h->sent);
+		if (mq_send(mq_send_d, buf, cur->size, prio) == -1) {
+			if (errno == EINTR)
+				continue;
+			fail("mq_send");
+		}
+	}
+	free(buf);
+	return NULL;
+}
+
+static void *consumer(void *arg)
+{
+	long id = (long)arg;
+	struct timespec now, deadline;
+	struct header h;
+	unsigned long n = 0;
+	char *buf;
+	ssize_t len;
+
+	buf = malloc(cur->size);
+	if (buf == NULL)
+		fail("malloc");
+
+	for (;;) {
+		if (cur->recv == RECV_TIMED) {
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec++;
+			len = mq_timedreceive(mq_recv_d, buf, cur->size, NULL,
+					      &deadline);
+		} else {
+			len = mq_receive(mq_recv_d, buf, cur->size, NULL);
+		}
+		if (len == -1) {
+			if (errno == EINTR || errno == ETIMEDOUT)
+				continue;
+			if (errno == EAGAIN) {
+				sched_yield();
+				continue;
+			}
+			fail("mq_receive");
+		}
+		mes_now(&now);
+		memcpy(&h, buf, sizeof(h));
+		if (h.sent.tv_nsec == -1)
+			break;
+		mes_hist_record(&hists[id], mes_elapsed_ns(&h.sent, &now));
+		n++;
+	}
+	shm->received[id] = n;
+	free(buf);
+	return NULL;
+}
+
+/* Start a worker as a thread (*th) or a process (returned) */
+static pid_t start(const struct setting *s, void *(*fn)(void *), long id,
+		   pthread_t *th)
+{
+	pid_t pid;
+	int ret;
+
+	if (!s->processes) {
+		ret = pthread_create(th, NULL, fn, (void *)id);
+		if (ret != 0) {
+			errno = ret;
+			fail("pthread_create");
+		}
+		return 0;
+	}
+	pid = fork();
+	if (pid == -1)
+		fail("fork");
+	if (pid == 0) {
+		fn((void *)id);
+		_exit(PTS_PASS);
+	}
+	return pid;
+}
+
+static void finish(const struct setting *s, pid_t pid, pthread_t th)
+{
+	int status;
+
+	if (!s->processes) {
+		pthread_join(th, NULL);
+		return;
+	}
+	if (waitpid(pid, &status, 0) != pid)
+		fail("waitpid");
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != PTS_PASS) {
+		fprintf(stderr, "A worker process failed\n");
+		exit(PTS_UNRESOLVED);
+	}
+}
+
+static void run(const struct setting *s)
+{
+	struct timespec ts_ref, ts_fin, ts_dur;
+	struct mq_attr attr;
+	struct mes_hist all;
+	struct header *h;
+	char name[64], descr[128], *buf;
+	pthread_t *th;
+	pid_t *pids;
+	unsigned long msgs = 0;
+	double secs;
+	long i;
+
+	snprintf(descr, sizeof(descr), "%s %s size %ld depth %ld prios %ld "
+		 "pairs %ld %s", s->sweep, s->processes ? "processes" : "threads",
+		 s->size, s->depth, s->prios, s->pairs, recv_names[s->recv]);
+	if (opt.only != NULL && strstr(descr, opt.only) == NULL)
+		return;
+
+	printf("%-10s %-9s %6ld %5ld %5ld %5ld %-5s ", s->sweep,
+	       s->processes ? "processes" : "threads", s->size, s->depth,
+	       s->prios, s->pairs, recv_names[s->recv]);
+	fflush(stdout);
+
+	snprintf(name, sizeof(name), "/pts_mq_bench_%d", (int)getpid());
+	memset(&attr, 0, sizeof(attr));
+	attr.mq_maxmsg = s->depth;
+	attr.mq_msgsize = s->size;
+	mq_send_d = mq_open(name, O_CREAT | O_EXCL | O_WRONLY, 0600, &attr);
+	if (mq_send_d == (mqd_t)-1) {
+		if (errno == EINVAL || errno == EMFILE || errno == ENOMEM ||
+		    errno == ENOSPC) {
+			printf("skipped: %s\n", strerror(errno));
+			return;
+		}
+		fail("mq_open");
+	}
+	mq_recv_d = mq_open(name, O_RDONLY |
+			    (s->recv == RECV_POLL ? O_NONBLOCK : 0));
+	if (mq_recv_d == (mqd_t)-1)
+		fail("mq_open");
+	mq_unlink(name);
+
+	th = calloc(2 * s->pairs, sizeof(*th));
+	pids = calloc(2 * s->pairs, sizeof(*pids));
+	buf = calloc(1, s->size);
+	if (th == NULL || pids == NULL || buf == NULL)
+		fail("malloc");
+	shm->stop = 0;
+	for (i = 0; i < s->pairs; i++) {
+		shm->received[i] = 0;
+		mes_hist_init(&hists[i]);
+	}
+	cur = s;
+	fflush(stdout);
+
+	mes_now(&ts_ref);
+	for (i = 0; i < s->pairs; i++) {
+		pids[i] = start(s, consumer, i, &th[i]);
+		pids[s->pairs + i] = start(s, producer, i, &th[s->pairs + i]);
+	}
+
+	ts_dur.tv_sec = opt.duration_ms / 1000;
+	ts_dur.tv_nsec = (opt.duration_ms % 1000) * 1000000;
+	nanosleep(&ts_dur, NULL);
+	shm->stop = 1;
+
+	/* The producers stop; then one last message per consumer, after
+	 * all the others as it has the lowest priority */
+	for (i = 0; i < s->pairs; i++)
+		finish(s, pids[s->pairs + i], th[s->pairs + i]);
+	h = (struct header *)buf;
+	h->sent.tv_sec = 0;
+	h->sent.tv_nsec = -1;
+	for (i = 0; i < s->pairs; i++)
+		while (mq_send(mq_send_d, buf, s->size, 0) == -1)
+			if (errno != EINTR)
+				fail("mq_send");
+	for (i = 0; i < s->pairs; i++)
+		finish(s, pids[i], th[i]);
+	mes_now(&ts_fin);
+
+	mes_hist_init(&all);
+	for (i = 0; i < s->pairs; i++) {
+		msgs += shm->received[i];
+		mes_hist_merge(&all, &hists[i]);
+	}
+	secs = mes_elapsed_us(&ts_ref, &ts_fin) / 1e6;
+	printf("%12.0f %10.2f %10.3f %10.3f %10.3f\n", msgs / secs,
+	       msgs * (double)s->size / secs / (1 << 20),
+	       mes_hist_percentile(&all, 50) / 1e3,
+	       mes_hist_percentile(&all, 99) / 1e3,
+	       mes_hist_percentile(&all, 100) / 1e3);
+
+	mq_close(mq_send_d);
+	mq_close(mq_recv_d);
+	free(th);
+	free(pids);
+	free(buf);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-z size] [-q depth] [-P priorities] "
+		"[-t pairs] [-d ms] [-s pattern]\n", name);
+	exit(PTS_UNRESOLVED);
+}
+
+int main(int argc, char *argv[])
+{
+	struct setting base, s;
+	struct mq_attr attr;
+	char name[64];
+	mqd_t mq;
+	long ncpus;
+	int c;
+
+	/* The defaults of the system for a queue */
+	snprintf(name, sizeof(name), "/pts_mq_bench_%d", (int)getpid());
+	mq = mq_open(name, O_CREAT | O_EXCL | O_RDWR, 0600, NULL);
+	if (mq == (mqd_t)-1)
+		fail("mq_open");
+	if (mq_getattr(mq, &attr) == -1)
+		fail("mq_getattr");
+	mq_close(mq);
+	mq_unlink(name);
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	opt.size = mq_limit("msgsize_max", attr.mq_msgsize);
+	opt.depth = mq_limit("msg_max", attr.mq_maxmsg);
+	opt.pairs = ncpus > 0 ? ncpus : 1;
+
+	while ((c = getopt(argc, argv, "z:q:P:t:d:s:")) != -1) {
+		switch (c) {
+		case 'z':
+			opt.size = atol(optarg);
+			break;
+		case 'q':
+			opt.depth = atol(optarg);
+			break;
+		case 'P':
+			opt.prios = atol(optarg);
+			break;
+		case 't':
+			opt.pairs = atol(optarg);
+			break;
+		case 'd':
+			opt.duration_ms = atol(optarg);
+			break;
+		case 's':
+			opt.only = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (opt.size < MIN_SIZE || opt.depth < 1 || opt.prios < 1 ||
+	    opt.prios > MQ_PRIO_MAX || opt.pairs < 1 || opt.duration_ms < 1)
+		usage(argv[0]);
+
+	shm = mmap(NULL, sizeof(*shm) + opt.pairs * (sizeof(shm->received[0]) +
+		   sizeof(struct mes_hist)), PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shm == MAP_FAILED)
+		fail("mmap");
+	hists = (struct mes_hist *)&shm->received[opt.pairs];
+
+	printf("mq benchmark: %ld CPUs, default queue %ld x %ld bytes, "
+	       "%ld ms per run\n", ncpus, (long)attr.mq_maxmsg,
+	       (long)attr.mq_msgsize, opt.duration_ms);
+	printf("%-10s %-9s %6s %5s %5s %5s %-5s %12s %10s %10s %10s %10s\n",
+	       "sweep", "peers", "size", "depth", "prios", "pairs", "recv",
+	       "msgs/s", "MiB/s", "p50 us", "p99 us", "max us");
+
+	base.sweep = "size";
+	base.processes = 0;
+	base.size = BASE_SIZE < opt.size ? BASE_SIZE : opt.size;
+	base.depth = attr.mq_maxmsg < opt.depth ? attr.mq_maxmsg : opt.depth;
+	base.prios = 1;
+	base.pairs = 1;
+	base.recv = RECV_BLOCK;
+
+	for (base.processes = 0; base.processes < 2; base.processes++) {
+		s = base;
+		for (s.size = MIN_SIZE; ; s.size *= 4) {
+			if (s.size > opt.size)
+				s.size = opt.size;
+			run(&s);
+			if (s.size == opt.size)
+				break;
+		}
+	}
+	base.processes = 0;
+
+	s = base;
+	s.sweep = "depth";
+	for (s.depth = 1; ; s.depth *= 4) {
+		if (s.depth > opt.depth)
+			s.depth = opt.depth;
+		run(&s);
+		if (s.depth == opt.depth)
+			break;
+	}
+
+	s = base;
+	s.sweep = "priorities";
+	for (s.prios = 1; ; s.prios *= 4) {
+		if (s.prios > opt.prios)
+			s.prios = opt.prios;
+		run(&s);
+		if (s.prios == opt.prios)
+			break;
+	}
+
+	for (base.processes = 0; base.processes < 2; base.processes++) {
+		s = base;
+		s.sweep = "pairs";
+		for (s.pairs = 1; ; s.pairs *= 2) {
+			if (s.pairs > opt.pairs)
+				s.pairs = opt.pairs;
+			run(&s);
+			if (s.pairs == opt.pairs)
+				break;
+		}
+	}
+
+	for (base.processes = 0; base.processes < 2; base.processes++) {
+		s = base;
+		s.sweep = "receive";
+		for (s.recv = RECV_BLOCK; s.recv <= RECV_TIMED; s.recv++)
+			run(&s);
+	}
+
+	return PTS_PASS;
+}
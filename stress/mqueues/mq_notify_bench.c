@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * Benchmark of mq_notify.  Where conformance/interfaces/mq_notify checks
+ * that a notification comes, this program measures how long it takes,
+ * and what an event-driven consumer built on it costs, compared with a
+ * thread blocked in mq_receive.  The consumer (the main thread) is told
+ * of the messages which a sender thread puts on an empty queue by:
+ *
+ * -> handler: SIGEV_SIGNAL, caught by a handler while in sigsuspend;
+ * -> sigwaitinfo: SIGEV_SIGNAL, taken with sigwaitinfo;
+ * -> thread: SIGEV_THREAD, whose function wakes the consumer up;
+ * -> receive: no notification, the consumer blocks in mq_receive.
+ *
+ * The steps are, for each of them:
+ * -> latency: the sender puts one message on the empty queue once the
+ *    consumer waits.  The time from the mq_send call to the notification
+ *    running (the handler, the return of sigwaitinfo, the SIGEV_THREAD
+ *    function, the return of mq_receive) is reported as p50, p99 and max.
+ * -> sustained: the sender sends as fast as it can for -d ms.  The
+ *    consumer waits for a notification, re-arms it, then receives until
+ *    the queue is empty, and again.  The messages per second are
+ *    reported, the messages received per wakeup, and the time of the
+ *    mq_notify calls which re-arm the notification (p50 and p99).
+ *
+ * Options:
+ *  -n n   number of latency samples (default 2000)
+ *  -d ms  duration of the sustained traffic (default 500)
+ *  -s str only run the ways whose name contains str
+ *
+ * The benchmark only reports numbers; it is UNRESOLVED when a queue or a
+ * notification cannot be set up and PASSED otherwise.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <mqueue.h>
+
+#include "posixtest.h"
+#include "measure.h"
+
+#define MSG_SIZE	64
+
+enum way { WAY_HANDLER, WAY_SIGWAIT, WAY_THREAD, WAY_RECEIVE, NWAYS };
+static const char *way_names[] = { "handler", "sigwaitinfo", "thread",
+				   "receive" };
+
+struct message {
+	struct timespec sent;
+	int end;		/* the last message of the sustained traffic */
+};
+
+static struct {
+	long samples, duration_ms;
+	const char *only;
+} opt = { 2000, 500, NULL };
+
+static mqd_t mq_send_d, mq_recv_d;
+static int sig;
+static sigset_t sig_set;	/* sig */
+
+/* Set by the notifications */
+static volatile sig_atomic_t notified;
+static struct timespec ts_notified;
+static sem_t thread_sem;
+
+/* Between the consumer and the sender */
+static sem_t go;
+static struct timespec ts_send;
+static int sustained;
+
+static void fail(const char *what)
+{
+	perror(what);
+	exit(PTS_UNRESOLVED);
+}
+
+static void handler(int signo)
+{
+	mes_now(&ts_notified);
+	notified = 1;
+}
+
+static void notify_function(union sigval sv)
+{
+	mes_now(&ts_notified);
+	sem_post(&thread_sem);
+}
+
+/* Register the notification of the next message on the empty queue */
+static void arm(enum way w)
+{
+	struct sigevent sev;
+
+	memset(&sev, 0, sizeof(sev));
+	if (w == WAY_THREAD) {
+		sev.sigev_notify = SIGEV_THREAD;
+		sev.sigev_notify_function = notify_function;
+	} else {
+		sev.sigev_notify = SIGEV_SIGNAL;
+		sev.sigev_signo = sig;
+	}
+	if (mq_notify(mq_recv_d, &sev) == -1)
+		fail("mq_notify");
+}
+
+static void wait_notification(enum way w)
+{
+	sigset_t unblocked;
+
+	switch (w) {
+	case WAY_HANDLER:
+		pthread_sigmask(SIG_SETMASK, NULL, &unblocked);
+		sigdelset(&unblocked, sig);
+		while (!notified)
+			sigsuspend(&unblocked);
+		notified = 0;
+		break;
+	case WAY_SIGWAIT:
+		while (sigwaitinfo(&sig_set, NULL) == -1)
+			if (errno != EINTR)
+				fail("sigwaitinfo");
+		mes_now(&ts_notified);
+		break;
+	case WAY_THREAD:
+		while (sem_wait(&thread_sem) == -1)
+			if (errno != EINTR)
+				fail("sem_wait");
+		break;
+	default:
+		break;
+	}
+}
+
+static void *sender(void *arg)
+{
+	struct timespec ts_wait = { 0, 50000 }; /* let the consumer block */
+	struct timespec ts_ref, now;
+	struct message m;
+	long i;
+
+	memset(&m, 0, sizeof(m));
+	if (!sustained) {
+		for (i = 0; i < opt.samples; i++) {
+			while (sem_wait(&go) == -1)
+				if (errno != EINTR)
+					fail("sem_wait");
+			nanosleep(&ts_wait, NULL);
+			mes_now(&ts_send);
+			if (mq_send(mq_send_d, (char *)&m, sizeof(m), 0) == -1)
+				fail("mq_send");
+		}
+		return NULL;
+	}
+
+	mes_now(&ts_ref);
+	do {
+		mes_now(&m.sent);
+		if (mq_send(mq_send_d, (char *)&m, sizeof(m), 0) == -1 &&
+		    errno != EINTR)
+			fail("mq_send");
+		mes_now(&now);
+	} while (mes_elapsed_us(&ts_ref, &now) < opt.duration_ms * 1000.0);
+	m.end = 1;
+	while (mq_send(mq_send_d, (char *)&m, sizeof(m), 0) == -1)
+		if (errno != EINTR)
+			fail("mq_send");
+	return NULL;
+}
+
+/* Receive a message; returns 0 when the queue is empty, -1 at the end */
+static int receive(void)
+{
+	char buf[MSG_SIZE];
+	struct message m;
+
+	while (mq_receive(mq_recv_d, buf, sizeof(buf), NULL) == -1) {
+		if (errno == EAGAIN)
+			return 0;
+		if (errno != EINTR)
+			fail("mq_receive");
+	}
+	memcpy(&m, buf, sizeof(m));
+	return m.end ? -1 : 1;
+}
+
+static void open_queue(const char *name, enum way w)
+{
+	struct mq_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.mq_maxmsg = 8;
+	attr.mq_msgsize = MSG_SIZE;
+	mq_send_d = mq_open(name, O_CREAT | O_EXCL | O_WRONLY, 0600, &attr);
+	if (mq_send_d == (mqd_t)-1)
+		fail("mq_open");
+	mq_recv_d = mq_open(name, O_RDONLY |
+			    (w == WAY_RECEIVE ? 0 : O_NONBLOCK));
+	if (mq_recv_d == (mqd_t)-1)
+		fail("mq_open");
+	mq_unlink(name);
+}
+
+static void measure_latency(enum way w)
+{
+	struct mes_hist lat, rearm;
+	struct timespec t0, t1;
+	char name[64];
+	pthread_t th;
+	long i;
+	int ret;
+
+	snprintf(name, sizeof(name), "/pts_mq_notify_bench_%d", (int)getpid());
+	open_queue(name, w);
+	mes_hist_init(&lat);
+	mes_hist_init(&rearm);
+	sustained = 0;
+
+	ret = pthread_create(&th, NULL, sender, NULL);
+	if (ret != 0) {
+		errno = ret;
+		fail("pthread_create");
+	}
+
+	for (i = 0; i < opt.samples; i++) {
+		if (w != WAY_RECEIVE) {
+			mes_now(&t0);
+			arm(w);
+			mes_now(&t1);
+			mes_hist_record(&rearm, mes_elapsed_ns(&t0, &t1));
+		}
+		sem_post(&go);
+		if (w == WAY_RECEIVE) {
+			receive();
+			mes_now(&ts_notified);
+		} else {
+			wait_notification(w);
+			while (receive() == 0)
+				;	/* the SIGEV_THREAD function may run first */
+		}
+		/* ts_send was written before the message was sent */
+		mes_hist_record(&lat, mes_elapsed_ns(&ts_send, &ts_notified));
+	}
+
+	pthread_join(th, NULL);
+	mq_close(mq_send_d);
+	mq_close(mq_recv_d);
+
+	printf("%-12s latency p50 %.3f us, p99 %.3f us, max %.3f us",
+	       way_names[w], mes_hist_percentile(&lat, 50) / 1e3,
+	       mes_hist_percentile(&lat, 99) / 1e3,
+	       mes_hist_percentile(&lat, 100) / 1e3);
+	if (w != WAY_RECEIVE)
+		printf("; mq_notify p50 %.3f us, p99 %.3f us",
+		       mes_hist_percentile(&rearm, 50) / 1e3,
+		       mes_hist_percentile(&rearm, 99) / 1e3);
+	printf("\n");
+}
+
+static void measure_sustained(enum way w)
+{
+	struct timespec ts_ref, ts_fin, t0, t1;
+	struct mes_hist rearm;
+	unsigned long msgs = 0, wakeups = 0;
+	char name[64];
+	pthread_t th;
+	int ret;
+
+	snprintf(name, sizeof(name), "/pts_mq_notify_bench_%d", (int)getpid());
+	open_queue(name, w);
+	mes_hist_init(&rearm);
+	sustained = 1;
+
+	if (w != WAY_RECEIVE)
+		arm(w);
+	mes_now(&ts_ref);
+	ret = pthread_create(&th, NULL, sender, NULL);
+	if (ret != 0) {
+		errno = ret;
+		fail("pthread_create");
+	}
+
+	if (w == WAY_RECEIVE) {
+		while ((ret = receive()) > 0) {
+			msgs++;
+			wakeups++;
+		}
+	} else {
+		for (ret = 0; ret >= 0; ) {
+			wait_notification(w);
+			wakeups++;
+			mes_now(&t0);
+			arm(w);
+			mes_now(&t1);
+			mes_hist_record(&rearm, mes_elapsed_ns(&t0, &t1));
+			while ((ret = receive()) > 0)
+				msgs++;
+		}
+	}
+	mes_now(&ts_fin);
+
+	pthread_join(th, NULL);
+	mq_close(mq_send_d);
+	mq_close(mq_recv_d);
+
+	/* A notification armed last may still come */
+	if (w == WAY_THREAD)
+		while (sem_trywait(&thread_sem) == 0)
+			;
+	if (w == WAY_SIGWAIT || w == WAY_HANDLER) {
+		struct timespec none = { 0, 0 };
+
+		while (sigtimedwait(&sig_set, NULL, &none) != -1)
+			;
+		notified = 0;
+	}
+
+	printf("%-12s sustained %.0f msgs/s, %.2f msgs per wakeup",
+	       way_names[w], msgs / (mes_elapsed_us(&ts_ref, &ts_fin) / 1e6),
+	       wakeups ? (double)msgs / wakeups : 0);
+	if (w != WAY_RECEIVE)
+		printf("; re-arm p50 %.3f us, p99 %.3f us",
+		       mes_hist_percentile(&rearm, 50) / 1e3,
+		       mes_hist_percentile(&rearm, 99) / 1e3);
+	printf("\n");
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n samples] [-d ms] [-s pattern]\n", name);
+	exit(PTS_UNRESOLVED);
+}
+
+int main(int argc, char *argv[])
+{
+	struct sigaction sa;
+	enum way w;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:d:s:")) != -1) {
+		switch (c) {
+		case 'n':
+			opt.samples = atol(optarg);
+			break;
+		case 'd':
+			opt.duration_ms = atol(optarg);
+			break;
+		case 's':
+			opt.only = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (opt.samples < 1 || opt.duration_ms < 1)
+		usage(argv[0]);
+
+	/* The signal is blocked everywhere but in sigsuspend */
+	sig = SIGRTMIN;
+	sigemptyset(&sig_set);
+	sigaddset(&sig_set, sig);
+	if (pthread_sigmask(SIG_BLOCK, &sig_set, NULL) != 0)
+		fail("pthread_sigmask");
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = handler;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(sig, &sa, NULL) == -1)
+		fail("sigaction");
+	if (sem_init(&go, 0, 0) == -1 || sem_init(&thread_sem, 0, 0) == -1)
+		fail("sem_init");
+
+	printf("mq_notify benchmark: %ld latency samples, %ld ms of sustained "
+	       "traffic\n", opt.samples, opt.duration_ms);
+	for (w = 0; w < NWAYS; w++) {
+		if (opt.only != NULL && strstr(way_names[w], opt.only) == NULL)
+			continue;
+		measure_latency(w);
+		measure_sustained(w);
+	}
+
+	return PTS_PASS;
+}
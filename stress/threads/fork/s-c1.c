@@ -51,13 +51,13 @@
 #include <semaphore.h>
 #include <fcntl.h> 
 //#include <assert.h>
-#include <math.h>
+
+#include "measure.h"
 
 /********************************************************************************************/
 /******************************   Test framework   *****************************************/
 /********************************************************************************************/
 #include "testfrmw.h"
- #include "testfrmw.c" 
 /* This header is responsible for defining the following macros:
  * UNRESOLVED(ret, descr);  
  *    where descr is a description of the error and ret is an int (error code for example)
@@ -69,7 +69,7 @@
  * Both three macros shall terminate the calling process.
  * The testcase shall not terminate in any other maneer.
  * 
- * The other file defines the functions
+ * It also declares the functions, which lib/testfrmw.c defines:
  * void output_init()
  * void output(char * string, ...)
  * 
@@ -86,33 +86,25 @@
 #define VERBOSE 1
 #endif
 
-#define RESOLUTION (5 * SCALABILITY_FACTOR)
-
 #ifdef PLOT_OUTPUT
-#undef VERBOSE
-#define VERBOSE 0
+#define PLOT 1
+#else
+#define PLOT 0
 #endif
 
+/* The above are only the defaults, see mes_getopt() in measure.h */
+
+#define RESOLUTION ( mes_opt.resolution ? mes_opt.resolution : 5 * mes_opt.scale )
+
 /********************************************************************************************/
 /***********************************       Test     *****************************************/
 /********************************************************************************************/
 
-/* The next structure is used to save the tests measures */
-
-typedef struct __mes_t
-{
-	int nprocess;
-	long _data; /* As we store µsec values, a long type should be enough. */
-
-	struct __mes_t *next;
-}
-
-mes_t;
-
-/* Forward declaration */
-int parse_measure( mes_t * measures );
+/* The measures are saved in a mes_set (see measure.h): one series, the fork duration */
 
+static const char * const series[] = { "fork" };
 
+#define ANALYSIS_OUTPUT ( mes_opt.verbose > 1 ? output : NULL )
 
 sem_t *sem_synchro;
 sem_t *sem_ending;
@@ -127,22 +119,50 @@ int main ( int argc, char *argv[] )
 
 	struct timespec ts_ref, ts_fin;
 
-	mes_t sentinel;
-	mes_t *m_cur, *m_tmp;
+	struct mes_set measures;
+	struct mes_levels tails;
+	struct mes_perf perf;
+	uint64_t counts[ MES_NCOUNTERS ];
 
 	long CHILD_MAX = sysconf( _SC_CHILD_MAX );
-	long my_max = 1000 * SCALABILITY_FACTOR ;
-
-	/* Initialize the measure list */
-	m_cur = &sentinel;
-	m_cur->next = NULL;
+	long my_max;
 
 	/* Initialize output routine */
 	output_init();
 
+	/* Read the load and the verbosity */
+	if ( mes_getopt( argc, argv, SCALABILITY_FACTOR, VERBOSE, PLOT ) != 0 )
+	{
+		UNRESOLVED( EINVAL, "Bad options" );
+	}
+
+	my_max = 1000 * mes_opt.scale;
+
 	if ( CHILD_MAX > 0 )
 		my_max = CHILD_MAX;
 
+	if ( mes_opt.max > 0 )
+		my_max = mes_opt.max;
+
+	/* Initialize the measure storage: every sample is allocated now */
+	ret = mes_init( &measures, 1, my_max / RESOLUTION + 1 );
+
+	if ( ret != 0 )
+	{
+		UNRESOLVED( ret, "Not enough memory for measure storage" );
+	}
+
+	/* Every fork goes in the latency histogram of its tenth of my_max */
+	ret = mes_levels_init( &tails, ( my_max + 9 ) / 10, 10 );
+
+	if ( ret != 0 )
+	{
+		UNRESOLVED( ret, "Not enough memory for latency histograms" );
+	}
+
+	/* With PTS_PERF set, what each fork costs besides time (see measure.h) */
+	mes_perf_open( &perf );
+
 	pr = ( pid_t * ) calloc( 1 + my_max, sizeof( pid_t ) );
 
 	if ( pr == NULL )
@@ -150,15 +170,11 @@ int main ( int argc, char *argv[] )
 		UNRESOLVED( errno, "Not enough memory for process IDs storage" );
 	}
 
-#if VERBOSE > 1
-	output( "CHILD_MAX: %d\n", CHILD_MAX );
+	if ( mes_opt.verbose > 1 )
+		output( "CHILD_MAX: %d\n", CHILD_MAX );
 
-#endif
-
-#ifdef PLOT_OUTPUT
-	output( "# COLUMNS 2 #Process Duration\n" );
-
-#endif
+	if ( mes_opt.plot )
+		output( "# COLUMNS 2 #Process Duration\n" );
 
 	/* Initilaize the semaphores */
 	sem_synchro = sem_open( "/fork_scal_sync", O_CREAT, O_RDWR, 0 );
@@ -180,17 +196,13 @@ int main ( int argc, char *argv[] )
 	sem_unlink( "/fork_scal_end" );
 
 	nprocesses = 0;
-	m_cur = &sentinel;
 
 	while ( 1 )                                      /* we will break */
 	{
-		/* read clock */
-		ret = clock_gettime( CLOCK_REALTIME, &ts_ref );
+		/* read counters, then clock */
+		mes_perf_begin( &perf );
 
-		if ( ret != 0 )
-		{
-			UNRESOLVED( errno, "Unable to read clock" );
-		}
+		mes_now( &ts_ref );
 
 		/* create a new child */
 		pr[ nprocesses ] = fork();
@@ -260,8 +272,8 @@ int main ( int argc, char *argv[] )
 				UNRESOLVED( errno, "Failed post the end semaphore" );
 			}
 
-			/* Exit */
-			exit( PTS_PASS );
+			/* Exit, without flushing the output inherited from the parent */
+			_exit( PTS_PASS );
 		}
 
 		/* Parent */
@@ -272,11 +284,10 @@ int main ( int argc, char *argv[] )
 		{
 			errno = 0;
 
-			if ( CHILD_MAX > 0 )
+			if ( ( CHILD_MAX > 0 ) && ( nprocesses > CHILD_MAX ) )
 			{
-#if VERBOSE > 0
-				output( "WARNING! We were able to create more than CHILD_MAX processes\n" );
-#endif
+				if ( mes_opt.verbose > 0 )
+					output( "WARNING! We were able to create more than CHILD_MAX processes\n" );
 
 			}
 
@@ -297,49 +308,34 @@ int main ( int argc, char *argv[] )
 		}
 
 		/* read clock */
-		ret = clock_gettime( CLOCK_REALTIME, &ts_fin );
+		mes_now( &ts_fin );
 
-		if ( ret != 0 )
-		{
-			UNRESOLVED( errno, "Unable to read clock" );
-		}
+		mes_perf_end( &perf, counts );
 
-		/* add to the measure list if nprocesses % resolution == 0 */
-		if ( ( ( nprocesses % RESOLUTION ) == 0 ) && ( nprocesses != 0 ) )
-		{
-			/* Create an empty new element */
-			m_tmp = ( mes_t * ) malloc( sizeof( mes_t ) );
+		mes_levels_record( &tails, nprocesses, mes_elapsed_ns( &ts_ref, &ts_fin ) );
 
-			if ( m_tmp == NULL )
-			{
-				sem_post( sem_ending );
-				UNRESOLVED( errno, "Unable to alloc memory for measure saving" );
-			}
+		mes_levels_count( &tails, nprocesses, counts );
 
-			m_tmp->nprocess = nprocesses;
-			m_tmp->next = NULL;
-			m_tmp->_data = 0;
-			m_cur->next = m_tmp;
-
-			m_cur = m_cur->next;
-
-			m_cur->_data = ( ( ts_fin.tv_sec - ts_ref.tv_sec ) * 1000000 ) + ( ( ts_fin.tv_nsec - ts_ref.tv_nsec ) / 1000 ) ;
+		/* add to the measures if nprocesses % resolution == 0 */
+		if ( ( ( nprocesses % RESOLUTION ) == 0 ) && ( nprocesses != 0 ) )
+		{
+			mes_record( &measures, nprocesses, 0, mes_elapsed_us( &ts_ref, &ts_fin ) );
 
-#if VERBOSE > 5
-			output( "Added the following measure: n=%i, v=%li\n", nprocesses, m_cur->_data );
-#endif
+			if ( mes_opt.verbose > 5 )
+				output( "Added the following measure: n=%i, v=%.3f\n", nprocesses, mes_elapsed_us( &ts_ref, &ts_fin ) );
 
 		}
 
 	}
-#if VERBOSE > 3
-
-	if ( errno )
-		output( "Could not create anymore processes. Current count is %i\n", nprocesses );
-	else
-		output( "Should not create anymore processes. Current count is %i\n", nprocesses );
+	if ( mes_opt.verbose > 3 )
+	{
+		if ( errno )
+			output( "Could not create anymore processes. Current count is %i\n", nprocesses );
+		else
+			output( "Should not create anymore processes. Current count is %i\n", nprocesses );
+	}
 
-#endif
+	mes_perf_close( &perf );
 
 	/* Unblock every created children: post once, then cascade signaling */
 
@@ -354,10 +350,8 @@ int main ( int argc, char *argv[] )
 		UNRESOLVED( errno, "Failed post the end semaphore" );
 	}
 
-#if VERBOSE > 3
-	output( "Waiting children termination\n" );
-
-#endif
+	if ( mes_opt.verbose > 3 )
+		output( "Waiting children termination\n" );
 
 	for ( i = 0; i < nprocesses; i++ )
 	{
@@ -379,327 +373,49 @@ int main ( int argc, char *argv[] )
 	free( pr );
 
 	/* Compute the results */
-	ret = parse_measure( &sentinel );
-
-
-	/* Free the resources and output the results */
-
-#if VERBOSE > 5
-	output( "Dump : \n" );
-
-	output( "  nproc  |  dur  \n" );
-
-#endif
-	while ( sentinel.next != NULL )
-	{
-		m_cur = sentinel.next;
-#if (VERBOSE > 5) || defined(PLOT_OUTPUT)
-		output( "%8.8i %1.1li.%6.6li\n", m_cur->nprocess, m_cur->_data / 1000000, m_cur->_data % 1000000 );
-
-#endif
-		sentinel.next = m_cur->next;
-
-		free( m_cur );
-	}
-
-
-	if ( ret != 0 )
-	{
-		FAILED( "The function is not scalable, add verbosity for more information" );
-	}
-
-
-#if VERBOSE > 0
-	output( "-----\n" );
-
-	output( "All test data destroyed\n" );
-
-	output( "Test PASSED\n" );
-
-#endif
-
-	PASSED;
-}
-
-
+	if ( mes_opt.verbose > 1 )
+		output( "Data analysis starting\n" );
 
+	ret = mes_analyze( &measures, series, ANALYSIS_OUTPUT );
 
 
-/***
- * The next function will seek for the better model for each series of measurements.
- *
- * The tested models are: -- X = # threads; Y = latency
- * -> Y = a;      -- Error is r1 = avg( (Y - Yavg)² );
- * -> Y = aX + b; -- Error is r2 = avg( (Y -aX -b)² );
- *                -- where a = avg ( (X - Xavg)(Y - Yavg) ) / avg( ( X - Xavg)² )
- *                --         Note: We will call _q = sum( (X - Xavg) * (Y - Yavg) ); 
- *                --                       and  _d = sum( (X - Xavg)² );
- *                -- and   b = Yavg - a * Xavg
- * -> Y = c * X^a;-- Same as previous, but with log(Y) = a log(X) + b; and b = log(c). Error is r3
- * -> Y = exp(aX + b); -- log(Y) = aX + b. Error is r4
- *
- * We compute each error factor (r1, r2, r3, r4) then search which is the smallest (with ponderation).
- * The function returns 0 when r1 is the best for all cases (latency is constant) and !0 otherwise.
- */
-
-struct row
-{
-	long X;  /* the X values -- copied from function argument */
-	long Y;  /* the Y values -- copied from function argument */
-	long _x; /* Value X - Xavg */
-	long _y; /* Value Y - Yavg */
-	double LnX; /* Natural logarithm of X values */
-	double LnY; /* Natural logarithm of Y values */
-	double _lnx; /* Value LnX - LnXavg */
-	double _lny; /* Value LnY - LnYavg */
-};
-
-int parse_measure( mes_t * measures )
-{
-	int ret, r;
-
-	mes_t *cur;
-
-	double Xavg, Yavg;
-	double LnXavg, LnYavg;
-
-	int N;
-
-	double r1, r2, r3, r4;
-
-	/* Some more intermediate vars */
-	long double _q[ 3 ];
-	long double _d[ 3 ];
-
-	long double t; /* temp value */
-
-	struct row *Table = NULL;
-
-	/* This array contains the last element of each serie */
-	int array_max;
-
-	/* Initialize the datas */
-
-	array_max = -1; /* means no data */
-	Xavg = 0.0;
-	LnXavg = 0.0;
-	Yavg = 0.0;
-	LnYavg = 0.0;
-	r1 = 0.0;
-	r2 = 0.0;
-	r3 = 0.0;
-	r4 = 0.0;
-	_q[ 0 ] = 0.0;
-	_q[ 1 ] = 0.0;
-	_q[ 2 ] = 0.0;
-	_d[ 0 ] = 0.0;
-	_d[ 1 ] = 0.0;
-	_d[ 2 ] = 0.0;
-
-	N = 0;
-	cur = measures;
-
-#if VERBOSE > 1
-	output( "Data analysis starting\n" );
-#endif
-
-	/* We start with reading the list to find:
-	 * -> number of elements, to assign an array.
-	 * -> average values 
-	 */
-
-	while ( cur->next != NULL )
-	{
-		cur = cur->next;
-
-		N++;
-
-		if ( cur->_data != 0 )
-		{
-			array_max = N;
-			Xavg += ( double ) cur->nprocess;
-			LnXavg += log( ( double ) cur->nprocess );
-			Yavg += ( double ) cur->_data;
-			LnYavg += log( ( double ) cur->_data );
-		}
-	}
+	/* Free the resources and output the results */
 
-	/* We have the sum; we can divide to obtain the average values */
-	if ( array_max != -1 )
+	if ( mes_opt.verbose > 5 )
 	{
-		Xavg /= array_max;
-		LnXavg /= array_max;
-		Yavg /= array_max;
-		LnYavg /= array_max;
-	}
-
-#if VERBOSE > 1
-	output( " Found %d rows\n", N );
-
-#endif
-
-
-	/* We will now alloc the array ... */
+		output( "Dump : \n" );
 
-	Table = calloc( N, sizeof( struct row ) );
-
-	if ( Table == NULL )
-	{
-		UNRESOLVED( errno, "Unable to alloc space for results parsing" );
+		output( "  nproc  |  dur  \n" );
 	}
-
-	/* ... and fill it */
-	N = 0;
-
-	cur = measures;
-
-	while ( cur->next != NULL )
+	if ( mes_opt.verbose > 5 || mes_opt.plot )
 	{
-		cur = cur->next;
-
-		Table[ N ].X = ( long ) cur->nprocess;
-		Table[ N ].LnX = log( ( double ) cur->nprocess );
-
-		if ( array_max > N )
+		for ( i = 0; i < ( int ) measures.n; i++ )
 		{
-			Table[ N ]._x = Table[ N ].X - Xavg ;
-			Table[ N ]._lnx = Table[ N ].LnX - LnXavg;
-			Table[ N ].Y = cur->_data;
-			Table[ N ]._y = Table[ N ].Y - Yavg ;
-			Table[ N ].LnY = log( ( double ) cur->_data );
-			Table[ N ]._lny = Table[ N ].LnY - LnYavg;
+			output( "%8.8li %.6f\n", measures.x[ i ], MES_Y( &measures, i, 0 ) / 1000000 );
 		}
-
-		N++;
 	}
+	mes_fini( &measures );
 
-	/* We won't need the list anymore -- we'll work with the array which should be faster. */
-#if VERBOSE > 1
-	output( " Data was stored in an array.\n" );
-
-#endif
+	if ( mes_opt.verbose > 0 )
+		mes_levels_print( &tails, "fork", output );
+	mes_levels_fini( &tails );
 
-	/* We need to read the full array at least twice to compute all the error factors */
 
-	/* In the first pass, we'll compute:
-	 * -> r1 for each scenar.
-	 * -> "a" factor for linear (0), power (1) and exponential (2) approximations -- with using the _d and _q vars.
-	 */
-#if VERBOSE > 1
-	output( "Starting first pass...\n" );
-
-#endif
-	for ( r = 0; r < array_max; r++ )
+	if ( ret != 0 )
 	{
-		r1 += ( ( double ) Table[ r ]._y / array_max ) * ( double ) Table[ r ]._y;
-
-		_q[ 0 ] += Table[ r ]._y * Table[ r ]._x;
-		_d[ 0 ] += Table[ r ]._x * Table[ r ]._x;
-
-		_q[ 1 ] += Table[ r ]._lny * Table[ r ]._lnx;
-		_d[ 1 ] += Table[ r ]._lnx * Table[ r ]._lnx;
-
-		_q[ 2 ] += Table[ r ]._lny * Table[ r ]._x;
-		_d[ 2 ] += Table[ r ]._x * Table[ r ]._x;
+		FAILED( "The function is not scalable, add verbosity for more information" );
 	}
 
-	/* First pass is terminated; a2 = _q[0]/_d[0]; a3 = _q[1]/_d[1]; a4 = _q[2]/_d[2] */
-
-	/* In the first pass, we'll compute:
-	 * -> r2, r3, r4 for each scenar.
-	 */
-
-#if VERBOSE > 1
-	output( "Starting second pass...\n" );
 
-#endif
-	for ( r = 0; r < array_max; r++ )
+	if ( mes_opt.verbose > 0 )
 	{
-		/* r2 = avg((y - ax -b)²);  t = (y - ax - b) = (y - yavg) - a (x - xavg); */
-		t = ( Table[ r ]._y - ( ( _q[ 0 ] * Table[ r ]._x ) / _d[ 0 ] ) );
-		r2 += t * t / array_max ;
-
-		/* r3 = avg(( y - c.x^a) ²);
-		    t = y - c * x ^ a 
-		      = y - log (LnYavg - (_q[1]/_d[1]) * LnXavg) * x ^ (_q[1]/_d[1])
-		*/
-		t = ( Table[ r ].Y
-		      - ( logl ( LnYavg - ( _q[ 1 ] / _d[ 1 ] ) * LnXavg )
-		          * powl( Table[ r ].X, ( _q[ 1 ] / _d[ 1 ] ) )
-		        ) );
-		r3 += t * t / array_max ;
-
-		/* r4 = avg(( y - exp(ax+b))²);
-		    t = y - exp(ax+b)
-		      = y - exp( _q[2]/_d[2] * x + ( LnYavg - (_q[2]/_d[2] * Xavg) ));
-		      = y - exp( _q[2]/_d[2] * (x - Xavg) + LnYavg );
-		*/
-		t = ( Table[ r ].Y
-		      - expl( ( _q[ 2 ] / _d[ 2 ] ) * Table[ r ]._x + LnYavg ) );
-		r4 += t * t / array_max ;
-
-	}
-
-#if VERBOSE > 1
-	output( "All computing terminated.\n" );
-
-#endif
-	ret = 0;
-
-#if VERBOSE > 1
-	output( " # of data: %i\n", array_max );
-
-	output( "  Model: Y = k\n" );
-
-	output( "       k = %g\n", Yavg );
-
-	output( "    Divergence %g\n", r1 );
-
-	output( "  Model: Y = a * X + b\n" );
-
-	output( "       a = %Lg\n", _q[ 0 ] / _d[ 0 ] );
+		output( "-----\n" );
 
-	output( "       b = %Lg\n", Yavg - ( ( _q[ 0 ] / _d[ 0 ] ) * Xavg ) );
-
-	output( "    Divergence %g\n", r2 );
-
-	output( "  Model: Y = c * X ^ a\n" );
-
-	output( "       a = %Lg\n", _q[ 1 ] / _d[ 1 ] );
-
-	output( "       c = %Lg\n", logl ( LnYavg - ( _q[ 1 ] / _d[ 1 ] ) * LnXavg ) );
-
-	output( "    Divergence %g\n", r2 );
-
-	output( "  Model: Y = exp(a * X + b)\n" );
-
-	output( "       a = %Lg\n", _q[ 2 ] / _d[ 2 ] );
-
-	output( "       b = %Lg\n", LnYavg - ( ( _q[ 2 ] / _d[ 2 ] ) * Xavg ) );
-
-	output( "    Divergence %g\n", r2 );
-
-#endif
-
-	if ( array_max != -1 )
-	{
-		/* Compare r1 to other values, with some ponderations */
-
-		if ( ( r1 > 1.1 * r2 ) || ( r1 > 1.2 * r3 ) || ( r1 > 1.3 * r4 ) )
-			ret++;
-
-#if VERBOSE > 1
-		else
-			output( " Sanction: OK\n" );
-
-#endif
+		output( "All test data destroyed\n" );
 
+		output( "Test PASSED\n" );
 	}
 
-	/* We need to free the array */
-	free( Table );
-
-	/* We're done */
-	return ret;
+	PASSED;
 }
 
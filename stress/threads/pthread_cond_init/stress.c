@@ -44,7 +44,6 @@
 /******************************   Test framework   *****************************************/
 /********************************************************************************************/
  #include "testfrmw.h"
- #include "testfrmw.c"
  /* This header is responsible for defining the following macros:
   * UNRESOLVED(ret, descr);  
   *    where descr is a description of the error and ret is an int (error code for example)
@@ -56,7 +55,7 @@
   * Both three macros shall terminate the calling process.
   * The testcase shall not terminate in any other maneer.
   * 
-  * The other file defines the functions
+  * It also declares the functions, which lib/testfrmw.c defines:
   * void output_init()
   * void output(char * string, ...)
   * 
@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * This file is a benchmark for the condition variables.  Where s-c.c
+ * measures the delay between a timeout and the wakeup of one thread, this
+ * program measures the wakeups by pthread_cond_signal and
+ * pthread_cond_broadcast, for a cond using CLOCK_REALTIME and one using
+ * CLOCK_MONOTONIC (pthread_condattr_setclock), process-private and
+ * process-shared.
+
+ * The steps are, for each cond:
+ * -> signal: one thread waits in pthread_cond_timedwait; the main thread
+ *    signals the cond.  The latency from the signal call to the return of
+ *    pthread_cond_timedwait is reported as p50, p99 and max.
+ * -> broadcast: 1, 2, 4 ... waiters wait on the cond; the main thread
+ *    broadcasts it.  For each number of waiters are reported:
+ *     - the herd time, from the broadcast until the last waiter has
+ *       re-acquired the mutex (p50 and max over the rounds);
+ *     - the wake latency of each waiter (p50 and p99);
+ *     - the context switches of the process per woken waiter.  When the
+ *       implementation requeues the waiters on the mutex, each waiter is
+ *       switched to about once; a thundering herd, where every waiter
+ *       wakes up to find the mutex taken and blocks again, shows 2 or
+ *       more.  The switches of the main thread weigh on small herds.
+
+ * Options:
+ *  -t n   up to n waiters (default 256)
+ *  -n n   number of signal samples (default 1000)
+ *  -r n   number of broadcast rounds per number of waiters (default 20)
+ *  -s str only run the conds whose description contains str
+
+ * The benchmark only reports numbers; it is UNRESOLVED when a cond
+ * cannot be set up and PASSED otherwise.
+ */
+
+ /* We are testing conformance to IEEE Std 1003.1, 2003 Edition */
+ #define _POSIX_C_SOURCE 200112L
+
+ #ifndef WITHOUT_XOPEN
+ #define _XOPEN_SOURCE 600
+ #endif
+
+/********************************************************************************************/
+/****************************** standard includes *****************************************/
+/********************************************************************************************/
+ #include <pthread.h>
+ #include <stdarg.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+
+ #include <time.h>
+ #include <errno.h>
+ #include <sys/resource.h>
+
+/********************************************************************************************/
+/******************************   Test framework   *****************************************/
+/********************************************************************************************/
+ #include "measure.h"
+
+ #include "testfrmw.h"
+ /* This header is responsible for defining the following macros:
+  * UNRESOLVED(ret, descr);
+  *    where descr is a description of the error and ret is an int (error code for example)
+  * FAILED(descr);
+  *    where descr is a short text saying why the test has failed.
+  * PASSED();
+  *    No parameter.
+  *
+  * Both three macros shall terminate the calling process.
+  * The testcase shall not terminate in any other maneer.
+  *
+  * It also declares the functions, which lib/testfrmw.c defines:
+  * void output_init()
+  * void output(char * string, ...)
+  *
+  * Those may be used to output information.
+  */
+
+/********************************************************************************************/
+/********************************** Configuration ******************************************/
+/********************************************************************************************/
+#ifndef SCALABILITY_FACTOR
+#define SCALABILITY_FACTOR 1
+#endif
+#ifndef VERBOSE
+#define VERBOSE 1
+#endif
+
+#ifndef WITHOUT_ALTCLK
+#define USE_ALTCLK  /* make tests with MONOTONIC CLOCK if supported */
+#endif
+
+#define WAIT_TIMEOUT 10 /* s, a waiter still waiting after this is stuck */
+
+/********************************************************************************************/
+/***********************************    Test case   *****************************************/
+/********************************************************************************************/
+
+struct {
+	int pshared;
+	clockid_t cid;
+	char * desc;
+} test_scenar[] = {
+	 { PTHREAD_PROCESS_PRIVATE, CLOCK_REALTIME , "Realtime" }
+	,{ PTHREAD_PROCESS_SHARED , CLOCK_REALTIME , "Realtime+PShared" }
+#ifdef USE_ALTCLK
+	,{ PTHREAD_PROCESS_PRIVATE, CLOCK_MONOTONIC, "Monotonic" }
+	,{ PTHREAD_PROCESS_SHARED , CLOCK_MONOTONIC, "Monotonic+PShared" }
+#endif
+};
+
+#define NSCENAR (sizeof(test_scenar) / sizeof(test_scenar[0]))
+
+/* Options */
+long max_waiters = 256;
+long signal_samples = 1000;
+long rounds = 20;
+char * only = NULL;
+
+/* The cond under test, its mutex and clock */
+pthread_cond_t cnd;
+pthread_mutex_t mtx;
+clockid_t cnd_clock;
+
+/* The main thread waits on this one, with mtx */
+pthread_cond_t ready;
+
+/* Protected by mtx */
+long nwaiters;   /* waiters in this round */
+long nwaiting;   /* waiters waiting on cnd */
+long nwoken;     /* waiters woken in this round */
+long generation; /* incremented by each wakeup */
+int stop;
+struct timespec ts_wake, ts_last;
+
+struct mes_hist wake_hist;
+
+pthread_attr_t ta;
+
+
+void * waiter(void * arg)
+{
+	struct timespec deadline, ts_back;
+	long gen;
+	int ret;
+
+	ret = pthread_mutex_lock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Waiter failed to lock the mutex");  }
+
+	while (1)
+	{
+		nwaiting++;
+		if (nwaiting == nwaiters)
+		{
+			ret = pthread_cond_signal(&ready);
+			if (ret != 0)  {  UNRESOLVED(ret, "Unable to signal the main thread");  }
+		}
+
+		ret = clock_gettime(cnd_clock, &deadline);
+		if (ret != 0)  {  UNRESOLVED(errno, "Unable to read the cond clock");  }
+		deadline.tv_sec += WAIT_TIMEOUT;
+
+		gen = generation;
+		do
+		{
+			ret = pthread_cond_timedwait(&cnd, &mtx, &deadline);
+		}
+		while ((ret == 0) && (gen == generation));
+		if (ret != 0)  {  UNRESOLVED(ret, "pthread_cond_timedwait did not return 0");  }
+
+		if (stop)
+			break;
+
+		mes_now(&ts_back);
+		mes_hist_record(&wake_hist, mes_elapsed_ns(&ts_wake, &ts_back));
+
+		nwoken++;
+		if (nwoken == nwaiters)
+		{
+			ts_last = ts_back;
+			ret = pthread_cond_signal(&ready);
+			if (ret != 0)  {  UNRESOLVED(ret, "Unable to signal the main thread");  }
+		}
+	}
+
+	ret = pthread_mutex_unlock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Waiter failed to unlock the mutex");  }
+
+	return NULL;
+}
+
+/* Wait, with mtx held, until every waiter waits on cnd */
+void wait_waiting(void)
+{
+	int ret;
+
+	while (nwaiting < nwaiters)
+	{
+		ret = pthread_cond_wait(&ready, &mtx);
+		if (ret != 0)  {  UNRESOLVED(ret, "Main thread failed to wait");  }
+	}
+}
+
+/* Wake the waiters once with pthread_cond_signal (1 waiter) or
+ * pthread_cond_broadcast; returns the herd time in ns */
+uint64_t do_round(int broadcast)
+{
+	int ret;
+
+	ret = pthread_mutex_lock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to lock the mutex");  }
+
+	wait_waiting();
+
+	nwaiting = 0;
+	nwoken = 0;
+	generation++;
+
+	mes_now(&ts_wake);
+	if (broadcast)
+		ret = pthread_cond_broadcast(&cnd);
+	else
+		ret = pthread_cond_signal(&cnd);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to wake the waiters");  }
+
+	while (nwoken < nwaiters)
+	{
+		ret = pthread_cond_wait(&ready, &mtx);
+		if (ret != 0)  {  UNRESOLVED(ret, "Main thread failed to wait");  }
+	}
+
+	ret = pthread_mutex_unlock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to unlock the mutex");  }
+
+	return mes_elapsed_ns(&ts_wake, &ts_last);
+}
+
+void start_waiters(pthread_t * th, long n)
+{
+	long i;
+	int ret;
+
+	nwaiters = n;
+	nwaiting = 0;
+	stop = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		ret = pthread_create(&th[i], &ta, waiter, NULL);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to create a waiter");  }
+	}
+}
+
+void stop_waiters(pthread_t * th, long n)
+{
+	long i;
+	int ret;
+
+	ret = pthread_mutex_lock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to lock the mutex");  }
+
+	wait_waiting();
+	stop = 1;
+	generation++;
+
+	ret = pthread_cond_broadcast(&cnd);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to wake the waiters");  }
+
+	ret = pthread_mutex_unlock(&mtx);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to unlock the mutex");  }
+
+	for (i = 0; i < n; i++)
+	{
+		ret = pthread_join(th[i], NULL);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to join a waiter");  }
+	}
+}
+
+long switches(void)
+{
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+	{  UNRESOLVED(errno, "getrusage failed");  }
+
+	return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+void usage(char * name)
+{
+	fprintf(stderr, "Usage: %s [-t waiters] [-n samples] [-r rounds] [-s pattern]\n", name);
+	exit(PTS_UNRESOLVED);
+}
+
+int main (int argc, char *argv[])
+{
+	pthread_mutexattr_t ma;
+	pthread_condattr_t ca;
+	struct mes_hist herd_hist;
+	pthread_t * th;
+	long altclk_ok, pshared_ok, n, i, sw;
+	size_t stack;
+	int ret, opt;
+	unsigned int s;
+
+	output_init();
+
+	while ((opt = getopt(argc, argv, "t:n:r:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': max_waiters = atol(optarg); break;
+			case 'n': signal_samples = atol(optarg); break;
+			case 'r': rounds = atol(optarg); break;
+			case 's': only = optarg; break;
+			default: usage(argv[0]);
+		}
+	}
+	if ((max_waiters < 1) || (signal_samples < 1) || (rounds < 1))
+		usage(argv[0]);
+
+	th = calloc(max_waiters, sizeof(pthread_t));
+	if (th == NULL)  {  UNRESOLVED(errno, "Not enough memory for thread storage");  }
+
+	/* Test machine capabilities */
+	altclk_ok = sysconf(_SC_CLOCK_SELECTION);
+	if (altclk_ok > 0)
+		altclk_ok = sysconf(_SC_MONOTONIC_CLOCK);
+	pshared_ok = sysconf(_SC_THREAD_PROCESS_SHARED);
+
+	/* Hundreds of waiters: keep their stacks small */
+	ret = pthread_attr_init(&ta);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize thread attributes");  }
+	stack = sysconf(_SC_THREAD_STACK_MIN);
+	if (stack < 65536)
+		stack = 65536;
+	ret = pthread_attr_setstacksize(&ta, stack);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to set stack size");  }
+
+	ret = pthread_cond_init(&ready, NULL);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize the main thread cond");  }
+
+	#if VERBOSE > 0
+	output("Cond benchmark: up to %ld waiters, %ld signal samples, %ld broadcast rounds\n",
+		max_waiters, signal_samples, rounds);
+	#endif
+
+	for (s = 0; s < NSCENAR; s++)
+	{
+		if ((test_scenar[s].pshared != PTHREAD_PROCESS_PRIVATE) && (pshared_ok <= 0))
+			continue;
+		if ((test_scenar[s].cid != CLOCK_REALTIME) && (altclk_ok <= 0))
+			continue;
+		if (only && !strstr(test_scenar[s].desc, only))
+			continue;
+
+		/* Initialize the cond and the mutex */
+		ret = pthread_mutexattr_init(&ma);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize mutex attribute");  }
+		ret = pthread_condattr_init(&ca);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize cond attribute");  }
+
+		if (pshared_ok > 0)
+		{
+			ret = pthread_mutexattr_setpshared(&ma, test_scenar[s].pshared);
+			if (ret != 0)  {  UNRESOLVED(ret, "Unable to set mutex process-shared");  }
+			ret = pthread_condattr_setpshared(&ca, test_scenar[s].pshared);
+			if (ret != 0)  {  UNRESOLVED(ret, "Unable to set cond process-shared");  }
+		}
+
+		#ifdef USE_ALTCLK
+		if (altclk_ok > 0)
+		{
+			ret = pthread_condattr_setclock(&ca, test_scenar[s].cid);
+			if (ret != 0)  {  UNRESOLVED(ret, "Unable to set the cond clock");  }
+		}
+		#endif
+		cnd_clock = test_scenar[s].cid;
+
+		ret = pthread_mutex_init(&mtx, &ma);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize the mutex");  }
+		ret = pthread_cond_init(&cnd, &ca);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to initialize the cond");  }
+
+		ret = pthread_mutexattr_destroy(&ma);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy mutex attribute");  }
+		ret = pthread_condattr_destroy(&ca);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy cond attribute");  }
+
+		output("-----\n");
+
+		/* Signal latency */
+		mes_hist_init(&wake_hist);
+		start_waiters(th, 1);
+		for (i = 0; i < signal_samples; i++)
+			do_round(0);
+		stop_waiters(th, 1);
+
+		output("%s: signal p50 %.3f us, p99 %.3f us, max %.3f us\n", test_scenar[s].desc,
+			mes_hist_percentile(&wake_hist, 50) / 1e3,
+			mes_hist_percentile(&wake_hist, 99) / 1e3,
+			mes_hist_percentile(&wake_hist, 100) / 1e3);
+
+		/* Broadcast herd */
+		output("%s: %7s %12s %12s %12s %12s %9s\n", test_scenar[s].desc, "waiters",
+			"herd p50 us", "herd max us", "wake p50 us", "wake p99 us", "sw/waiter");
+
+		for (n = 1; ; n = (2 * n < max_waiters) ? 2 * n : max_waiters)
+		{
+			mes_hist_init(&wake_hist);
+			mes_hist_init(&herd_hist);
+
+			start_waiters(th, n);
+			do_round(1); /* warm-up: every waiter has run once */
+			mes_hist_init(&wake_hist);
+
+			sw = switches();
+			for (i = 0; i < rounds; i++)
+				mes_hist_record(&herd_hist, do_round(1));
+			sw = switches() - sw;
+			stop_waiters(th, n);
+
+			output("%s: %7ld %12.3f %12.3f %12.3f %12.3f %9.2f\n", test_scenar[s].desc, n,
+				mes_hist_percentile(&herd_hist, 50) / 1e3,
+				mes_hist_percentile(&herd_hist, 100) / 1e3,
+				mes_hist_percentile(&wake_hist, 50) / 1e3,
+				mes_hist_percentile(&wake_hist, 99) / 1e3,
+				(double) sw / (rounds * n));
+
+			if (n == max_waiters)
+				break;
+		}
+
+		ret = pthread_cond_destroy(&cnd);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy the cond");  }
+		ret = pthread_mutex_destroy(&mtx);
+		if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy the mutex");  }
+	}
+
+	ret = pthread_cond_destroy(&ready);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy the main thread cond");  }
+	ret = pthread_attr_destroy(&ta);
+	if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy thread attributes");  }
+	free(th);
+
+	#if VERBOSE > 0
+	output("-----\n");
+	output("Benchmark completed\n");
+	#endif
+
+	PASSED;
+}
@@ -56,8 +56,9 @@
 /********************************************************************************************/
 /******************************   Test framework   *****************************************/
 /********************************************************************************************/
+ #include "measure.h"
+
  #include "testfrmw.h"
- #include "testfrmw.c"
  /* This header is responsible for defining the following macros:
   * UNRESOLVED(ret, descr);  
   *    where descr is a description of the error and ret is an int (error code for example)
@@ -69,7 +70,7 @@
   * Both three macros shall terminate the calling process.
   * The testcase shall not terminate in any other maneer.
   * 
-  * The other file defines the functions
+  * It also declares the functions, which lib/testfrmw.c defines:
   * void output_init()
   * void output(char * string, ...)
   * 
@@ -93,10 +94,15 @@
 #define MES_TIMEOUT  (1000000) /* ns, offset for the pthread_cond_timedwait call */
 
 #ifdef PLOT_OUTPUT
-#undef VERBOSE
-#define VERBOSE 0
+#define PLOT 1
+#else
+#define PLOT 0
 #endif
 
+/* The above are only the defaults, see mes_getopt() in measure.h */
+
+#define RESOLUTION (mes_opt.resolution ? mes_opt.resolution : 100 * mes_opt.scale)
+
 // #define USE_CANCEL  /* Will cancel the threads instead of signaling the cond */#define 
 
 /********************************************************************************************/
@@ -147,13 +153,8 @@ struct {
 
 pthread_attr_t  ta;
 
-/* The next structure is used to save the tests measures */
-typedef struct __mes_t
-{
-	int  nthreads;
-	long _data[ NSCENAR ]; /* As we store µsec values, a long type should be amply enough. */
-	struct __mes_t *next;
-} mes_t;
+/* The measures are saved in a mes_set (see measure.h), one series per scenario */
+#define ANALYSIS_OUTPUT (mes_opt.verbose > 1 ? output : NULL)
 
 
 /**** do_measure
@@ -248,11 +249,12 @@ void * waiter(void * arg)
 /**** do_threads_test
  * This function is responsible for all the testing with a given # of threads
  *  nthreads is the amount of threads to create.
+ *  measure receives the duration of each scenario, in µsec.
  * the return value is: 
  *  < 0 if function was not able to create enough threads.
  *  cumulated # of nanoseconds otherwise.
  */
-long do_threads_test( int nthreads, mes_t * measure )
+long do_threads_test( int nthreads, double * measure )
 {
 	int ret;
 	
@@ -284,9 +286,8 @@ long do_threads_test( int nthreads, mes_t * measure )
 	if (th == NULL)  {  UNRESOLVED(errno, "Not enough memory for thread storage");  }
 	
 		
-	#ifdef PLOT_OUTPUT
-	output("%d", nthreads);
-	#endif	
+	if (mes_opt.plot)
+		output("%d", nthreads);
 	/* For each test scenario (mutex and cond attributes) */
 	for (s=0; s < NSCENAR ; s++)
 	{
@@ -321,11 +322,10 @@ long do_threads_test( int nthreads, mes_t * measure )
 		ts_cumul.tv_sec= 0;
 		ts_cumul.tv_nsec=0;
 
-		#if VERBOSE > 1
-		output("Starting case %s\n", test_scenar[s].desc);
-		#endif
+		if (mes_opt.verbose > 1)
+			output("Starting case %s\n", test_scenar[s].desc);
 
-		for (scal=0; scal <  5 * SCALABILITY_FACTOR; scal ++)
+		for (scal=0; scal <  5 * mes_opt.scale; scal ++)
 		{
 			/* Initialize the mutex, the cond, and other data */
 			ret = pthread_mutex_init(&mtx, &ma);
@@ -343,9 +343,8 @@ long do_threads_test( int nthreads, mes_t * measure )
 				ret = pthread_create(&th[i], &ta, waiter, (void *)&td);
 				if (ret != 0) /* We reached the limits */
 				{
-					#if VERBOSE > 1
-					output("Limit reached with %i threads\n", i);
-					#endif
+					if (mes_opt.verbose > 1)
+						output("Limit reached with %i threads\n", i);
 					#ifdef USE_CANCEL
 					for (j = i-1; j>=0; j--)
 					{
@@ -367,9 +366,8 @@ long do_threads_test( int nthreads, mes_t * measure )
 				}
 			}
 			/* All waiter threads are created now */
-			#if VERBOSE > 5
-			output("%i waiter threads created successfully\n", i);
-			#endif
+			if (mes_opt.verbose > 5)
+				output("%i waiter threads created successfully\n", i);
 			
 			ret = pthread_mutex_lock(&mtx);
 			if (ret != 0)  {  UNRESOLVED(ret, "Unable to lock mutex");  }
@@ -391,15 +389,13 @@ long do_threads_test( int nthreads, mes_t * measure )
 			ret = pthread_mutex_unlock(&mtx);
 			if (ret != 0)  {  UNRESOLVED(ret, "Mutex unlock failed");  }
 	
-			#if VERBOSE > 5
-			output("%i waiter threads are waiting; start measure\n", tnum);
-			#endif
+			if (mes_opt.verbose > 5)
+				output("%i waiter threads are waiting; start measure\n", tnum);
 			
 			do_measure(&mtx, &cnd, test_scenar[s].cid, &ts);
 			
-			#if VERBOSE > 5
-			output("Measure for %s returned %d.%09d\n", test_scenar[s].desc, ts.tv_sec, ts.tv_nsec);
-			#endif
+			if (mes_opt.verbose > 5)
+				output("Measure for %s returned %d.%09d\n", test_scenar[s].desc, ts.tv_sec, ts.tv_nsec);
 			
 			ts_cumul.tv_sec += ts.tv_sec;
 			ts_cumul.tv_nsec += ts.tv_nsec;
@@ -414,9 +410,8 @@ long do_threads_test( int nthreads, mes_t * measure )
 			ret = pthread_cond_broadcast(&cnd);
 			if (ret != 0)  {  UNRESOLVED(ret, "Unable to broadcast the condition");  }
 			
-			#if VERBOSE > 5
-			output("Joining the waiters...\n");
-			#endif
+			if (mes_opt.verbose > 5)
+				output("Joining the waiters...\n");
 	
 			/* We will join every threads */
 			for (i=0; i<nthreads; i++)
@@ -435,11 +430,10 @@ long do_threads_test( int nthreads, mes_t * measure )
 			if (ret != 0)  {  UNRESOLVED(ret, "Unable to destroy cond");  }
 		}
 		
-		#ifdef PLOT_OUTPUT
-		output(" %d.%09d", ts_cumul.tv_sec, ts_cumul.tv_nsec);
-		#endif
+		if (mes_opt.plot)
+			output(" %d.%09d", ts_cumul.tv_sec, ts_cumul.tv_nsec);
 		
-		measure->_data[s] = ts_cumul.tv_sec * 1000000 + (ts_cumul.tv_nsec / 1000) ; /* We reduce precision */
+		measure[s] = ts_cumul.tv_sec * 1000000.0 + ts_cumul.tv_nsec / 1000.0;
 		
 		/* Destroy the mutex attributes */
 		ret = pthread_mutexattr_destroy(&ma);
@@ -452,38 +446,35 @@ long do_threads_test( int nthreads, mes_t * measure )
 	/* Free the memory */
 	free(th);
 	
-	#if VERBOSE > 2
-	output("%5d threads; %d.%09d s (%i loops)\n", nthreads, ts_cumul.tv_sec, ts_cumul.tv_nsec, scal);
-	#endif
+	if (mes_opt.verbose > 2)
+		output("%5d threads; %d.%09d s (%i loops)\n", nthreads, ts_cumul.tv_sec, ts_cumul.tv_nsec, scal);
 	
-	#ifdef PLOT_OUTPUT
-	output("\n");
-	#endif	
+	if (mes_opt.plot)
+		output("\n");
 	
 	return ts_cumul.tv_sec * 1000000000 + ts_cumul.tv_nsec;
 }
 
-/* Forward declaration */
-int parse_measure(mes_t * measures);
-
 /* Main 
  */
 int main (int argc, char *argv[])
 {
-	int ret, nth;
+	int ret, nth, s;
 	long dur;
+	double y[ NSCENAR ];
 	
-	
-	
-	/* Initialize the measure list */
-	mes_t sentinel;
-	mes_t *m_cur, *m_tmp;
-	m_cur = &sentinel;
-	m_cur->next = NULL;
+	struct mes_set measures;
 	
 	/* Initialize the output */
 	output_init();
 	
+	/* Read the load and the verbosity */
+	if (mes_getopt(argc, argv, SCALABILITY_FACTOR, VERBOSE, PLOT) != 0)  {  UNRESOLVED(EINVAL, "Bad options");  }
+	
+	/* Initialize the measure storage: every sample is allocated now */
+	ret = mes_init(&measures, NSCENAR, 1024);
+	if (ret != 0)  {  UNRESOLVED(ret, "Not enough memory for measure storage");  }
+	
 	/* Test machine capabilities */
 	/* -> clockid_t; pshared; ... */
 	altclk_ok = sysconf(_SC_CLOCK_SELECTION);
@@ -496,11 +487,12 @@ int main (int argc, char *argv[])
 
 	pshared_ok = sysconf(_SC_THREAD_PROCESS_SHARED);
 	
-	#if VERBOSE > 0
-	output("Test starting\n");
-	output(" Process-shared primitive %s be tested\n", (pshared_ok>0)?"will":"won't");
-	output(" Alternative clock for cond %s be tested\n", (altclk_ok>0)?"will":"won't");
-	#endif
+	if (mes_opt.verbose > 0)
+	{
+		output("Test starting\n");
+		output(" Process-shared primitive %s be tested\n", (pshared_ok>0)?"will":"won't");
+		output(" Alternative clock for cond %s be tested\n", (altclk_ok>0)?"will":"won't");
+	}
 
 	/* Prepare thread attribute */
 	ret = pthread_attr_init(&ta);
@@ -510,317 +502,47 @@ int main (int argc, char *argv[])
 	if (ret != 0)
 	{  UNRESOLVED(ret, "Unable to set stack size to minimum value");  }
 	
-	#ifdef PLOT_OUTPUT
-	output("# COLUMNS %d #threads", NSCENAR + 1);
-	for (nth=0; nth<NSCENAR; nth++) 
-		output(" %s", test_scenar[nth].desc);
-	output("\n");
-	#endif	
+	if (mes_opt.plot)
+	{
+		output("# COLUMNS %d #threads", NSCENAR + 1);
+		for (nth=0; nth<NSCENAR; nth++) 
+			output(" %s", test_scenar[nth].desc);
+		output("\n");
+	}
 	
 	/* Do the testing */
 	nth = 0;
 	do 
 	{
-		nth += 100 * SCALABILITY_FACTOR;
-		
-		/* Create a new measure item */
-		m_tmp = (mes_t *) malloc(sizeof(mes_t));
-		if (m_tmp == NULL) { UNRESOLVED(errno, "Unable to alloc memory for measure saving");  }
-		m_tmp->nthreads = nth;
-		m_tmp->next = NULL;
+		nth += RESOLUTION;
 		
 		/* Run the test */
-		dur = do_threads_test(nth, m_tmp);
+		dur = do_threads_test(nth, y);
 		
-		/* If test was success, add this measure to the list. Otherwise, free the mem */
+		/* If test was success, add this measure to the set */
 		if (dur >= 0)
 		{
-			m_cur->next = m_tmp;
-			m_cur = m_tmp;
-		}
-		else
-		{
-			free(m_tmp);
+			for (s=0; s<NSCENAR; s++)
+				mes_record(&measures, nth, s, y[s]);
 		}
 	}
-	while (dur >= 0);
+	while ((dur >= 0) && ((mes_opt.max == 0) || (nth + RESOLUTION <= mes_opt.max)));
 	
 	
 	/* We will now parse the results to determine if the measure is ~ constant or is growing. */
 	
-	ret = parse_measure(&sentinel);
+	ret = mes_analyze(&measures, NULL, ANALYSIS_OUTPUT);
 	
-	/* Free the memory from the list */
-	m_cur = sentinel.next;
-	while (m_cur != NULL)
-	{
-		m_tmp = m_cur;
-		m_cur = m_tmp->next;
-		free(m_tmp);
-	}
+	mes_fini(&measures);
 	
 	if (ret != 0)
 	{
 		FAILED("This function is not scalable");
 	}
 	
-	#if VERBOSE > 0
-	output("The function is scalable\n");
-	#endif
+	if (mes_opt.verbose > 0)
+		output("The function is scalable\n");
 	
 	PASSED;
 }
 
-
-
-/***
- * The next function will seek for the better model for each series of measurements.
- *
- * The tested models are: -- X = # threads; Y = latency
- * -> Y = a;      -- Error is r1 = avg( (Y - Yavg)² );
- * -> Y = aX + b; -- Error is r2 = avg( (Y -aX -b)² );
- *                -- where a = avg ( (X - Xavg)(Y - Yavg) ) / avg( ( X - Xavg)² )
- *                --         Note: We will call _q = sum( (X - Xavg) * (Y - Yavg) ); 
- *                --                       and  _d = sum( (X - Xavg)² );
- *                -- and   b = Yavg - a * Xavg
- * -> Y = c * X^a;-- Same as previous, but with log(Y) = a log(X) + b; and b = log(c). Error is r3
- * -> Y = exp(aX + b); -- log(Y) = aX + b. Error is r4
- *
- * We compute each error factor (r1, r2, r3, r4) then search which is the smallest (with ponderation).
- * The function returns 0 when r1 is the best for all cases (latency is constant) and !0 otherwise.
- */
-
-struct row
-{
-	long X;  /* the X values -- copied from function argument */
-	long Y[NSCENAR];  /* the Y values -- copied from function argument */
-	long _x; /* Value X - Xavg */
-	long _y[NSCENAR]; /* Value Y - Yavg */
-	double LnX; /* Natural logarithm of X values */
-	double LnY[NSCENAR]; /* Natural logarithm of Y values */
-	double _lnx; /* Value LnX - LnXavg */
-	double _lny[NSCENAR]; /* Value LnY - LnYavg */
-};
-
-int parse_measure(mes_t * measures)
-{
-	int ret, i, r;
-	
-	mes_t *cur;
-	
-	double Xavg, Yavg[NSCENAR];
-	double LnXavg, LnYavg[NSCENAR];
-	
-	int N; 
-	
-	double r1[NSCENAR], r2[NSCENAR], r3[NSCENAR], r4[NSCENAR];
-	
-	/* Some more intermediate vars */
-	long double _q[3][NSCENAR];
-	long double _d[3][NSCENAR];
-	
-	long double t; /* temp value */
-	
-	struct row *Table = NULL;
-	
-	/* Initialize the datas */
-	Xavg = 0.0;
-	LnXavg = 0.0;
-	for (i=0; i<NSCENAR; i++)
-	{
-		Yavg[i] = 0.0;
-		LnYavg[i] = 0.0;
-		r1[i] = 0.0;
-		r2[i] = 0.0;
-		r3[i] = 0.0;
-		r4[i] = 0.0;
-		_q[0][i]=0.0;
-		_q[1][i]=0.0;
-		_q[2][i]=0.0;
-		_d[0][i]=0.0;
-		_d[1][i]=0.0;
-		_d[2][i]=0.0;
-	}
-	N=0;
-	cur = measures;
-	
-	#if VERBOSE > 1
-	output("Data analysis starting\n");
-	#endif
-	
-	/* We start with reading the list to find:
-	 * -> number of elements, to assign an array
-	 * -> average values 
-	 */
-	while (cur->next != NULL)
-	{
-		cur = cur->next;
-		
-		N++;
-		
-		Xavg += (double) cur->nthreads;
-		LnXavg += log( (double) cur->nthreads);
-		
-		for (i=0; i<NSCENAR; i++)
-		{
-			Yavg[i] += (double) cur->_data[i];
-			LnYavg[i] += log( (double) cur->_data[i] );
-		}
-	}
-	
-	/* We have the sum; we can divide to obtain the average values */
-	Xavg /= N;
-	LnXavg /= N;
-	
-	for (i=0; i<NSCENAR; i++)
-	{
-		Yavg[i] /= N;
-		LnYavg[i] /= N;
-	}
-	
-	#if VERBOSE > 1
-	output(" Found %d rows and %d columns\n", N, NSCENAR);
-	#endif
-	
-	
-	/* We will now alloc the array ... */
-	Table = calloc(N, sizeof( struct row ));
-	if (Table == NULL)  {  UNRESOLVED(errno, "Unable to alloc space for results parsing");  }
-	
-	/* ... and fill it */
-	N = 0;
-	cur = measures;
-	
-	while (cur->next != NULL)
-	{
-		cur = cur->next;
-		
-		Table[N].X = (long) cur->nthreads;
-		Table[N]._x = Table[N].X - Xavg ;
-		Table[N].LnX = log((double) cur->nthreads);
-		Table[N]._lnx = Table[N].LnX - LnXavg;
-		for (i=0; i<NSCENAR; i++)
-		{
-			Table[N].Y[i] = cur->_data[i];
-			Table[N]._y[i] = Table[N].Y[i] - Yavg[i] ;
-			Table[N].LnY[i] = log((double) cur->_data[i]);
-			Table[N]._lny[i] = Table[N].LnY[i] - LnYavg[i];
-		}
-		
-		N++;
-	}
-	
-	/* We won't need the list anymore -- we'll work with the array which should be faster. */
-	#if VERBOSE > 1
-	output(" Data was stored in an array.\n");
-	#endif
-	
-	/* We need to read the full array at least twice to compute all the error factors */
-	
-	/* In the first pass, we'll compute:
-	 * -> r1 for each scenar.
-	 * -> "a" factor for linear (0), power (1) and exponential (2) approximations -- with using the _d and _q vars.
-	 */
-	#if VERBOSE > 1
-	output("Starting first pass...\n");
-	#endif
-	for (r=0; r<N; r++)
-	{
-		for (i=0; i<NSCENAR; i++)
-		{
-			r1[i] += ((double)Table[r]._y[i] / N) * (double)Table[r]._y[i];
-			
-			_q[0][i] += Table[r]._y[i] * Table[r]._x;
-			_d[0][i] += Table[r]._x * Table[r]._x;
-			
-			_q[1][i] += Table[r]._lny[i] * Table[r]._lnx;
-			_d[1][i] += Table[r]._lnx * Table[r]._lnx;
-			
-			_q[2][i] += Table[r]._lny[i] * Table[r]._x;
-			_d[2][i] += Table[r]._x * Table[r]._x;
-		}
-	}
-	
-	/* First pass is terminated; a2 = _q[0]/_d[0]; a3 = _q[1]/_d[1]; a4 = _q[2]/_d[2] */
-
-	/* In the first pass, we'll compute:
-	 * -> r2, r3, r4 for each scenar.
-	 */
-	
-	#if VERBOSE > 1
-	output("Starting second pass...\n");
-	#endif
-	for (r=0; r<N; r++)
-	{
-		for (i=0; i<NSCENAR; i++)
-		{
-			/* r2 = avg((y - ax -b)²);  t = (y - ax - b) = (y - yavg) - a (x - xavg); */
-			t = ( Table[r]._y[i] - ((_q[0][i] * Table[r]._x) / _d[0][i]));
-			r2[i] += t * t / N  ;
-			
-			/* r3 = avg(( y - c.x^a) ²);  
-			    t = y - c * x ^ a 
-			      = y - log (LnYavg - (_q[1]/_d[1]) * LnXavg) * x ^ (_q[1]/_d[1])
-			*/
-			t = (   Table[r].Y[i]
-			      - ( logl ( LnYavg[i] - (_q[1][i] / _d[1][i] ) * LnXavg)
-			        * powl( Table[r].X,  (_q[1][i] / _d[1][i] ))
-			    )   );
-			r3[i] += t * t / N  ;
-			
-			/* r4 = avg(( y - exp(ax+b))²);
-			    t = y - exp(ax+b)
-			      = y - exp( _q[2]/_d[2] * x + ( LnYavg - (_q[2]/_d[2] * Xavg) ));
-			      = y - exp( _q[2]/_d[2] * (x - Xavg) + LnYavg );
-			*/
-			t = (   Table[r].Y[i]
-			      - expl( ( _q[2][i] / _d[2][i] ) * Table[r]._x + LnYavg[i] ) );
-			r4[i] += t * t / N  ;
-			
-		}
-	}
-
-	#if VERBOSE > 1
-	output("All computing terminated.\n");
-	#endif
-	ret = 0;
-	for (i=0; i<NSCENAR; i++)
-	{
-		#if VERBOSE > 1
-		output("\nScenario: %s\n", test_scenar[i].desc);
-		
-		output("  Model: Y = k\n");
-		output("       k = %g\n", Yavg[i]);
-		output("    Divergence %g\n", r1[i]);
-		
-		output("  Model: Y = a * X + b\n");
-		output("       a = %Lg\n", _q[0][i] / _d[0][i]);
-		output("       b = %Lg\n", Yavg[i] - ((_q[0][i] / _d[0][i]) * Xavg));
-		output("    Divergence %g\n", r2[i]);
-		
-		output("  Model: Y = c * X ^ a\n");
-		output("       a = %Lg\n", _q[1][i] / _d[1][i]);
-		output("       c = %Lg\n", logl ( LnYavg[i] - (_q[1][i] / _d[1][i] ) * LnXavg));
-		output("    Divergence %g\n", r2[i]);
-		
-		output("  Model: Y = exp(a * X + b)\n");
-		output("       a = %Lg\n", _q[2][i] / _d[2][i]);
-		output("       b = %Lg\n", LnYavg[i] - ((_q[2][i] / _d[2][i]) * Xavg));
-		output("    Divergence %g\n", r2[i]);
-		#endif
-		/* Compare r1 to other values, with some ponderations */
-		if ((r1[i] > 1.1 * r2[i]) || (r1[i] > 1.2 * r3[i]) || (r1[i] > 1.3 * r4[i]))
-			ret++;
-		#if VERBOSE > 1
-		else
-			output(" Sanction: OK\n");
-		#endif
-	}
-	
-	/* We need to free the array */
-	free(Table);
-	
-	/* We're done */
-	return ret;
-}
-
@@ -0,0 +1,556 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * This file is a benchmark for the pthread_mutex_lock and
+ * pthread_mutex_unlock functions.  Where s-c1.c and s-c2.c check how many
+ * threads can wait on a mutex, this program measures how fast the mutexes
+ * are, for each combination of:
+ *  type:     NORMAL, ERRORCHECK, RECURSIVE, DEFAULT (XSI)
+ *  protocol: PTHREAD_PRIO_NONE, PTHREAD_PRIO_INHERIT, PTHREAD_PRIO_PROTECT
+ *  pshared:  PTHREAD_PROCESS_PRIVATE, PTHREAD_PROCESS_SHARED
+ * when the implementation supports it.
+
+ * The steps are, for each mutex:
+ * -> uncontended: a single thread locks and unlocks the mutex in a loop.
+ *    The best of 5 runs is reported in ns per lock/unlock pair.
+ * -> handoff: the main thread holds the mutex while a second thread
+ *    blocks on it, then releases it.  The latency from the unlock call
+ *    to the return of the lock call in the waiter is reported as p50,
+ *    p99 and max.
+ * -> throughput: 1, 2, 4 ... threads lock the mutex, run the critical
+ *    section, and unlock it, for a fixed duration.  The total number of
+ *    lock/unlock pairs per second is reported, and the fairness: the
+ *    ratio of the fewest to the most pairs done by a thread.
+
+ * Options:
+ *  -t n   contend with up to n threads (default: twice the CPUs)
+ *  -c n   the critical section increments a counter n times (default 0)
+ *  -d ms  duration of each throughput measure (default 200)
+ *  -n n   number of handoff samples (default 1000)
+ *  -P     pin each thread on a CPU (Linux)
+ *  -s str only run the mutexes whose description contains str
+
+ * The benchmark only reports numbers; it is UNRESOLVED when a mutex
+ * cannot be set up and PASSED otherwise.
+ */
+
+ /* We are testing conformance to IEEE Std 1003.1, 2003 Edition */
+ #define _POSIX_C_SOURCE 200112L
+
+ /* We enable the following line to have mutex attributes defined */
+#ifndef WITHOUT_XOPEN
+ #define _XOPEN_SOURCE	600
+#endif
+
+#ifdef __linux__
+ #define _GNU_SOURCE	/* pthread_setaffinity_np() */
+#endif
+
+/********************************************************************************************/
+/****************************** standard includes *****************************************/
+/********************************************************************************************/
+ #include <pthread.h>
+ #include <errno.h>
+ #include <sched.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <stdarg.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+
+ #include "measure.h"
+
+/********************************************************************************************/
+/******************************   Test framework   *****************************************/
+/********************************************************************************************/
+ #include "testfrmw.h"
+ /* This header is responsible for defining the following macros:
+  * UNRESOLVED(ret, descr);
+  *    where descr is a description of the error and ret is an int (error code for example)
+  * FAILED(descr);
+  *    where descr is a short text saying why the test has failed.
+  * PASSED();
+  *    No parameter.
+  *
+  * Both three macros shall terminate the calling process.
+  * The testcase shall not terminate in any other maneer.
+  *
+  * It also declares the functions, which lib/testfrmw.c defines:
+  * void output_init()
+  * void output(char * string, ...)
+  *
+  * Those may be used to output information.
+  */
+
+/********************************************************************************************/
+/********************************** Configuration ******************************************/
+/********************************************************************************************/
+#ifndef SCALABILITY_FACTOR
+#define SCALABILITY_FACTOR 1
+#endif
+#ifndef VERBOSE
+#define VERBOSE 1
+#endif
+
+#define UNCONTENDED_LOOPS (1000000 * SCALABILITY_FACTOR)
+#define UNCONTENDED_RUNS 5
+
+/********************************************************************************************/
+/***********************************    Test case   *****************************************/
+/********************************************************************************************/
+
+struct _scenar
+{
+	int m_type; /* Mutex type to use */
+	int m_pshared; /* 0: mutex is process-private (default) ~ !0: mutex is process-shared, if supported */
+	char * descr; /* Case description */
+}
+scenarii[] =
+{
+#ifndef WITHOUT_XOPEN
+	 {PTHREAD_MUTEX_NORMAL,     0, "Normal"}
+	,{PTHREAD_MUTEX_ERRORCHECK, 0, "Errorcheck"}
+	,{PTHREAD_MUTEX_RECURSIVE,  0, "Recursive"}
+	,{PTHREAD_MUTEX_DEFAULT,    0, "Default"}
+
+	,{PTHREAD_MUTEX_NORMAL,     1, "Pshared Normal"}
+	,{PTHREAD_MUTEX_ERRORCHECK, 1, "Pshared Errorcheck"}
+	,{PTHREAD_MUTEX_RECURSIVE,  1, "Pshared Recursive"}
+	,{PTHREAD_MUTEX_DEFAULT,    1, "Pshared Default"}
+#else
+	 {0, 0, "Default"}
+	,{0, 1, "Pshared Default"}
+#endif
+};
+#define NSCENAR (sizeof(scenarii)/sizeof(scenarii[0]))
+
+struct _protocol
+{
+	int protocol;
+	int sc_name; /* sysconf() name of the option, 0 if none */
+	char * descr;
+}
+protocols[] =
+{
+	 {PTHREAD_PRIO_NONE,    0,                       "PrioNone"}
+#ifdef _POSIX_THREAD_PRIO_INHERIT
+	,{PTHREAD_PRIO_INHERIT, _SC_THREAD_PRIO_INHERIT, "PrioInherit"}
+#endif
+#ifdef _POSIX_THREAD_PRIO_PROTECT
+	,{PTHREAD_PRIO_PROTECT, _SC_THREAD_PRIO_PROTECT, "PrioProtect"}
+#endif
+};
+#define NPROTOCOLS (sizeof(protocols)/sizeof(protocols[0]))
+
+/* Options */
+long max_threads = 0;
+long cs_length = 0;
+long duration_ms = 200;
+long handoff_samples = 1000;
+int pinning = 0;
+char * only = NULL;
+
+long ncpus = 1;
+
+/* The mutex under test */
+pthread_mutex_t mtx;
+
+/* Data shared with the threads */
+volatile int go, stop;
+volatile unsigned long counter;
+
+struct worker
+{
+	pthread_t th;
+	long cpu;
+	unsigned long ops;
+};
+
+/* Handoff state: 1 the main thread holds the mutex, 2 the waiter is about
+ * to block, 3 the waiter got the mutex and released it (or is ready) */
+volatile int handoff;
+struct timespec ts_unlock;
+struct mes_hist handoff_hist;
+
+
+void pin(long cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int ret;
+
+	if (!pinning)
+		return;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu % ncpus, &set);
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Unable to pin a thread");  }
+#else
+	(void) cpu;
+#endif
+}
+
+/* Lock and unlock the mutex once in a new thread.  glibc fails the first
+ * PTHREAD_PRIO_PROTECT lock of each thread with EINVAL, so retry once. */
+int first_lock(void)
+{
+	int ret;
+
+	ret = pthread_mutex_lock(&mtx);
+	if (ret == EINVAL)
+		ret = pthread_mutex_lock(&mtx);
+	if (ret != 0)
+		return ret;
+	return pthread_mutex_unlock(&mtx);
+}
+
+/* Returns the best time for a lock/unlock pair in ns, or < 0 with the
+ * error code of the first failing call */
+double uncontended(void)
+{
+	struct timespec ts_ref, ts_fin;
+	double best = -1, ns;
+	long i;
+	int r, ret;
+
+	ret = first_lock();
+	if (ret != 0)
+		return -ret;
+
+	for (r = 0; r < UNCONTENDED_RUNS; r++)
+	{
+		mes_now(&ts_ref);
+		for (i = 0; i < UNCONTENDED_LOOPS; i++)
+		{
+			ret = pthread_mutex_lock(&mtx);
+			if (ret != 0)
+				return -ret;
+			ret = pthread_mutex_unlock(&mtx);
+			if (ret != 0)
+				return -ret;
+		}
+		mes_now(&ts_fin);
+
+		ns = (double) mes_elapsed_ns(&ts_ref, &ts_fin) / UNCONTENDED_LOOPS;
+		if ((best < 0) || (ns < best))
+			best = ns;
+	}
+	return best;
+}
+
+void * waiter(void * arg)
+{
+	struct timespec ts_lock;
+	long i;
+	int ret;
+
+	pin(1);
+
+	ret = first_lock();
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Waiter failed to lock the mutex");  }
+	handoff = 3;
+
+	for (i = 0; i < handoff_samples; i++)
+	{
+		while (handoff != 1)
+			sched_yield();
+		handoff = 2;
+
+		ret = pthread_mutex_lock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Waiter failed to lock the mutex");  }
+		mes_now(&ts_lock);
+
+		/* ts_unlock was written before the unlock which let us in */
+		mes_hist_record(&handoff_hist, mes_elapsed_ns(&ts_unlock, &ts_lock));
+
+		ret = pthread_mutex_unlock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Waiter failed to unlock the mutex");  }
+		handoff = 3;
+	}
+	return NULL;
+}
+
+void measure_handoff(void)
+{
+	struct timespec ts_wait = { 0, 100000 }; /* let the waiter block */
+	pthread_t th;
+	long i;
+	int ret;
+
+	mes_hist_init(&handoff_hist);
+	handoff = 0;
+
+	pin(0);
+
+	ret = pthread_create(&th, NULL, waiter, NULL);
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Unable to create the waiter thread");  }
+
+	while (handoff != 3)
+		sched_yield();
+
+	for (i = 0; i < handoff_samples; i++)
+	{
+		ret = pthread_mutex_lock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to lock the mutex");  }
+		handoff = 1;
+
+		while (handoff != 2)
+			sched_yield();
+		nanosleep(&ts_wait, NULL);
+
+		mes_now(&ts_unlock);
+		ret = pthread_mutex_unlock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to unlock the mutex");  }
+
+		while (handoff != 3)
+			sched_yield();
+	}
+
+	ret = pthread_join(th, NULL);
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Unable to join the waiter thread");  }
+}
+
+void * contender(void * arg)
+{
+	struct worker * w = arg;
+	unsigned long ops = 0;
+	long i;
+	int ret;
+
+	pin(w->cpu);
+
+	ret = first_lock();
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Contender failed to lock the mutex");  }
+
+	while (!go)
+		sched_yield();
+
+	while (!stop)
+	{
+		ret = pthread_mutex_lock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Contender failed to lock the mutex");  }
+
+		for (i = 0; i < cs_length; i++)
+			counter++;
+
+		ret = pthread_mutex_unlock(&mtx);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Contender failed to unlock the mutex");  }
+		ops++;
+	}
+
+	w->ops = ops;
+	return NULL;
+}
+
+/* Returns the pairs per second, and the fairness in *fair */
+double measure_throughput(long nthreads, struct worker * w, double * fair)
+{
+	struct timespec ts_ref, ts_fin, ts_dur;
+	unsigned long total = 0, min = 0, max = 0;
+	long i;
+	int ret;
+
+	go = 0;
+	stop = 0;
+
+	for (i = 0; i < nthreads; i++)
+	{
+		w[i].cpu = i;
+		w[i].ops = 0;
+		ret = pthread_create(&w[i].th, NULL, contender, &w[i]);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to create a contender thread");  }
+	}
+
+	ts_dur.tv_sec = duration_ms / 1000;
+	ts_dur.tv_nsec = (duration_ms % 1000) * 1000000;
+
+	mes_now(&ts_ref);
+	go = 1;
+	nanosleep(&ts_dur, NULL);
+	stop = 1;
+
+	for (i = 0; i < nthreads; i++)
+	{
+		ret = pthread_join(w[i].th, NULL);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to join a contender thread");  }
+	}
+	mes_now(&ts_fin);
+
+	for (i = 0; i < nthreads; i++)
+	{
+		total += w[i].ops;
+		if ((i == 0) || (w[i].ops < min))
+			min = w[i].ops;
+		if ((i == 0) || (w[i].ops > max))
+			max = w[i].ops;
+	}
+
+	*fair = max ? (double) min / max : 0;
+	return total / (mes_elapsed_us(&ts_ref, &ts_fin) / 1000000);
+}
+
+void usage(char * name)
+{
+	fprintf(stderr, "Usage: %s [-t threads] [-c cs_length] [-d ms] [-n samples] [-P] [-s pattern]\n", name);
+	exit(PTS_UNRESOLVED);
+}
+
+int main(int argc, char * argv[])
+{
+	pthread_mutexattr_t ma;
+	struct worker * w;
+	long pshared, nth;
+	double ns, pairs, fair;
+	char descr[128];
+	int ret, opt;
+	unsigned int sc, pr;
+
+	output_init();
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpus < 1)
+		ncpus = 1;
+	max_threads = 2 * ncpus;
+
+	while ((opt = getopt(argc, argv, "t:c:d:n:Ps:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': max_threads = atol(optarg); break;
+			case 'c': cs_length = atol(optarg); break;
+			case 'd': duration_ms = atol(optarg); break;
+			case 'n': handoff_samples = atol(optarg); break;
+			case 'P': pinning = 1; break;
+			case 's': only = optarg; break;
+			default: usage(argv[0]);
+		}
+	}
+	if ((max_threads < 1) || (cs_length < 0) || (duration_ms < 1) || (handoff_samples < 1))
+		usage(argv[0]);
+
+	w = calloc(max_threads, sizeof(*w));
+	if (w == NULL)
+	{  UNRESOLVED(errno, "Not enough memory for thread storage");  }
+
+	pshared = sysconf(_SC_THREAD_PROCESS_SHARED);
+
+	#if VERBOSE > 0
+	output("Mutex benchmark: %ld CPUs, up to %ld threads, critical section %ld, %ld ms per measure%s\n",
+		ncpus, max_threads, cs_length, duration_ms, pinning ? ", pinned" : "");
+	#endif
+
+	for (sc = 0; sc < NSCENAR; sc++)
+	{
+		if (scenarii[sc].m_pshared && (pshared <= 0))
+			continue;
+
+		for (pr = 0; pr < NPROTOCOLS; pr++)
+		{
+			if (protocols[pr].sc_name && (sysconf(protocols[pr].sc_name) <= 0))
+				continue;
+
+			snprintf(descr, sizeof(descr), "%s/%s", scenarii[sc].descr, protocols[pr].descr);
+			if (only && !strstr(descr, only))
+				continue;
+
+			/* Initialize the mutex */
+			ret = pthread_mutexattr_init(&ma);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to initialize the mutex attribute object");  }
+
+			#ifndef WITHOUT_XOPEN
+			ret = pthread_mutexattr_settype(&ma, scenarii[sc].m_type);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to set mutex type");  }
+			#endif
+
+			if (scenarii[sc].m_pshared)
+			{
+				ret = pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+				if (ret != 0)
+				{  UNRESOLVED(ret, "Unable to set the mutex process-shared");  }
+			}
+
+			ret = pthread_mutexattr_setprotocol(&ma, protocols[pr].protocol);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to set the mutex protocol");  }
+
+			#ifdef _POSIX_THREAD_PRIO_PROTECT
+			if (protocols[pr].protocol == PTHREAD_PRIO_PROTECT)
+			{
+				ret = pthread_mutexattr_setprioceiling(&ma, sched_get_priority_max(SCHED_FIFO));
+				if (ret != 0)
+				{  UNRESOLVED(ret, "Unable to set the mutex priority ceiling");  }
+			}
+			#endif
+
+			ret = pthread_mutex_init(&mtx, &ma);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to initialize the mutex");  }
+
+			ret = pthread_mutexattr_destroy(&ma);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to destroy the mutex attribute object");  }
+
+			/* Run the measures */
+			output("-----\n");
+			ns = uncontended();
+			if (ns < 0)
+			{
+				/* e.g. EPERM: not allowed to be boosted to the priority ceiling */
+				output("%s: skipped, lock/unlock failed with error %d (%s)\n",
+					descr, (int) -ns, strerror((int) -ns));
+			}
+			else
+			{
+				output("%s: uncontended %.1f ns per lock/unlock\n", descr, ns);
+
+				measure_handoff();
+				output("%s: handoff p50 %.3f us, p99 %.3f us, max %.3f us\n", descr,
+					mes_hist_percentile(&handoff_hist, 50) / 1e3,
+					mes_hist_percentile(&handoff_hist, 99) / 1e3,
+					mes_hist_percentile(&handoff_hist, 100) / 1e3);
+
+				output("%s: %8s %14s %9s\n", descr, "threads", "pairs/s", "fairness");
+				for (nth = 1; ; nth = (2 * nth < max_threads) ? 2 * nth : max_threads)
+				{
+					pairs = measure_throughput(nth, w, &fair);
+					output("%s: %8ld %14.0f %9.3f\n", descr, nth, pairs, fair);
+					if (nth == max_threads)
+						break;
+				}
+			}
+
+			ret = pthread_mutex_destroy(&mtx);
+			if (ret != 0)
+			{  UNRESOLVED(ret, "Unable to destroy the mutex");  }
+		}
+	}
+
+	free(w);
+
+	#if VERBOSE > 0
+	output("-----\n");
+	output("Benchmark completed\n");
+	#endif
+
+	PASSED;
+}
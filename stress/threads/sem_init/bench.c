@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+ * This file is licensed under the GPL license.  For the full content
+ * of this license, see the COPYING file at the top level of this
+ * source tree.
+ *
+ * This file is a benchmark for the sem_post and sem_wait functions.
+ * Where s-c1.c checks how many semaphores can be initialized, this program
+ * measures how fast a semaphore hands the control over to a waiter, for:
+ *  -> an unnamed semaphore shared between the threads of a process
+ *     (sem_init with pshared 0);
+ *  -> an unnamed semaphore in a MAP_SHARED mapping, shared between two
+ *     processes (sem_init with pshared 1);
+ *  -> a named semaphore (sem_open), opened by name in both processes;
+ * with the two peers on:
+ *  -> any CPU, as the scheduler sees fit;
+ *  -> the same CPU;
+ *  -> two SMT siblings of the same core;
+ *  -> two cores of the same package;
+ *  -> two packages,
+ * as far as the machine has such CPUs (Linux; elsewhere only the first
+ * placement is run).
+
+ * The steps are, for each semaphore and placement:
+ * -> ping-pong: each peer posts the semaphore the other one waits on, in
+ *    turn.  The round trips per second are reported, and the time of one
+ *    round trip, i.e. two sem_post to sem_wait handoffs.
+ * -> wake: the peer blocks in sem_wait; the main thread posts the
+ *    semaphore.  The latency from the sem_post call to the return of
+ *    sem_wait in the peer is reported as p50, p99 and max.
+
+ * Options:
+ *  -r n   number of ping-pong round trips (default 50000)
+ *  -n n   number of wake samples (default 2000)
+ *  -s str only run the cases whose description contains str
+
+ * The benchmark only reports numbers; it is UNRESOLVED when a semaphore
+ * cannot be set up and PASSED otherwise.
+ */
+
+ /* We are testing conformance to IEEE Std 1003.1, 2003 Edition */
+ #define _POSIX_C_SOURCE 200112L
+
+#ifdef __linux__
+ #define _GNU_SOURCE	/* pthread_setaffinity_np() */
+#endif
+
+/********************************************************************************************/
+/****************************** standard includes *****************************************/
+/********************************************************************************************/
+ #include <pthread.h>
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <sched.h>
+ #include <semaphore.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <stdarg.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/wait.h>
+
+ #include "measure.h"
+
+/********************************************************************************************/
+/******************************   Test framework   *****************************************/
+/********************************************************************************************/
+ #include "testfrmw.h"
+ /* This header is responsible for defining the following macros:
+  * UNRESOLVED(ret, descr);
+  *    where descr is a description of the error and ret is an int (error code for example)
+  * FAILED(descr);
+  *    where descr is a short text saying why the test has failed.
+  * PASSED();
+  *    No parameter.
+  *
+  * Both three macros shall terminate the calling process.
+  * The testcase shall not terminate in any other maneer.
+  *
+  * It also declares the functions, which lib/testfrmw.c defines:
+  * void output_init()
+  * void output(char * string, ...)
+  *
+  * Those may be used to output information.
+  */
+
+/********************************************************************************************/
+/********************************** Configuration ******************************************/
+/********************************************************************************************/
+#ifndef VERBOSE
+#define VERBOSE 1
+#endif
+
+/* Round trips run before the ping-pong is timed */
+#define WARMUP_DIVISOR 10
+
+/********************************************************************************************/
+/***********************************    Test case   *****************************************/
+/********************************************************************************************/
+
+struct _scenar
+{
+	int pshared; /* 0: between threads ~ 1: between processes */
+	int named; /* 1: sem_open, else sem_init */
+	char * descr; /* Case description */
+}
+scenarii[] =
+{
+	 {0, 0, "Unnamed private"}
+	,{1, 0, "Unnamed pshared"}
+	,{1, 1, "Named"}
+};
+#define NSCENAR (sizeof(scenarii)/sizeof(scenarii[0]))
+
+/* Where the main thread and its peer run; -1 is any CPU */
+struct _placement
+{
+	long cpu_main;
+	long cpu_peer;
+	char * descr;
+}
+placements[5];
+int nplacements = 0;
+
+/* Options */
+long rounds = 50000;
+long wake_samples = 2000;
+char * only = NULL;
+
+#ifdef __linux__
+cpu_set_t allowed; /* our affinity at startup */
+#endif
+
+/* Shared with the peer, in a MAP_SHARED mapping so that a forked peer
+ * sees it as well */
+struct shared
+{
+	sem_t sem_ping; /* posted by the main thread */
+	sem_t sem_pong; /* posted by the peer */
+	struct timespec ts_post;
+	struct mes_hist wake_hist;
+} * shm;
+
+/* The semaphores in use: in *shm, or named */
+sem_t * ping, * pong;
+char name_ping[64], name_pong[64];
+
+
+void pin(long cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int ret;
+
+	if (cpu < 0)
+	{
+		set = allowed;
+	}
+	else
+	{
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+	}
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Unable to pin a thread");  }
+#else
+	(void) cpu;
+#endif
+}
+
+#ifdef __linux__
+/* A topology id of a CPU (core_id, physical_package_id), -1 if unknown */
+long topology(long cpu, char * what)
+{
+	char path[128];
+	FILE * fp;
+	long id = -1;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/topology/%s", cpu, what);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return -1;
+	if (fscanf(fp, "%ld", &id) != 1)
+		id = -1;
+	fclose(fp);
+	return id;
+}
+#endif
+
+/* Pick a pair of CPUs for each placement the machine has */
+void find_placements(void)
+{
+#ifdef __linux__
+	long first = -1, sibling = -1, core = -1, package = -1, cpu;
+	long core0 = -1, package0 = -1;
+#endif
+
+	placements[nplacements].cpu_main = -1;
+	placements[nplacements].cpu_peer = -1;
+	placements[nplacements++].descr = "any CPU";
+
+#ifdef __linux__
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+	{  UNRESOLVED(errno, "Unable to read the CPU affinity");  }
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (!CPU_ISSET(cpu, &allowed))
+			continue;
+		if (first < 0)
+		{
+			first = cpu;
+			core0 = topology(cpu, "core_id");
+			package0 = topology(cpu, "physical_package_id");
+			continue;
+		}
+		if (topology(cpu, "physical_package_id") != package0)
+		{
+			if (package < 0)
+				package = cpu;
+		}
+		else if ((core0 >= 0) && (topology(cpu, "core_id") == core0))
+		{
+			if (sibling < 0)
+				sibling = cpu;
+		}
+		else if (core < 0)
+		{
+			core = cpu;
+		}
+	}
+
+	placements[nplacements].cpu_main = first;
+	placements[nplacements].cpu_peer = first;
+	placements[nplacements++].descr = "same CPU";
+	if (sibling >= 0)
+	{
+		placements[nplacements].cpu_main = first;
+		placements[nplacements].cpu_peer = sibling;
+		placements[nplacements++].descr = "SMT siblings";
+	}
+	if (core >= 0)
+	{
+		placements[nplacements].cpu_main = first;
+		placements[nplacements].cpu_peer = core;
+		placements[nplacements++].descr = "other core";
+	}
+	if (package >= 0)
+	{
+		placements[nplacements].cpu_main = first;
+		placements[nplacements].cpu_peer = package;
+		placements[nplacements++].descr = "other package";
+	}
+#endif
+}
+
+/* sem_wait, again when interrupted; returns 0 or the error code */
+int wait_sem(sem_t * sem)
+{
+	while (sem_wait(sem) != 0)
+	{
+		if (errno != EINTR)
+			return errno;
+	}
+	return 0;
+}
+
+/* The peer: answers the ping-pong, then times its wakeups */
+void peer(long cpu)
+{
+	struct timespec ts_wake;
+	long i;
+	int ret;
+
+	pin(cpu);
+
+	if (sem_post(pong) != 0)
+	{  UNRESOLVED(errno, "Peer failed to post the semaphore");  }
+
+	for (i = 0; i < rounds + rounds / WARMUP_DIVISOR; i++)
+	{
+		ret = wait_sem(ping);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Peer failed to wait for the semaphore");  }
+		if (sem_post(pong) != 0)
+		{  UNRESOLVED(errno, "Peer failed to post the semaphore");  }
+	}
+
+	for (i = 0; i < wake_samples; i++)
+	{
+		ret = wait_sem(ping);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Peer failed to wait for the semaphore");  }
+		mes_now(&ts_wake);
+
+		/* ts_post was written before the post which woke us up */
+		mes_hist_record(&shm->wake_hist, mes_elapsed_ns(&shm->ts_post, &ts_wake));
+
+		if (sem_post(pong) != 0)
+		{  UNRESOLVED(errno, "Peer failed to post the semaphore");  }
+	}
+}
+
+void * peer_thread(void * arg)
+{
+	peer(*(long *) arg);
+	return NULL;
+}
+
+/* Set up ping and pong for the scenario, in the main process */
+void sems_init(struct _scenar * sc)
+{
+	if (!sc->named)
+	{
+		if (sem_init(&shm->sem_ping, sc->pshared, 0) != 0)
+		{  UNRESOLVED(errno, "Unable to initialize the semaphore");  }
+		if (sem_init(&shm->sem_pong, sc->pshared, 0) != 0)
+		{  UNRESOLVED(errno, "Unable to initialize the semaphore");  }
+		ping = &shm->sem_ping;
+		pong = &shm->sem_pong;
+		return;
+	}
+
+	snprintf(name_ping, sizeof(name_ping), "/pts_sem_bench_ping_%d", (int) getpid());
+	snprintf(name_pong, sizeof(name_pong), "/pts_sem_bench_pong_%d", (int) getpid());
+	ping = sem_open(name_ping, O_CREAT | O_EXCL, 0600, 0);
+	if (ping == SEM_FAILED)
+	{  UNRESOLVED(errno, "Unable to create the named semaphore");  }
+	pong = sem_open(name_pong, O_CREAT | O_EXCL, 0600, 0);
+	if (pong == SEM_FAILED)
+	{  UNRESOLVED(errno, "Unable to create the named semaphore");  }
+}
+
+/* In the forked peer, open the named semaphores by name as a separate
+ * program would */
+void sems_reopen(struct _scenar * sc)
+{
+	if (!sc->named)
+		return;
+
+	if ((sem_close(ping) != 0) || (sem_close(pong) != 0))
+	{  UNRESOLVED(errno, "Peer failed to close the inherited semaphores");  }
+	ping = sem_open(name_ping, 0);
+	if (ping == SEM_FAILED)
+	{  UNRESOLVED(errno, "Peer failed to open the named semaphore");  }
+	pong = sem_open(name_pong, 0);
+	if (pong == SEM_FAILED)
+	{  UNRESOLVED(errno, "Peer failed to open the named semaphore");  }
+}
+
+void sems_destroy(struct _scenar * sc)
+{
+	if (!sc->named)
+	{
+		if ((sem_destroy(ping) != 0) || (sem_destroy(pong) != 0))
+		{  UNRESOLVED(errno, "Unable to destroy the semaphores");  }
+		return;
+	}
+
+	if ((sem_close(ping) != 0) || (sem_close(pong) != 0))
+	{  UNRESOLVED(errno, "Unable to close the named semaphores");  }
+	if ((sem_unlink(name_ping) != 0) || (sem_unlink(name_pong) != 0))
+	{  UNRESOLVED(errno, "Unable to unlink the named semaphores");  }
+}
+
+/* Returns the round trips per second */
+double measure_pingpong(void)
+{
+	struct timespec ts_ref, ts_fin;
+	long i;
+	int ret;
+
+	for (i = 0; i < rounds / WARMUP_DIVISOR; i++)
+	{
+		if (sem_post(ping) != 0)
+		{  UNRESOLVED(errno, "Unable to post the semaphore");  }
+		ret = wait_sem(pong);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to wait for the semaphore");  }
+	}
+
+	mes_now(&ts_ref);
+	for (i = 0; i < rounds; i++)
+	{
+		if (sem_post(ping) != 0)
+		{  UNRESOLVED(errno, "Unable to post the semaphore");  }
+		ret = wait_sem(pong);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to wait for the semaphore");  }
+	}
+	mes_now(&ts_fin);
+
+	return rounds / (mes_elapsed_us(&ts_ref, &ts_fin) / 1000000);
+}
+
+void measure_wake(void)
+{
+	struct timespec ts_wait = { 0, 100000 }; /* let the peer block */
+	long i;
+	int ret;
+
+	for (i = 0; i < wake_samples; i++)
+	{
+		nanosleep(&ts_wait, NULL);
+
+		mes_now(&shm->ts_post);
+		if (sem_post(ping) != 0)
+		{  UNRESOLVED(errno, "Unable to post the semaphore");  }
+
+		ret = wait_sem(pong);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to wait for the semaphore");  }
+	}
+}
+
+void run(struct _scenar * sc, struct _placement * pl, char * descr)
+{
+	pthread_t th;
+	pid_t child = 0;
+	double trips;
+	int ret, status;
+
+	sems_init(sc);
+	mes_hist_init(&shm->wake_hist);
+	pin(pl->cpu_main);
+
+	if (!sc->pshared)
+	{
+		ret = pthread_create(&th, NULL, peer_thread, &pl->cpu_peer);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to create the peer thread");  }
+	}
+	else
+	{
+		child = fork();
+		if (child == -1)
+		{  UNRESOLVED(errno, "Unable to fork the peer process");  }
+		if (child == 0)
+		{
+			sems_reopen(sc);
+			peer(pl->cpu_peer);
+			_exit(PTS_PASS);
+		}
+	}
+
+	/* The peer is ready */
+	ret = wait_sem(pong);
+	if (ret != 0)
+	{  UNRESOLVED(ret, "Unable to wait for the semaphore");  }
+
+	trips = measure_pingpong();
+	measure_wake();
+
+	if (!sc->pshared)
+	{
+		ret = pthread_join(th, NULL);
+		if (ret != 0)
+		{  UNRESOLVED(ret, "Unable to join the peer thread");  }
+	}
+	else
+	{
+		if (waitpid(child, &status, 0) != child)
+		{  UNRESOLVED(errno, "Unable to wait for the peer process");  }
+		if (!WIFEXITED(status) || (WEXITSTATUS(status) != PTS_PASS))
+		{  UNRESOLVED(status, "The peer process failed");  }
+	}
+
+	sems_destroy(sc);
+
+	output("%s: ping-pong %.0f round trips/s (%.0f ns each)\n", descr,
+		trips, 1e9 / trips);
+	output("%s: wake p50 %.3f us, p99 %.3f us, max %.3f us\n", descr,
+		mes_hist_percentile(&shm->wake_hist, 50) / 1e3,
+		mes_hist_percentile(&shm->wake_hist, 99) / 1e3,
+		mes_hist_percentile(&shm->wake_hist, 100) / 1e3);
+}
+
+void usage(char * name)
+{
+	fprintf(stderr, "Usage: %s [-r rounds] [-n samples] [-s pattern]\n", name);
+	exit(PTS_UNRESOLVED);
+}
+
+int main(int argc, char * argv[])
+{
+	char descr[128];
+	unsigned int sc;
+	int pl, opt;
+
+	output_init();
+
+	while ((opt = getopt(argc, argv, "r:n:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': rounds = atol(optarg); break;
+			case 'n': wake_samples = atol(optarg); break;
+			case 's': only = optarg; break;
+			default: usage(argv[0]);
+		}
+	}
+	if ((rounds < 1) || (wake_samples < 1))
+		usage(argv[0]);
+
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shm == MAP_FAILED)
+	{  UNRESOLVED(errno, "Unable to map the shared memory");  }
+
+	find_placements();
+
+	#if VERBOSE > 0
+	output("Semaphore benchmark: %ld CPUs, %ld round trips, %ld wake samples\n",
+		sysconf(_SC_NPROCESSORS_ONLN), rounds, wake_samples);
+	#endif
+
+	for (sc = 0; sc < NSCENAR; sc++)
+	{
+		for (pl = 0; pl < nplacements; pl++)
+		{
+			snprintf(descr, sizeof(descr), "%s/%s", scenarii[sc].descr, placements[pl].descr);
+			if (only && !strstr(descr, only))
+				continue;
+
+			output("-----\n");
+			run(&scenarii[sc], &placements[pl], descr);
+		}
+	}
+
+	pin(-1);
+	munmap(shm, sizeof(*shm));
+
+	#if VERBOSE > 0
+	output("-----\n");
+	output("Benchmark completed\n");
+	#endif
+
+	PASSED;
+}
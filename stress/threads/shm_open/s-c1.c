@@ -0,0 +1,386 @@
+/*
+* Copyright (c) 2026, Open POSIX Test Suite contributors. All rights reserved.
+* This file is licensed under the GPL license.  For the full content
+* of this license, see the COPYING file at the top level of this
+* source tree.
+
+
+* This scalability sample aims to test the following assertions:
+*  -> The shm_open() duration does not depend on the # of shared memory
+*     objects in the system, whether it creates one or opens an existing one
+*  -> The shm_unlink() duration does not depend on the # of shared memory
+*     objects
+
+* The steps are:
+* -> Create empty objects until failure or the max load, by blocks. After
+*    each block, open as many existing objects, picked at random, by name.
+*    The objects are closed once created or opened: only their names stay.
+* -> Unlink the objects, last block first.
+
+* The test fails if one of these durations tends to grow with the # of objects,
+* or if the failure at last object creation is unexpected.
+*/
+
+
+/* We are testing conformance to IEEE Std 1003.1, 2003 Edition */
+#define _POSIX_C_SOURCE 200112L
+
+/********************************************************************************************/
+/****************************** standard includes *****************************************/
+/********************************************************************************************/
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "measure.h"
+
+/********************************************************************************************/
+/******************************   Test framework   *****************************************/
+/********************************************************************************************/
+#include "testfrmw.h"
+/* This header is responsible for defining the following macros:
+ * UNRESOLVED(ret, descr);
+ *    where descr is a description of the error and ret is an int (error code for example)
+ * FAILED(descr);
+ *    where descr is a short text saying why the test has failed.
+ * PASSED();
+ *    No parameter.
+ *
+ * Both three macros shall terminate the calling process.
+ * The testcase shall not terminate in any other maneer.
+ *
+ * It also declares the functions, which lib/testfrmw.c defines:
+ * void output_init()
+ * void output(char * string, ...)
+ *
+ * Those may be used to output information.
+ */
+
+/********************************************************************************************/
+/********************************** Configuration ******************************************/
+/********************************************************************************************/
+#ifndef SCALABILITY_FACTOR
+#define SCALABILITY_FACTOR 1
+#endif
+#ifndef VERBOSE
+#define VERBOSE 1
+#endif
+
+#ifdef PLOT_OUTPUT
+#define PLOT 1
+#else
+#define PLOT 0
+#endif
+
+/* The above are only the defaults, see mes_getopt() in measure.h */
+
+#define BLOCKSIZE ( mes_opt.resolution ? mes_opt.resolution : 100 * mes_opt.scale )
+
+/********************************************************************************************/
+/***********************************       Test     *****************************************/
+/********************************************************************************************/
+
+/* The measures are saved in a mes_set (see measure.h), one row per block of
+ * BLOCKSIZE objects: series 0 is the duration of the shm_open calls which create
+ * the objects, series 1 of those which open existing ones, series 2 of shm_unlink */
+
+static const char * const series[] = { "shm_open", "lookup", "shm_unlink" };
+
+#define ANALYSIS_OUTPUT ( mes_opt.verbose > 1 ? output : NULL )
+
+static char shm_name[ 255 ];
+
+/* Durations of the calls of a block, in us */
+static double * durations;
+
+static const char * name_of( int n )
+{
+	sprintf( shm_name, "/shm_open_scal_%d_%d", ( int ) getpid(), n );
+	return shm_name;
+}
+
+static int cmp_double( const void * a, const void * b )
+{
+	double x = *( const double * ) a, y = *( const double * ) b;
+
+	return ( x > y ) - ( x < y );
+}
+
+/* The duration of a block of n calls, from the median call: a few calls
+ * interrupted by the scheduler would otherwise drown the trend, and they
+ * are in the latency histograms anyway */
+static double block_us( int n )
+{
+	qsort( durations, n, sizeof( double ), cmp_double );
+	return durations[ n / 2 ] * n;
+}
+
+/* Test routine */
+int main ( int argc, char *argv[] )
+{
+	int ret, status, locerrno;
+	int nobj, fd, i, k;
+	unsigned int seed = 1;
+	long my_max;
+
+	struct timespec ts_op, ts_op_fin;
+	struct mes_set measures;
+	struct mes_levels tails_open, tails_lookup, tails_unlink;
+
+	/* Initialize output routine */
+	output_init();
+
+	/* Read the load and the verbosity */
+	if ( mes_getopt( argc, argv, SCALABILITY_FACTOR, VERBOSE, PLOT ) != 0 )
+	{
+		UNRESOLVED( EINVAL, "Bad options" );
+	}
+
+	my_max = 10000 * mes_opt.scale;
+
+	if ( mes_opt.max > 0 )
+		my_max = mes_opt.max;
+
+	/* Initialize the measure storage: every sample is allocated now */
+	ret = mes_init( &measures, 3, my_max / BLOCKSIZE + 1 );
+
+	if ( ret != 0 )
+	{
+		UNRESOLVED( ret, "Not enough memory for measure storage" );
+	}
+
+	/* Each call also goes in the latency histogram of its tenth of my_max */
+	ret = mes_levels_init( &tails_open, ( my_max + 9 ) / 10, 10 );
+
+	if ( ret == 0 )
+		ret = mes_levels_init( &tails_lookup, ( my_max + 9 ) / 10, 10 );
+
+	if ( ret == 0 )
+		ret = mes_levels_init( &tails_unlink, ( my_max + 9 ) / 10, 10 );
+
+	if ( ret != 0 )
+	{
+		UNRESOLVED( ret, "Not enough memory for latency histograms" );
+	}
+
+	durations = ( double * ) malloc( BLOCKSIZE * sizeof( double ) );
+
+	if ( durations == NULL )
+	{
+		UNRESOLVED( errno, "Not enough memory for the durations of a block" );
+	}
+
+	if ( mes_opt.verbose > 1 )
+		output( "max load: %ld\n", my_max );
+
+	if ( mes_opt.plot )
+		output( "# COLUMNS 4 Objects shm_open lookup shm_unlink\n" );
+
+	nobj = 0;
+	status = 0;
+	locerrno = 0;
+
+	while ( 1 )                                                                                                                          /* we will break */
+	{
+		/* Create the objects of the block */
+		for ( i = 0; i < BLOCKSIZE; i++ )
+		{
+			name_of( nobj );
+			mes_now( &ts_op );
+			fd = shm_open( shm_name, O_CREAT | O_EXCL | O_RDWR, 0600 );
+			mes_now( &ts_op_fin );
+
+			if ( fd == -1 )
+			{
+				if ( mes_opt.verbose > 0 )
+					output( "shm_open failed with error %d (%s)\n", errno, strerror( errno ) );
+				/* Check error code */
+				locerrno = errno;
+
+				if ( ( errno == EMFILE ) || ( errno == ENFILE ) || ( errno == ENOSPC ) || ( errno == ENOMEM ) )
+				{
+					status = 2;
+				}
+				else
+				{
+					UNRESOLVED( errno, "Unexpected error!" );
+				}
+
+				break;
+			}
+
+			durations[ i ] = mes_elapsed_us( &ts_op, &ts_op_fin );
+			mes_levels_record( &tails_open, nobj, mes_elapsed_ns( &ts_op, &ts_op_fin ) );
+
+			ret = close( fd );
+
+			if ( ret != 0 )
+			{
+				UNRESOLVED( errno, "Failed to close an object" );
+			}
+
+			nobj++;
+		}
+
+		if ( status == 2 )
+		{
+			/* We were not able to fill this bloc, so we can discard it */
+
+			for ( --i; i >= 0; i-- )
+			{
+				nobj--;
+				ret = shm_unlink( name_of( nobj ) );
+
+				if ( ret != 0 )
+				{
+					UNRESOLVED( errno, "Failed to unlink" );
+				}
+			}
+
+			break;
+		}
+
+		/* add to the measures */
+		mes_record( &measures, nobj, 0, block_us( BLOCKSIZE ) );
+
+		/* Open as many existing objects by name */
+
+		for ( i = 0; i < BLOCKSIZE; i++ )
+		{
+			k = rand_r( &seed ) % nobj;
+
+			name_of( k );
+			mes_now( &ts_op );
+			fd = shm_open( shm_name, O_RDONLY, 0 );
+			mes_now( &ts_op_fin );
+
+			if ( fd == -1 )
+			{
+				UNRESOLVED( errno, "Failed to open an existing object" );
+			}
+
+			durations[ i ] = mes_elapsed_us( &ts_op, &ts_op_fin );
+			mes_levels_record( &tails_lookup, nobj, mes_elapsed_ns( &ts_op, &ts_op_fin ) );
+
+			ret = close( fd );
+
+			if ( ret != 0 )
+			{
+				UNRESOLVED( errno, "Failed to close an object" );
+			}
+		}
+
+		mes_record( &measures, nobj, 1, block_us( BLOCKSIZE ) );
+
+		if ( nobj + BLOCKSIZE > my_max )
+			break;
+	}
+
+	/* Unlink all the objects, block by block */
+	if ( mes_opt.verbose > 0 )
+		output( "Unlinking %d objects\n", nobj );
+
+	while ( nobj > 0 )
+	{
+		/* the row of the block, if it was recorded */
+		k = nobj;
+
+		for ( i = 0; i < BLOCKSIZE; i++ )
+		{
+			nobj--;
+			name_of( nobj );
+			mes_now( &ts_op );
+			ret = shm_unlink( shm_name );
+			mes_now( &ts_op_fin );
+
+			if ( ret != 0 )
+			{
+				UNRESOLVED( errno, "Failed to unlink an object" );
+			}
+
+			durations[ i ] = mes_elapsed_us( &ts_op, &ts_op_fin );
+			mes_levels_record( &tails_unlink, nobj + 1, mes_elapsed_ns( &ts_op, &ts_op_fin ) );
+		}
+
+		mes_record( &measures, k, 2, block_us( BLOCKSIZE ) );
+	}
+
+
+	if ( mes_opt.verbose > 0 )
+		output( "Parse results\n" );
+
+	/* Compute the results */
+	ret = mes_analyze( &measures, series, ANALYSIS_OUTPUT );
+
+
+	/* Free the resources and output the results */
+
+	if ( mes_opt.verbose > 5 )
+	{
+		output( "Dump : \n" );
+
+		output( "  nobj  |  open  | lookup | unlink \n" );
+	}
+
+	if ( mes_opt.verbose > 5 || mes_opt.plot )
+	{
+		for ( i = 0; i < ( int ) measures.n; i++ )
+		{
+			output( "%8.8li %.6f %.6f %.6f\n"
+			        , measures.x[ i ]
+			        , MES_Y( &measures, i, 0 ) / 1000000
+			        , MES_Y( &measures, i, 1 ) / 1000000
+			        , MES_Y( &measures, i, 2 ) / 1000000
+			      );
+		}
+	}
+	mes_fini( &measures );
+
+	if ( mes_opt.verbose > 0 )
+	{
+		mes_levels_print( &tails_open, "shm_open", output );
+
+		mes_levels_print( &tails_lookup, "lookup", output );
+
+		mes_levels_print( &tails_unlink, "shm_unlink", output );
+	}
+	mes_levels_fini( &tails_open );
+
+	mes_levels_fini( &tails_lookup );
+
+	mes_levels_fini( &tails_unlink );
+
+	free( durations );
+
+
+	if ( ret != 0 )
+	{
+		FAILED( "The function is not scalable, add verbosity for more information" );
+	}
+
+	/* Check status */
+	if ( status )
+	{
+		UNRESOLVED( locerrno, "Function is scalable, but test terminated with error" );
+	}
+
+
+	if ( mes_opt.verbose > 0 )
+	{
+		output( "-----\n" );
+
+		output( "All test data destroyed\n" );
+
+		output( "Test PASSED\n" );
+	}
+
+	PASSED;
+}